@@ -1,9 +1,16 @@
 #version 460
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) out vec4 outColor;
-layout(binding = 0) uniform sampler2D texSampler;
+layout(binding = 0) uniform sampler textureSampler;
+// every texture the world uses, bound once per frame, slots past the ones in use are left unwritten
+layout(binding = 1) uniform texture2D textures[];
 layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) in vec3 fragColor;
+layout(location = 3) flat in uint fragTexture;
 
 void main() {
-    outColor = texture(texSampler, fragTexCoord);
-}
\ No newline at end of file
+    // neighboring faces of one draw can use different textures
+    outColor = texture(sampler2D(textures[nonuniformEXT(fragTexture)], textureSampler), fragTexCoord) *
+               vec4(fragColor, 1.0);
+}
@@ -1,10 +1,80 @@
 #version 460
 #extension GL_EXT_buffer_reference : require
 
-layout(location = 0) in vec2 inPosition;
 layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) out vec3 fragColor;
+layout(location = 3) flat out uint fragTexture;
+
+// two packed uints per vertex, see MeshVertex in mesher.h
+layout(buffer_reference, std430, buffer_reference_align = 8) readonly buffer VertexBuffer {
+    uvec2 vertices[];
+};
+
+// ChunkDrawInfo in main.c, only the origin is needed here
+struct ChunkDrawInfo {
+    vec3 origin;
+    uint indexCount;
+    vec3 boundsMin;
+    uint firstIndex;
+    vec3 boundsMax;
+    int vertexOffset;
+};
+
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer ChunkDrawInfos {
+    ChunkDrawInfo chunks[];
+};
+
+// BlockTextures in main.c, the texture index of every face of a block and the tint they are multiplied with
+struct BlockTextures {
+    uint textures[6];
+    uint tint;
+    uint padding;
+};
+
+// indexed by texture layer
+layout(buffer_reference, std430, buffer_reference_align = 4) readonly buffer BlockTextureTable {
+    BlockTextures blocks[];
+};
+
+layout(push_constant) uniform PushConstants {
+    mat4 viewProjection;
+    ChunkDrawInfos chunkInfos;
+    VertexBuffer vertexBuffer;
+    BlockTextureTable blockTextures;
+};
+
+// indexed by face, -x +x -y +y -z +z
+const float faceShades[6] = float[](0.7, 0.8, 0.5, 1.0, 0.6, 0.9);
+// indexed by ambient occlusion, 0 for an open corner
+const float occlusionShades[4] = float[](1.0, 0.8, 0.6, 0.45);
+// every light level is 80% of the one above it, sky light is white and block light warm, neither goes fully dark
+const vec3 blockLightColor = vec3(1.0, 0.8, 0.55);
+const float ambientLight = 0.04;
+
+vec3 lightColor(uint skyLight, uint blockLight) {
+    float sky = pow(0.8, float(15u - skyLight));
+    float block = pow(0.8, float(15u - blockLight));
+    return max(max(vec3(sky), block * blockLightColor), vec3(ambientLight));
+}
 
 void main() {
-    gl_Position = vec4(inPosition, 0.0, 1.0);
-    fragTexCoord = inPosition * 0.5 + 0.5;
-}
\ No newline at end of file
+    uvec2 packedVertex = vertexBuffer.vertices[gl_VertexIndex];
+    uint vertex = packedVertex.x;
+    // cull.comp puts the chunk index into firstInstance, gl_VertexIndex already includes the chunk vertex offset
+    vec3 chunkOrigin = chunkInfos.chunks[gl_InstanceIndex].origin;
+    vec3 position = chunkOrigin + vec3(vertex & 63u, (vertex >> 6) & 63u, (vertex >> 12) & 63u);
+    uint face = (vertex >> 18) & 7u;
+    uint occlusion = (vertex >> 21) & 3u;
+    uint layer = vertex >> 23;
+    uint skyLight = packedVertex.y & 15u;
+    uint blockLight = (packedVertex.y >> 4) & 15u;
+
+    gl_Position = viewProjection * vec4(position, 1.0);
+    // the texture repeats once per voxel along the two axes spanning the face
+    uint axis = face >> 1;
+    fragTexCoord = axis == 0u ? position.zy : axis == 1u ? position.xz : position.xy;
+    BlockTextures block = blockTextures.blocks[layer];
+    fragColor = unpackUnorm4x8(block.tint).rgb * faceShades[face] * occlusionShades[occlusion] *
+                lightColor(skyLight, blockLight);
+    fragTexture = block.textures[face];
+}
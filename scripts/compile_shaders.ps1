@@ -5,6 +5,8 @@ if (Test-Path resources/shaders)
 mkdir -p resources/shaders
 glslc development_resources/shaders/shader.vert -o development_resources/shaders/shader.vert.spv
 glslc development_resources/shaders/shader.frag -o development_resources/shaders/shader.frag.spv
-spirv-link development_resources/shaders/shader.vert.spv development_resources/shaders/shader.frag.spv -o resources/shaders/shader.spv
+glslc development_resources/shaders/cull.comp -o development_resources/shaders/cull.comp.spv
+spirv-link development_resources/shaders/shader.vert.spv development_resources/shaders/shader.frag.spv development_resources/shaders/cull.comp.spv -o resources/shaders/shader.spv
 Remove-Item development_resources/shaders/shader.vert.spv
-Remove-Item development_resources/shaders/shader.frag.spv
\ No newline at end of file
+Remove-Item development_resources/shaders/shader.frag.spv
+Remove-Item development_resources/shaders/cull.comp.spv
\ No newline at end of file
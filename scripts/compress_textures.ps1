@@ -0,0 +1,8 @@
+param([string]$Encoder = "build/codoxel_texture_encoder")
+if (!(Test-Path resources/images))
+{
+    mkdir -p resources/images
+}
+Get-ChildItem development_resources/images -Filter *.png | ForEach-Object {
+    & $Encoder --bc7 $_.FullName resources/images/$($_.BaseName).ktx2
+}
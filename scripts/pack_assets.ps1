@@ -0,0 +1,4 @@
+param([string]$Packer = "build/codoxel_asset_packer")
+# run after compile_shaders.ps1 and compress_textures.ps1, the pack takes the place of the loose files at startup
+$Inputs = @(Get-ChildItem resources/shaders -Filter *.spv) + @(Get-ChildItem resources/images -Filter *.ktx2)
+& $Packer resources/assets.pack $Inputs.FullName
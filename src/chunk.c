@@ -0,0 +1,449 @@
+#include "chunk.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+constexpr uint32_t INITIAL_WORLD_CAPACITY = 256;
+constexpr uint32_t PALETTE_SCAN_LIMIT = 16;
+
+static size_t index_word_count(uint32_t const bits_per_index) {
+    return (size_t)CHUNK_VOLUME * bits_per_index / 64;
+}
+
+void chunk_init(Chunk *const chunk, int32_t const x, int32_t const y, int32_t const z, BlockId const block) {
+    *chunk = (Chunk){
+        .x = x,
+        .y = y,
+        .z = z,
+        .palette_count = 1,
+        .palette_capacity = 1,
+        .palette = malloc(sizeof(BlockId)),
+    };
+    chunk->palette[0] = block;
+}
+
+void chunk_free(Chunk *const chunk) {
+    free(chunk->palette);
+    free(chunk->palette_lookup);
+    free(chunk->indices);
+    free(chunk->light);
+    *chunk = (Chunk){};
+}
+
+static uint32_t hash_block(BlockId const block) { return block * 0x9E3779B1u; }
+
+// rebuilt whenever entries are replaced or reordered, small palettes are scanned instead
+static void rebuild_palette_lookup(Chunk *const chunk) {
+    free(chunk->palette_lookup);
+    chunk->palette_lookup = nullptr;
+    if (chunk->palette_capacity <= PALETTE_SCAN_LIMIT) return;
+
+    uint32_t const mask = chunk->palette_capacity * 2 - 1;
+    chunk->palette_lookup = calloc(chunk->palette_capacity * 2, sizeof(uint32_t));
+    for (uint32_t i = 0; i < chunk->palette_count; ++i) {
+        uint32_t slot = hash_block(chunk->palette[i]) & mask;
+        while (chunk->palette_lookup[slot]) slot = (slot + 1) & mask;
+        chunk->palette_lookup[slot] = i + 1;
+    }
+}
+
+static uint32_t find_palette_index(Chunk const *const chunk, BlockId const block) {
+    if (!chunk->palette_lookup) {
+        for (uint32_t i = 0; i < chunk->palette_count; ++i)
+            if (chunk->palette[i] == block) return i;
+        return UINT32_MAX;
+    }
+    uint32_t const mask = chunk->palette_capacity * 2 - 1;
+    for (uint32_t slot = hash_block(block) & mask; chunk->palette_lookup[slot]; slot = (slot + 1) & mask)
+        if (chunk->palette[chunk->palette_lookup[slot] - 1] == block) return chunk->palette_lookup[slot] - 1;
+    return UINT32_MAX;
+}
+
+static void set_palette_index(Chunk *const chunk, uint32_t const voxel_index, uint32_t const palette_index) {
+    uint32_t const bit = (voxel_index & ((1u << chunk->index_shift) - 1)) * chunk->bits_per_index;
+    uint64_t const mask = ((1ull << chunk->bits_per_index) - 1) << bit;
+    auto const word = &chunk->indices[voxel_index >> chunk->index_shift];
+    *word = (*word & ~mask) | (uint64_t)palette_index << bit;
+}
+
+// the palette index replicated into every field of a word
+static uint64_t replicate_index(uint32_t const palette_index, uint32_t const bits_per_index) {
+    uint64_t pattern = palette_index;
+    for (uint32_t width = bits_per_index; width < 64; width *= 2) pattern |= pattern << width;
+    return pattern;
+}
+
+// narrow indices are searched one palette entry at a time with a zero field test over whole words,
+// which stops at the first word that uses the entry, wider ones are read directly
+static void mark_used_palette_entries(Chunk const *const chunk, bool *const used) {
+    uint32_t const bits = chunk->bits_per_index;
+    size_t const word_count = index_word_count(bits);
+    if (bits >= 8) {
+        for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) used[chunk_get_palette_index(chunk, i)] = true;
+        return;
+    }
+
+    uint64_t const lowest_bits = replicate_index(1, bits);
+    for (uint32_t entry = 0; entry < chunk->palette_count; ++entry) {
+        uint64_t const pattern = replicate_index(entry, bits);
+        used[entry] = false;
+        for (size_t word = 0; word < word_count && !used[entry]; ++word) {
+            // fields equal to the entry become zero, folding each field onto its lowest bit finds them
+            uint64_t folded = chunk->indices[word] ^ pattern;
+            for (uint32_t shift = 1; shift < bits; shift *= 2) folded |= folded >> shift;
+            used[entry] = (folded & lowest_bits) != lowest_bits;
+        }
+    }
+}
+
+// rewrites every index at a new width, remap translates old palette indices when given
+// the old words are streamed field by field into whole new words, so no index is addressed individually
+static void repack(Chunk *const chunk, uint32_t const bits_per_index, uint16_t const *const remap) {
+    uint32_t const old_bits = chunk->bits_per_index;
+    uint64_t *const indices = bits_per_index ? calloc(index_word_count(bits_per_index), sizeof(uint64_t)) : nullptr;
+    if (bits_per_index && old_bits) {
+        uint64_t const old_mask = (1ull << old_bits) - 1;
+        uint64_t packed = 0;
+        uint32_t packed_bits = 0;
+        size_t packed_word = 0;
+        for (size_t word = 0; word < index_word_count(old_bits); ++word) {
+            uint64_t source = chunk->indices[word];
+            for (uint32_t field = 0; field < 64 / old_bits; ++field, source >>= old_bits) {
+                uint64_t const index = remap ? remap[source & old_mask] : source & old_mask;
+                packed |= index << packed_bits;
+                packed_bits += bits_per_index;
+                if (packed_bits == 64) {
+                    indices[packed_word++] = packed;
+                    packed = 0;
+                    packed_bits = 0;
+                }
+            }
+        }
+    }
+    free(chunk->indices);
+    chunk->indices = indices;
+    chunk->bits_per_index = bits_per_index;
+    chunk->index_shift = bits_per_index ? (uint32_t)__builtin_ctz(64 / bits_per_index) : 0;
+}
+
+static uint32_t bits_for_palette_count(uint32_t const palette_count) {
+    uint32_t bits = 0;
+    while (1u << bits < palette_count) bits = bits ? bits * 2 : 1;
+    return bits;
+}
+
+void chunk_compact(Chunk *const chunk) {
+    if (!chunk->bits_per_index) return;
+
+    bool used[chunk->palette_count];
+    memset(used, 0, sizeof(used));
+    mark_used_palette_entries(chunk, used);
+
+    uint16_t remap[chunk->palette_count];
+    uint32_t used_count = 0;
+    for (uint32_t i = 0; i < chunk->palette_count; ++i)
+        if (used[i]) {
+            remap[i] = (uint16_t)used_count;
+            chunk->palette[used_count++] = chunk->palette[i];
+        }
+    if (used_count == chunk->palette_count) return;
+
+    chunk->palette_count = used_count;
+    repack(chunk, bits_for_palette_count(used_count), remap);
+    rebuild_palette_lookup(chunk);
+}
+
+// a full palette hands out an entry no voxel uses anymore, the indices only widen when every entry is in use
+static uint32_t add_palette_entry(Chunk *const chunk, BlockId const block) {
+    if (chunk->palette_count == 1u << chunk->bits_per_index) {
+        if (chunk->bits_per_index) {
+            bool used[chunk->palette_count];
+            memset(used, 0, sizeof(used));
+            mark_used_palette_entries(chunk, used);
+            for (uint32_t i = 0; i < chunk->palette_count; ++i)
+                if (!used[i]) {
+                    chunk->palette[i] = block;
+                    rebuild_palette_lookup(chunk);
+                    return i;
+                }
+        }
+        repack(chunk, chunk->bits_per_index ? chunk->bits_per_index * 2 : 1, nullptr);
+    }
+    if (chunk->palette_count == chunk->palette_capacity) {
+        chunk->palette_capacity *= 2;
+        chunk->palette = realloc(chunk->palette, chunk->palette_capacity * sizeof(BlockId));
+        chunk->palette[chunk->palette_count] = block;
+        rebuild_palette_lookup(chunk);
+        return chunk->palette_count++;
+    }
+    chunk->palette[chunk->palette_count] = block;
+    if (chunk->palette_lookup) {
+        uint32_t const mask = chunk->palette_capacity * 2 - 1;
+        uint32_t slot = hash_block(block) & mask;
+        while (chunk->palette_lookup[slot]) slot = (slot + 1) & mask;
+        chunk->palette_lookup[slot] = chunk->palette_count + 1;
+    }
+    return chunk->palette_count++;
+}
+
+static uint32_t get_or_add_palette_index(Chunk *const chunk, BlockId const block) {
+    uint32_t const index = find_palette_index(chunk, block);
+    return index != UINT32_MAX ? index : add_palette_entry(chunk, block);
+}
+
+void chunk_set_block(Chunk *const chunk, uint32_t const x, uint32_t const y, uint32_t const z,
+                     BlockId const block) {
+    if (!chunk->bits_per_index && chunk->palette[0] == block) return;
+    uint32_t const palette_index = get_or_add_palette_index(chunk, block);
+    set_palette_index(chunk, chunk_voxel_index(x, y, z), palette_index);
+}
+
+// writes whole words with the replicated index, only the partial words at the ends are masked
+static void fill_index_range(Chunk *const chunk, uint32_t const begin, uint32_t const end,
+                             uint32_t const palette_index) {
+    uint32_t const bits = chunk->bits_per_index;
+    uint64_t const pattern = replicate_index(palette_index, bits);
+
+    uint64_t const first_bit = (uint64_t)begin * bits, last_bit = (uint64_t)end * bits;
+    size_t word = first_bit / 64;
+    size_t const last_word = last_bit / 64;
+    uint64_t const head_mask = ~0ull << first_bit % 64;
+    uint64_t const tail_mask = last_bit % 64 ? ~0ull >> (64 - last_bit % 64) : 0;
+    if (word == last_word) {
+        uint64_t const mask = head_mask & tail_mask;
+        chunk->indices[word] = (chunk->indices[word] & ~mask) | (pattern & mask);
+        return;
+    }
+    chunk->indices[word] = (chunk->indices[word] & ~head_mask) | (pattern & head_mask);
+    for (++word; word < last_word; ++word) chunk->indices[word] = pattern;
+    if (tail_mask) chunk->indices[last_word] = (chunk->indices[last_word] & ~tail_mask) | (pattern & tail_mask);
+}
+
+void chunk_fill(Chunk *const chunk, uint32_t const min[3], uint32_t const max[3], BlockId const block) {
+    if (min[0] >= max[0] || min[1] >= max[1] || min[2] >= max[2]) return;
+    if (!min[0] && !min[1] && !min[2] && max[0] == CHUNK_SIZE && max[1] == CHUNK_SIZE && max[2] == CHUNK_SIZE) {
+        free(chunk->indices);
+        chunk->indices = nullptr;
+        chunk->bits_per_index = 0;
+        chunk->index_shift = 0;
+        chunk->palette_count = 1;
+        chunk->palette[0] = block;
+        rebuild_palette_lookup(chunk);
+        return;
+    }
+    if (!chunk->bits_per_index && chunk->palette[0] == block) return;
+
+    uint32_t const palette_index = get_or_add_palette_index(chunk, block);
+    // rows merge into one range while they stay contiguous, a full xz box fills whole layers at once
+    uint32_t range_begin = 0, range_end = 0;
+    for (uint32_t y = min[1]; y < max[1]; ++y)
+        for (uint32_t z = min[2]; z < max[2]; ++z) {
+            uint32_t const begin = chunk_voxel_index(min[0], y, z), end = begin + max[0] - min[0];
+            if (begin != range_end) {
+                if (range_end > range_begin) fill_index_range(chunk, range_begin, range_end, palette_index);
+                range_begin = begin;
+            }
+            range_end = end;
+        }
+    fill_index_range(chunk, range_begin, range_end, palette_index);
+}
+
+static size_t palette_memory_usage(Chunk const *const chunk) {
+    return chunk->palette_capacity * sizeof(BlockId) +
+           (chunk->palette_lookup ? chunk->palette_capacity * 2 * sizeof(uint32_t) : 0);
+}
+
+size_t chunk_memory_usage(Chunk const *const chunk) {
+    return sizeof(Chunk) + palette_memory_usage(chunk) + index_word_count(chunk->bits_per_index) * sizeof(uint64_t) +
+           (chunk->light ? CHUNK_VOLUME : 0);
+}
+
+static size_t serialized_palette_size(uint32_t const palette_count) {
+    return (palette_count * sizeof(BlockId) + 7) & ~(size_t)7;
+}
+
+size_t chunk_serialized_size(Chunk const *const chunk) {
+    return 8 + serialized_palette_size(chunk->palette_count) +
+           index_word_count(chunk->bits_per_index) * sizeof(uint64_t);
+}
+
+void chunk_serialize(Chunk const *const chunk, void *const data) {
+    uint8_t *output = data;
+    uint32_t const header[2] = {chunk->bits_per_index, chunk->palette_count};
+    memcpy(output, header, sizeof(header));
+    output += sizeof(header);
+    auto const palette_size = serialized_palette_size(chunk->palette_count);
+    memset(output, 0, palette_size);
+    memcpy(output, chunk->palette, chunk->palette_count * sizeof(BlockId));
+    output += palette_size;
+    if (chunk->bits_per_index)
+        memcpy(output, chunk->indices, index_word_count(chunk->bits_per_index) * sizeof(uint64_t));
+}
+
+bool chunk_deserialize(Chunk *const chunk, int32_t const x, int32_t const y, int32_t const z, void const *const data,
+                       size_t const size) {
+    uint32_t header[2];
+    if (size < sizeof(header)) return false;
+    memcpy(header, data, sizeof(header));
+    uint32_t const bits = header[0], palette_count = header[1];
+    if ((bits != 0 && bits != 1 && bits != 2 && bits != 4 && bits != 8 && bits != 16) || !palette_count ||
+        palette_count > 1u << bits)
+        return false;
+    auto const palette_size = serialized_palette_size(palette_count);
+    auto const index_size = index_word_count(bits) * sizeof(uint64_t);
+    if (size != sizeof(header) + palette_size + index_size) return false;
+
+    // a capacity of every value the indices can hold, the entries past the count are air
+    uint32_t const capacity = 1u << bits;
+    *chunk = (Chunk){
+        .x = x,
+        .y = y,
+        .z = z,
+        .bits_per_index = bits,
+        .index_shift = bits ? (uint32_t)__builtin_ctz(64 / bits) : 0,
+        .palette_count = palette_count,
+        .palette_capacity = capacity,
+        .palette = calloc(capacity, sizeof(BlockId)),
+        .indices = bits ? malloc(index_size) : nullptr,
+    };
+    uint8_t const *const input = data;
+    memcpy(chunk->palette, input + sizeof(header), palette_count * sizeof(BlockId));
+    if (bits) memcpy(chunk->indices, input + sizeof(header) + palette_size, index_size);
+    rebuild_palette_lookup(chunk);
+    return true;
+}
+
+// world
+
+static uint32_t hash_chunk_coordinates(int32_t const x, int32_t const y, int32_t const z) {
+    uint64_t hash = (uint64_t)(uint32_t)x * 0x9E3779B97F4A7C15ull ^ (uint64_t)(uint32_t)y * 0xC2B2AE3D27D4EB4Full ^
+                    (uint64_t)(uint32_t)z * 0x165667B19E3779F9ull;
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ull;
+    return (uint32_t)(hash ^ hash >> 32);
+}
+
+void world_init(World *const world) {
+    *world = (World){
+        .capacity = INITIAL_WORLD_CAPACITY,
+        .slots = calloc(INITIAL_WORLD_CAPACITY, sizeof(WorldSlot)),
+    };
+}
+
+void world_free(World *const world) {
+    for (uint32_t i = 0; i < world->capacity; ++i)
+        if (world->slots[i].chunk) {
+            chunk_free(world->slots[i].chunk);
+            free(world->slots[i].chunk);
+        }
+    free(world->slots);
+    *world = (World){};
+}
+
+// the slot holding the chunk, or the empty slot where it would be inserted
+static WorldSlot *find_slot(World const *const world, int32_t const x, int32_t const y, int32_t const z) {
+    uint32_t const mask = world->capacity - 1;
+    for (uint32_t i = hash_chunk_coordinates(x, y, z) & mask;; i = (i + 1) & mask) {
+        auto const slot = &world->slots[i];
+        if (!slot->chunk || (slot->x == x && slot->y == y && slot->z == z)) return slot;
+    }
+}
+
+Chunk *world_get_chunk(World const *const world, int32_t const x, int32_t const y, int32_t const z) {
+    return find_slot(world, x, y, z)->chunk;
+}
+
+static void grow(World *const world) {
+    World grown = {
+        .chunk_count = world->chunk_count,
+        .capacity = world->capacity * 2,
+        .slots = calloc(world->capacity * 2, sizeof(WorldSlot)),
+    };
+    for (uint32_t i = 0; i < world->capacity; ++i)
+        if (world->slots[i].chunk) {
+            auto const slot = &world->slots[i];
+            *find_slot(&grown, slot->x, slot->y, slot->z) = *slot;
+        }
+    free(world->slots);
+    *world = grown;
+}
+
+Chunk *world_create_chunk(World *const world, int32_t const x, int32_t const y, int32_t const z) {
+    auto slot = find_slot(world, x, y, z);
+    if (slot->chunk) return slot->chunk;
+    if ((world->chunk_count + 1) * 2 > world->capacity) {
+        grow(world);
+        slot = find_slot(world, x, y, z);
+    }
+    *slot = (WorldSlot){
+        .x = x,
+        .y = y,
+        .z = z,
+        .chunk = malloc(sizeof(Chunk)),
+    };
+    chunk_init(slot->chunk, x, y, z, BLOCK_AIR);
+    ++world->chunk_count;
+    return slot->chunk;
+}
+
+// backward shift deletion, so lookups never need tombstones
+void world_remove_chunk(World *const world, int32_t const x, int32_t const y, int32_t const z) {
+    auto slot = find_slot(world, x, y, z);
+    if (!slot->chunk) return;
+    chunk_free(slot->chunk);
+    free(slot->chunk);
+    --world->chunk_count;
+
+    uint32_t const mask = world->capacity - 1;
+    auto hole = (uint32_t)(slot - world->slots);
+    *slot = (WorldSlot){};
+    for (uint32_t i = (hole + 1) & mask; world->slots[i].chunk; i = (i + 1) & mask) {
+        auto const candidate = &world->slots[i];
+        uint32_t const home = hash_chunk_coordinates(candidate->x, candidate->y, candidate->z) & mask;
+        // the entry may move into the hole only when its home is not between the hole and its position
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            world->slots[hole] = *candidate;
+            *candidate = (WorldSlot){};
+            hole = i;
+        }
+    }
+}
+
+// arithmetic shifts floor negative block coordinates into the right chunk
+BlockId world_get_block(World const *const world, int32_t const x, int32_t const y, int32_t const z) {
+    auto const chunk = world_get_chunk(world, x >> CHUNK_SIZE_LOG2, y >> CHUNK_SIZE_LOG2, z >> CHUNK_SIZE_LOG2);
+    if (!chunk) return BLOCK_AIR;
+    return chunk_get_block(chunk, (uint32_t)x & (CHUNK_SIZE - 1), (uint32_t)y & (CHUNK_SIZE - 1),
+                           (uint32_t)z & (CHUNK_SIZE - 1));
+}
+
+void world_set_block(World *const world, int32_t const x, int32_t const y, int32_t const z, BlockId const block) {
+    auto const chunk = world_create_chunk(world, x >> CHUNK_SIZE_LOG2, y >> CHUNK_SIZE_LOG2, z >> CHUNK_SIZE_LOG2);
+    chunk_set_block(chunk, (uint32_t)x & (CHUNK_SIZE - 1), (uint32_t)y & (CHUNK_SIZE - 1),
+                    (uint32_t)z & (CHUNK_SIZE - 1), block);
+}
+
+WorldMemoryUsage world_memory_usage(World const *const world) {
+    WorldMemoryUsage usage = {
+        .chunk_count = world->chunk_count,
+        .header_bytes = sizeof(World) + world->capacity * sizeof(WorldSlot),
+    };
+    for (uint32_t i = 0; i < world->capacity; ++i) {
+        auto const chunk = world->slots[i].chunk;
+        if (!chunk) continue;
+        usage.header_bytes += sizeof(Chunk);
+        usage.palette_bytes += palette_memory_usage(chunk);
+        usage.index_bytes += index_word_count(chunk->bits_per_index) * sizeof(uint64_t);
+        if (chunk->light) usage.light_bytes += CHUNK_VOLUME;
+    }
+    usage.total_bytes = usage.header_bytes + usage.palette_bytes + usage.index_bytes + usage.light_bytes;
+    return usage;
+}
+
+void world_get_neighbors(World const *const world, int32_t const x, int32_t const y, int32_t const z,
+                         Chunk const *neighbors[CHUNK_NEIGHBOR_COUNT]) {
+    for (int32_t dy = -1; dy <= 1; ++dy)
+        for (int32_t dz = -1; dz <= 1; ++dz)
+            for (int32_t dx = -1; dx <= 1; ++dx)
+                neighbors[chunk_neighbor_index(dx, dy, dz)] = world_get_chunk(world, x + dx, y + dy, z + dz);
+}
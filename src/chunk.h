@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// voxel storage, cubic chunks of palette indices
+// each chunk keeps a palette of the block types it contains and one index per voxel,
+// indices are bit packed at 0, 1, 2, 4, 8 or 16 bits so they never straddle a 64 bit word
+// a chunk made of a single block type stores no indices at all
+// a full palette first reuses entries no voxel refers to anymore, the width only grows when none are left
+// and chunk_compact shrinks it back
+
+constexpr uint32_t CHUNK_SIZE_LOG2 = 5;
+constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_SIZE_LOG2;
+constexpr uint32_t CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+typedef uint16_t BlockId;
+
+constexpr BlockId BLOCK_AIR = 0;
+
+typedef struct {
+    int32_t x, y, z;
+    uint32_t bits_per_index;
+    // log2 of the indices per word, the index of voxel i lives in word i >> index_shift
+    uint32_t index_shift;
+    uint32_t palette_count;
+    uint32_t palette_capacity;
+    BlockId *palette;
+    // block to palette index plus one, twice the palette capacity, only kept once the palette outgrows a linear scan
+    uint32_t *palette_lookup;
+    uint64_t *indices;
+    // one byte per voxel in voxel order, sky light in the high and block light in the low 4 bits, see light.h
+    // nullptr until the chunk is lit
+    uint8_t *light;
+} Chunk;
+
+// x is the fastest axis then z then y, so a full x row and a full xz layer are contiguous
+static inline uint32_t chunk_voxel_index(uint32_t const x, uint32_t const y, uint32_t const z) {
+    return x | z << CHUNK_SIZE_LOG2 | y << CHUNK_SIZE_LOG2 * 2;
+}
+
+static inline uint32_t chunk_get_palette_index(Chunk const *const chunk, uint32_t const voxel_index) {
+    if (!chunk->bits_per_index) return 0;
+    uint32_t const bit = (voxel_index & ((1u << chunk->index_shift) - 1)) * chunk->bits_per_index;
+    return (uint32_t)(chunk->indices[voxel_index >> chunk->index_shift] >> bit) &
+           ((1u << chunk->bits_per_index) - 1);
+}
+
+static inline BlockId chunk_get_block(Chunk const *const chunk, uint32_t const x, uint32_t const y,
+                                      uint32_t const z) {
+    return chunk->palette[chunk_get_palette_index(chunk, chunk_voxel_index(x, y, z))];
+}
+
+void chunk_init(Chunk *chunk, int32_t x, int32_t y, int32_t z, BlockId block);
+void chunk_free(Chunk *chunk);
+void chunk_set_block(Chunk *chunk, uint32_t x, uint32_t y, uint32_t z, BlockId block);
+// fills the box [min, max) with block, a box covering the whole chunk drops the indices entirely
+void chunk_fill(Chunk *chunk, uint32_t const min[3], uint32_t const max[3], BlockId block);
+// drops palette entries no voxel uses anymore and narrows the indices when possible
+void chunk_compact(Chunk *chunk);
+size_t chunk_memory_usage(Chunk const *chunk);
+
+// the palette and the packed indices as they are in memory, for region files
+// a 32 bit index width and palette count, the palette padded to 8 bytes, then the index words, all little endian
+constexpr size_t CHUNK_MAX_SERIALIZED_SIZE = 8 + 65536 * sizeof(BlockId) + CHUNK_VOLUME * sizeof(BlockId);
+
+size_t chunk_serialized_size(Chunk const *chunk);
+// writes chunk_serialized_size bytes
+void chunk_serialize(Chunk const *chunk, void *data);
+// false when data does not hold a serialized chunk, the chunk is not initialized then
+// indices past the palette read as air instead of outside of it, so a damaged file cannot corrupt memory
+bool chunk_deserialize(Chunk *chunk, int32_t x, int32_t y, int32_t z, void const *data, size_t size);
+
+// chunks by chunk coordinates, open addressing with linear probing
+typedef struct {
+    int32_t x, y, z;
+    Chunk *chunk;
+} WorldSlot;
+
+typedef struct {
+    uint32_t chunk_count;
+    // always a power of two, kept at most half full
+    uint32_t capacity;
+    WorldSlot *slots;
+} World;
+
+typedef struct {
+    size_t chunk_count;
+    // chunk headers plus the hash table
+    size_t header_bytes;
+    size_t palette_bytes;
+    size_t index_bytes;
+    size_t light_bytes;
+    size_t total_bytes;
+} WorldMemoryUsage;
+
+void world_init(World *world);
+void world_free(World *world);
+Chunk *world_get_chunk(World const *world, int32_t x, int32_t y, int32_t z);
+// returns the existing chunk or a new one filled with air
+Chunk *world_create_chunk(World *world, int32_t x, int32_t y, int32_t z);
+void world_remove_chunk(World *world, int32_t x, int32_t y, int32_t z);
+// block coordinates, air when the chunk is not loaded
+BlockId world_get_block(World const *world, int32_t x, int32_t y, int32_t z);
+// creates the chunk when it is not loaded
+void world_set_block(World *world, int32_t x, int32_t y, int32_t z, BlockId block);
+WorldMemoryUsage world_memory_usage(World const *world);
+
+// the chunk at x, y, z and the 26 around it, indexed by chunk_neighbor_index in voxel order, so the middle entry is
+// the chunk itself
+constexpr uint32_t CHUNK_NEIGHBOR_COUNT = 27;
+
+static inline uint32_t chunk_neighbor_index(int32_t const dx, int32_t const dy, int32_t const dz) {
+    return (uint32_t)(dx + 1 + (dz + 1) * 3 + (dy + 1) * 9);
+}
+
+// nullptr where no chunk is loaded
+void world_get_neighbors(World const *world, int32_t x, int32_t y, int32_t z,
+                         Chunk const *neighbors[CHUNK_NEIGHBOR_COUNT]);
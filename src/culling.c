@@ -0,0 +1,366 @@
+#include "culling.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mesher.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CULLING_X86
+#include <immintrin.h>
+#endif
+
+// the top 3 bits of a queue entry hold the face the walk came in through
+constexpr uint32_t QUEUE_FACE_SHIFT = 29;
+constexpr uint32_t QUEUE_CELL_MASK = (1u << QUEUE_FACE_SHIFT) - 1;
+constexpr uint8_t CELL_REACHED = 0x80;
+
+void cull_boxes_init(CullBoxes *const boxes, uint32_t const capacity) {
+    auto const padded = (capacity + CULL_BATCH_SIZE - 1) / CULL_BATCH_SIZE * CULL_BATCH_SIZE;
+    float *const data = malloc(6 * (size_t)padded * sizeof(float));
+    *boxes = (CullBoxes){
+        .capacity = padded,
+        .min_x = data,
+        .min_y = data + padded,
+        .min_z = data + 2 * (size_t)padded,
+        .max_x = data + 3 * (size_t)padded,
+        .max_y = data + 4 * (size_t)padded,
+        .max_z = data + 5 * (size_t)padded,
+    };
+    // inverted boxes fail every plane, infinities and the nans from multiplying them by zero compare false
+    for (uint32_t i = 0; i < 3 * padded; ++i) {
+        data[i] = INFINITY;
+        data[3 * (size_t)padded + i] = -INFINITY;
+    }
+}
+
+void cull_boxes_free(CullBoxes *const boxes) {
+    free(boxes->min_x);
+    *boxes = (CullBoxes){};
+}
+
+uint32_t cull_boxes_add(CullBoxes *const boxes, float const min[3], float const max[3]) {
+    if (boxes->count == boxes->capacity) {
+        CullBoxes grown;
+        cull_boxes_init(&grown, boxes->capacity ? boxes->capacity * 2 : CULL_BATCH_SIZE);
+        for (uint32_t i = 0; i < boxes->count; ++i)
+            cull_boxes_set(&grown, i, (float[]){boxes->min_x[i], boxes->min_y[i], boxes->min_z[i]},
+                           (float[]){boxes->max_x[i], boxes->max_y[i], boxes->max_z[i]});
+        grown.count = boxes->count;
+        cull_boxes_free(boxes);
+        *boxes = grown;
+    }
+    cull_boxes_set(boxes, boxes->count, min, max);
+    return boxes->count++;
+}
+
+void cull_boxes_set(CullBoxes *const boxes, uint32_t const index, float const min[3], float const max[3]) {
+    boxes->min_x[index] = min[0];
+    boxes->min_y[index] = min[1];
+    boxes->min_z[index] = min[2];
+    boxes->max_x[index] = max[0];
+    boxes->max_y[index] = max[1];
+    boxes->max_z[index] = max[2];
+}
+
+// the corner furthest along a plane normal takes the max on the axes where the normal is positive,
+// so every plane reads one fixed array per axis and the loops need no blends
+static void select_far_corners(CullBoxes const *const boxes, float const planes[6][4],
+                               float const *corners[6][3]) {
+    for (uint32_t i = 0; i < 6; ++i) {
+        corners[i][0] = planes[i][0] > 0.0f ? boxes->max_x : boxes->min_x;
+        corners[i][1] = planes[i][1] > 0.0f ? boxes->max_y : boxes->min_y;
+        corners[i][2] = planes[i][2] > 0.0f ? boxes->max_z : boxes->min_z;
+    }
+}
+
+static uint32_t cull_frustum_scalar(CullBoxes const *const boxes, float const planes[6][4],
+                                    uint8_t *const visible_mask) {
+    float const *corners[6][3];
+    select_far_corners(boxes, planes, corners);
+    uint32_t visible_count = 0;
+    for (uint32_t batch = 0; batch < boxes->count; batch += CULL_BATCH_SIZE) {
+        uint32_t mask = 0;
+        for (uint32_t i = batch; i < batch + CULL_BATCH_SIZE; ++i) {
+            bool inside = true;
+            for (uint32_t p = 0; p < 6; ++p)
+                inside &= planes[p][0] * corners[p][0][i] + planes[p][1] * corners[p][1][i] +
+                          planes[p][2] * corners[p][2][i] + planes[p][3] >= 0.0f;
+            mask |= (uint32_t)inside << (i - batch);
+        }
+        visible_mask[batch / CULL_BATCH_SIZE] = (uint8_t)mask;
+        visible_count += (uint32_t)__builtin_popcount(mask);
+    }
+    return visible_count;
+}
+
+#ifdef CULLING_X86
+// two halves of 4 boxes per batch
+static uint32_t cull_frustum_sse(CullBoxes const *const boxes, float const planes[6][4],
+                                 uint8_t *const visible_mask) {
+    float const *corners[6][3];
+    select_far_corners(boxes, planes, corners);
+    __m128 normals[6][4];
+    for (uint32_t p = 0; p < 6; ++p)
+        for (uint32_t i = 0; i < 4; ++i) normals[p][i] = _mm_set1_ps(planes[p][i]);
+
+    auto const zero = _mm_setzero_ps();
+    uint32_t visible_count = 0;
+    for (uint32_t batch = 0; batch < boxes->count; batch += CULL_BATCH_SIZE) {
+        uint32_t mask = 0;
+        for (uint32_t half = 0; half < CULL_BATCH_SIZE; half += 4) {
+            auto const i = batch + half;
+            auto inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (uint32_t p = 0; p < 6; ++p) {
+                auto const distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normals[p][0], _mm_loadu_ps(corners[p][0] + i)),
+                                                            _mm_mul_ps(normals[p][1], _mm_loadu_ps(corners[p][1] + i))),
+                                                 _mm_add_ps(_mm_mul_ps(normals[p][2], _mm_loadu_ps(corners[p][2] + i)),
+                                                            normals[p][3]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+            }
+            mask |= (uint32_t)_mm_movemask_ps(inside) << half;
+        }
+        visible_mask[batch / CULL_BATCH_SIZE] = (uint8_t)mask;
+        visible_count += (uint32_t)__builtin_popcount(mask);
+    }
+    return visible_count;
+}
+
+__attribute__((target("avx")))
+static uint32_t cull_frustum_avx(CullBoxes const *const boxes, float const planes[6][4],
+                                 uint8_t *const visible_mask) {
+    float const *corners[6][3];
+    select_far_corners(boxes, planes, corners);
+    __m256 normals[6][4];
+    for (uint32_t p = 0; p < 6; ++p)
+        for (uint32_t i = 0; i < 4; ++i) normals[p][i] = _mm256_set1_ps(planes[p][i]);
+
+    auto const zero = _mm256_setzero_ps();
+    uint32_t visible_count = 0;
+    for (uint32_t batch = 0; batch < boxes->count; batch += CULL_BATCH_SIZE) {
+        auto inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (uint32_t p = 0; p < 6; ++p) {
+            auto const distance = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(normals[p][0], _mm256_loadu_ps(corners[p][0] + batch)),
+                              _mm256_mul_ps(normals[p][1], _mm256_loadu_ps(corners[p][1] + batch))),
+                _mm256_add_ps(_mm256_mul_ps(normals[p][2], _mm256_loadu_ps(corners[p][2] + batch)), normals[p][3]));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+        }
+        auto const mask = (uint32_t)_mm256_movemask_ps(inside);
+        visible_mask[batch / CULL_BATCH_SIZE] = (uint8_t)mask;
+        visible_count += (uint32_t)__builtin_popcount(mask);
+    }
+    return visible_count;
+}
+#endif
+
+CullSimd cull_simd_supported() {
+#ifdef CULLING_X86
+    return __builtin_cpu_supports("avx") ? CULL_SIMD_AVX : CULL_SIMD_SSE;
+#else
+    return CULL_SIMD_SCALAR;
+#endif
+}
+
+char const *cull_simd_name(CullSimd const simd) {
+    static char const *const names[CULL_SIMD_COUNT] = {"scalar", "sse", "avx"};
+    return names[simd];
+}
+
+uint32_t cull_frustum_with(CullSimd const simd, CullBoxes const *const boxes, float const planes[6][4],
+                           uint8_t *const visible_mask) {
+    switch (simd) {
+#ifdef CULLING_X86
+        case CULL_SIMD_AVX: return cull_frustum_avx(boxes, planes, visible_mask);
+        case CULL_SIMD_SSE: return cull_frustum_sse(boxes, planes, visible_mask);
+#endif
+        default: return cull_frustum_scalar(boxes, planes, visible_mask);
+    }
+}
+
+uint32_t cull_frustum(CullBoxes const *const boxes, float const planes[6][4], uint8_t *const visible_mask) {
+    return cull_frustum_with(cull_simd_supported(), boxes, planes, visible_mask);
+}
+
+// the run of open bits around seeds, a kogge stone fill each way where blocked bits stop the propagation
+static uint32_t fill_row_span(uint32_t const seeds, uint32_t const open) {
+    uint32_t up = seeds, up_open = open, down = seeds, down_open = open;
+    for (uint32_t shift = 1; shift < CHUNK_SIZE; shift <<= 1) {
+        up |= up_open & up << shift;
+        up_open &= up_open << shift;
+        down |= down_open & down >> shift;
+        down_open &= down_open >> shift;
+    }
+    return up | down;
+}
+
+static void add_row_seeds(ConnectivityScratch *const scratch, uint32_t *const stack_count, uint32_t const row,
+                          uint32_t const span) {
+    auto const seeds = span & scratch->open[row];
+    if (!seeds) return;
+    if (!scratch->seeds[row]) scratch->stack[(*stack_count)++] = (uint16_t)row;
+    scratch->seeds[row] |= seeds;
+}
+
+// narrow indices go a byte at a time through a table of the air voxels every byte value encodes,
+// indices are packed from the low bits up so on little endian targets byte order is voxel order
+static void find_open_voxels(ConnectivityScratch *const scratch, Chunk const *const chunk) {
+    auto const bits = chunk->bits_per_index;
+    if (bits == 16) {
+        auto const indices = (uint16_t const*)chunk->indices;
+        for (uint32_t row = 0; row < CHUNK_SIZE * CHUNK_SIZE; ++row) {
+            uint32_t open = 0;
+            for (uint32_t x = 0; x < CHUNK_SIZE; ++x)
+                open |= (uint32_t)(chunk->palette[indices[row << CHUNK_SIZE_LOG2 | x]] == BLOCK_AIR) << x;
+            scratch->open[row] = open;
+        }
+        return;
+    }
+
+    uint32_t const per_byte = 8 / bits;
+    uint8_t table[256];
+    for (uint32_t byte = 0; byte < 256; ++byte) {
+        table[byte] = 0;
+        for (uint32_t i = 0; i < per_byte; ++i) {
+            uint32_t const index = byte >> i * bits & ((1u << bits) - 1);
+            table[byte] |= (uint8_t)((index < chunk->palette_count && chunk->palette[index] == BLOCK_AIR) << i);
+        }
+    }
+    auto const bytes = (uint8_t const*)chunk->indices;
+    uint32_t const bytes_per_row = CHUNK_SIZE / per_byte;
+    for (uint32_t row = 0; row < CHUNK_SIZE * CHUNK_SIZE; ++row) {
+        uint32_t open = 0;
+        for (uint32_t i = 0; i < bytes_per_row; ++i)
+            open |= (uint32_t)table[bytes[row * bytes_per_row + i]] << i * per_byte;
+        scratch->open[row] = open;
+    }
+}
+
+ChunkConnectivity chunk_connectivity(ConnectivityScratch *const scratch, Chunk const *const chunk) {
+    if (!chunk->bits_per_index) return chunk->palette[0] == BLOCK_AIR ? CHUNK_FULLY_CONNECTED : 0;
+
+    find_open_voxels(scratch, chunk);
+    memset(scratch->seeds, 0, sizeof(scratch->seeds));
+
+    // every flood fill connects all faces it touches with each other, it spreads a whole row span at a time
+    ChunkConnectivity connectivity = 0;
+    constexpr uint32_t last = CHUNK_SIZE - 1;
+    for (uint32_t first_row = 0; first_row < CHUNK_SIZE * CHUNK_SIZE; ++first_row)
+        while (scratch->open[first_row]) {
+            uint32_t stack_count = 0;
+            add_row_seeds(scratch, &stack_count, first_row, scratch->open[first_row] & -scratch->open[first_row]);
+            uint32_t faces = 0;
+            while (stack_count) {
+                uint32_t const row = scratch->stack[--stack_count];
+                auto const span = fill_row_span(scratch->seeds[row], scratch->open[row]);
+                scratch->seeds[row] = 0;
+                scratch->open[row] &= ~span;
+
+                uint32_t const z = row & last;
+                uint32_t const y = row >> CHUNK_SIZE_LOG2;
+                faces |= (span & 1) << CHUNK_FACE_NEGATIVE_X | (span >> last) << CHUNK_FACE_POSITIVE_X |
+                         (uint32_t)(y == 0) << CHUNK_FACE_NEGATIVE_Y | (uint32_t)(y == last) << CHUNK_FACE_POSITIVE_Y |
+                         (uint32_t)(z == 0) << CHUNK_FACE_NEGATIVE_Z | (uint32_t)(z == last) << CHUNK_FACE_POSITIVE_Z;
+                if (z > 0) add_row_seeds(scratch, &stack_count, row - 1, span);
+                if (z < last) add_row_seeds(scratch, &stack_count, row + 1, span);
+                if (y > 0) add_row_seeds(scratch, &stack_count, row - CHUNK_SIZE, span);
+                if (y < last) add_row_seeds(scratch, &stack_count, row + CHUNK_SIZE, span);
+            }
+
+            for (uint32_t a = 0; a < CHUNK_FACE_COUNT; ++a)
+                for (uint32_t b = a + 1; b < CHUNK_FACE_COUNT; ++b)
+                    if (faces >> a & faces >> b & 1) connectivity |= 1u << (a * (11 - a) / 2 + b - a - 1);
+            if (connectivity == CHUNK_FULLY_CONNECTED) return connectivity;
+        }
+    return connectivity;
+}
+
+void visibility_grid_init(VisibilityGrid *const grid, int32_t const origin[3], uint32_t const size[3]) {
+    auto const cell_count = size[0] * size[1] * size[2];
+    *grid = (VisibilityGrid){
+        .origin = {origin[0], origin[1], origin[2]},
+        .size = {size[0], size[1], size[2]},
+        .cell_count = cell_count,
+        .connectivity = malloc(cell_count * sizeof(ChunkConnectivity)),
+        .directions = malloc(cell_count),
+        .queue = malloc(cell_count * sizeof(uint32_t)),
+    };
+    cull_boxes_init(&grid->boxes, cell_count);
+    grid->visible_mask = malloc(grid->boxes.capacity / CULL_BATCH_SIZE);
+    for (uint32_t i = 0; i < cell_count; ++i) {
+        grid->connectivity[i] = CHUNK_FULLY_CONNECTED;
+        uint32_t const cell[3] = {i % size[0], i / (size[0] * size[2]), i / size[0] % size[2]};
+        float min[3], max[3];
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            min[axis] = (float)((origin[axis] + (int32_t)cell[axis]) * (int32_t)CHUNK_SIZE);
+            max[axis] = min[axis] + (float)CHUNK_SIZE;
+        }
+        cull_boxes_add(&grid->boxes, min, max);
+    }
+}
+
+void visibility_grid_free(VisibilityGrid *const grid) {
+    cull_boxes_free(&grid->boxes);
+    free(grid->connectivity);
+    free(grid->visible_mask);
+    free(grid->directions);
+    free(grid->queue);
+    *grid = (VisibilityGrid){};
+}
+
+uint32_t visibility_grid_cell(VisibilityGrid const *const grid, int32_t const x, int32_t const y, int32_t const z) {
+    auto const cell_x = (uint32_t)(x - grid->origin[0]);
+    auto const cell_y = (uint32_t)(y - grid->origin[1]);
+    auto const cell_z = (uint32_t)(z - grid->origin[2]);
+    if (cell_x >= grid->size[0] || cell_y >= grid->size[1] || cell_z >= grid->size[2]) return UINT32_MAX;
+    return cell_x + grid->size[0] * (cell_z + grid->size[2] * cell_y);
+}
+
+static bool is_cell_in_frustum(VisibilityGrid const *const grid, uint32_t const cell) {
+    return grid->visible_mask[cell / CULL_BATCH_SIZE] >> cell % CULL_BATCH_SIZE & 1;
+}
+
+uint32_t visibility_grid_cull(VisibilityGrid *const grid, float const camera[3], float const planes[6][4],
+                              uint32_t *const visible_cells) {
+    cull_frustum(&grid->boxes, planes, grid->visible_mask);
+    auto const start = visibility_grid_cell(grid, (int32_t)floorf(camera[0] / (float)CHUNK_SIZE),
+                                            (int32_t)floorf(camera[1] / (float)CHUNK_SIZE),
+                                            (int32_t)floorf(camera[2] / (float)CHUNK_SIZE));
+    uint32_t visible_count = 0;
+    if (start == UINT32_MAX) {
+        for (uint32_t i = 0; i < grid->cell_count; ++i)
+            if (is_cell_in_frustum(grid, i)) visible_cells[visible_count++] = i;
+        return visible_count;
+    }
+
+    // breadth first, a cell is reached once by the shortest walk, which is the one most likely to see it
+    memset(grid->directions, 0, grid->cell_count);
+    grid->directions[start] = CELL_REACHED;
+    grid->queue[0] = start | (uint32_t)CHUNK_FACE_COUNT << QUEUE_FACE_SHIFT;
+    uint32_t const strides[3] = {1, grid->size[0] * grid->size[2], grid->size[0]};
+    uint32_t head = 0, tail = 1;
+    while (head < tail) {
+        auto const entry = grid->queue[head++];
+        auto const cell = entry & QUEUE_CELL_MASK;
+        auto const entered_face = entry >> QUEUE_FACE_SHIFT;
+        if (cell != start || is_cell_in_frustum(grid, cell)) visible_cells[visible_count++] = cell;
+
+        uint32_t const position[3] = {cell % grid->size[0], cell / strides[1], cell / grid->size[0] % grid->size[2]};
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+            auto const axis = face >> 1;
+            bool const is_positive = face & 1;
+            // leaving through a face means walking along its direction, the opposite one was taken already
+            if (grid->directions[cell] & 1u << (face ^ 1)) continue;
+            if (is_positive ? position[axis] + 1 == grid->size[axis] : position[axis] == 0) continue;
+            if (entered_face != CHUNK_FACE_COUNT &&
+                !chunk_faces_connected(grid->connectivity[cell], entered_face, face)) continue;
+
+            auto const neighbor = is_positive ? cell + strides[axis] : cell - strides[axis];
+            if (grid->directions[neighbor] || !is_cell_in_frustum(grid, neighbor)) continue;
+            grid->directions[neighbor] = (uint8_t)(grid->directions[cell] | CELL_REACHED | 1u << face);
+            grid->queue[tail++] = neighbor | (face ^ 1) << QUEUE_FACE_SHIFT;
+        }
+    }
+    return visible_count;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "chunk.h"
+
+// chunk visibility on the cpu
+// boxes are kept as structure of arrays so the frustum test loads one coordinate of 8 boxes at once and writes their
+// results as one byte of a bit mask
+// occlusion follows the open space through the chunks, a walk starts at the camera chunk and only leaves a chunk
+// through a face that the space it came in through connects to, never turning back toward the camera
+
+constexpr uint32_t CULL_BATCH_SIZE = 8;
+
+typedef enum {
+    CULL_SIMD_SCALAR,
+    CULL_SIMD_SSE,
+    CULL_SIMD_AVX,
+    CULL_SIMD_COUNT,
+} CullSimd;
+
+// capacity is a multiple of CULL_BATCH_SIZE, unused entries are empty boxes that never pass a test
+typedef struct {
+    uint32_t count;
+    uint32_t capacity;
+    float *min_x, *min_y, *min_z;
+    float *max_x, *max_y, *max_z;
+} CullBoxes;
+
+void cull_boxes_init(CullBoxes *boxes, uint32_t capacity);
+void cull_boxes_free(CullBoxes *boxes);
+// returns the index of the box
+uint32_t cull_boxes_add(CullBoxes *boxes, float const min[3], float const max[3]);
+void cull_boxes_set(CullBoxes *boxes, uint32_t index, float const min[3], float const max[3]);
+
+// the best implementation the cpu runs
+CullSimd cull_simd_supported();
+char const *cull_simd_name(CullSimd simd);
+// planes point inside, a point p is inside a plane when dot(xyz, p) + w >= 0
+// bit i % 8 of visible_mask[i / 8] is set when box i touches the frustum, returns how many do
+uint32_t cull_frustum(CullBoxes const *boxes, float const planes[6][4], uint8_t *visible_mask);
+// simd must not be better than cull_simd_supported, for comparing the implementations
+uint32_t cull_frustum_with(CullSimd simd, CullBoxes const *boxes, float const planes[6][4], uint8_t *visible_mask);
+
+// one bit per pair of chunk faces, set when open space inside the chunk touches both
+typedef uint16_t ChunkConnectivity;
+
+constexpr ChunkConnectivity CHUNK_FULLY_CONNECTED = 0x7FFF;
+
+// faces are CHUNK_FACE_* from mesher.h
+static inline bool chunk_faces_connected(ChunkConnectivity const connectivity, uint32_t a, uint32_t b) {
+    if (a == b) return true;
+    if (a > b) {
+        auto const swap = a;
+        a = b;
+        b = swap;
+    }
+    return connectivity >> (a * (11 - a) / 2 + b - a - 1) & 1;
+}
+
+// per thread working memory for chunk_connectivity
+typedef struct {
+    // bit x of row z | y << CHUNK_SIZE_LOG2 is an open voxel that no flood fill reached yet
+    uint32_t open[CHUNK_SIZE * CHUNK_SIZE];
+    // bits a neighboring span reached, a row is on the stack while it has seeds
+    uint32_t seeds[CHUNK_SIZE * CHUNK_SIZE];
+    uint16_t stack[CHUNK_SIZE * CHUNK_SIZE];
+} ConnectivityScratch;
+
+// flood fills the air of the chunk
+ChunkConnectivity chunk_connectivity(ConnectivityScratch *scratch, Chunk const *chunk);
+
+// a box of chunk cells for the occlusion walk, x is the fastest axis then z then y like voxels in a chunk
+// cells without a chunk are open air
+typedef struct {
+    int32_t origin[3];
+    uint32_t size[3];
+    uint32_t cell_count;
+    // the cube of every cell, the walk tests cells and not meshes since air has no mesh but has to be walked through
+    CullBoxes boxes;
+    ChunkConnectivity *connectivity;
+    uint8_t *visible_mask;
+    // per cell, the directions the walk took to get there, 0 while the cell is not reached yet
+    uint8_t *directions;
+    uint32_t *queue;
+} VisibilityGrid;
+
+// origin and cells are in chunk coordinates
+void visibility_grid_init(VisibilityGrid *grid, int32_t const origin[3], uint32_t const size[3]);
+void visibility_grid_free(VisibilityGrid *grid);
+// UINT32_MAX when the chunk is outside the grid
+uint32_t visibility_grid_cell(VisibilityGrid const *grid, int32_t x, int32_t y, int32_t z);
+// writes the cells the camera can see into visible_cells, which holds cell_count entries, in walk order so roughly
+// nearest first
+// from outside the grid nothing can be walked and every cell in the frustum counts as visible
+uint32_t visibility_grid_cull(VisibilityGrid *grid, float const camera[3], float const planes[6][4],
+                              uint32_t *visible_cells);
@@ -0,0 +1,410 @@
+#include "jobs.h"
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// how many rounds of stealing an idle worker tries before it goes to sleep
+constexpr uint32_t IDLE_SPIN_COUNT = 64;
+constexpr uint32_t INITIAL_MAIN_CALLBACK_CAPACITY = 64;
+// keeps the two ends of a deque on separate cache lines
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+struct JobContinuation {
+    JobContinuation *next;
+    JobCounter *counter;
+    uint32_t count;
+    Job jobs[];
+};
+
+typedef struct {
+    Job job;
+    JobCounter *counter;
+} QueuedJob;
+
+// a thief can read a slot while the owner reuses it, the read is thrown away when the steal loses the race for top but
+// the fields are still atomics so that is not a data race
+typedef struct {
+    _Atomic(JobFunction) function;
+    _Atomic(void *) data;
+    _Atomic(JobCounter *) counter;
+} JobSlot;
+
+// chase lev deque over a fixed ring, top and bottom only grow and are taken modulo JOB_QUEUE_CAPACITY
+typedef struct {
+    JobSystem *jobs;
+    uint32_t random_state;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+    char top_padding[CACHE_LINE_SIZE];
+    atomic_size_t top;
+    char bottom_padding[CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+    atomic_size_t bottom;
+    char queue_padding[CACHE_LINE_SIZE - sizeof(atomic_size_t)];
+    JobSlot queue[JOB_QUEUE_CAPACITY];
+} JobWorker;
+
+struct JobSystem {
+    uint32_t thread_count;
+    JobWorker *workers;
+    atomic_bool is_quitting;
+    // workers that are asleep or about to be, each one is woken by one semaphore release
+    atomic_uint sleeping_count;
+#ifdef _WIN32
+    HANDLE wake_semaphore;
+#else
+    sem_t wake_semaphore;
+#endif
+
+    // callbacks are appended to one array under the lock while the main thread runs the other
+    atomic_bool main_callback_lock;
+    uint32_t main_callback_count;
+    uint32_t main_callback_capacity;
+    Job *main_callbacks;
+    uint32_t running_callback_capacity;
+    Job *running_callbacks;
+};
+
+static thread_local JobWorker *current_worker;
+
+static void spin_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+}
+
+static void lock(atomic_bool *const lock) {
+    while (atomic_exchange_explicit(lock, true, memory_order_acquire))
+        while (atomic_load_explicit(lock, memory_order_relaxed)) spin_pause();
+}
+
+static void unlock(atomic_bool *const lock) { atomic_store_explicit(lock, false, memory_order_release); }
+
+static uint32_t next_random(JobWorker *const worker) {
+    worker->random_state ^= worker->random_state << 13;
+    worker->random_state ^= worker->random_state >> 17;
+    worker->random_state ^= worker->random_state << 5;
+    return worker->random_state;
+}
+
+static void write_slot(JobSlot *const slot, QueuedJob const *const job) {
+    atomic_store_explicit(&slot->function, job->job.function, memory_order_relaxed);
+    atomic_store_explicit(&slot->data, job->job.data, memory_order_relaxed);
+    atomic_store_explicit(&slot->counter, job->counter, memory_order_relaxed);
+}
+
+static void read_slot(JobSlot *const slot, QueuedJob *const job) {
+    job->job.function = atomic_load_explicit(&slot->function, memory_order_relaxed);
+    job->job.data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+    job->counter = atomic_load_explicit(&slot->counter, memory_order_relaxed);
+}
+
+static bool push(JobWorker *const worker, QueuedJob const *const job) {
+    size_t const bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed);
+    size_t const top = atomic_load_explicit(&worker->top, memory_order_acquire);
+    if (bottom - top >= JOB_QUEUE_CAPACITY) return false;
+    write_slot(&worker->queue[bottom % JOB_QUEUE_CAPACITY], job);
+    atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_release);
+    return true;
+}
+
+// owner only, takes the newest job
+static bool pop(JobWorker *const worker, QueuedJob *const job) {
+    size_t const bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&worker->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t top = atomic_load_explicit(&worker->top, memory_order_relaxed);
+    if ((ptrdiff_t)(bottom - top) < 0) {
+        atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+        return false;
+    }
+    read_slot(&worker->queue[bottom % JOB_QUEUE_CAPACITY], job);
+    if (bottom != top) return true;
+
+    // the last job can be stolen at the same time, whoever moves top first gets it
+    bool const is_taken = atomic_compare_exchange_strong_explicit(&worker->top, &top, top + 1, memory_order_seq_cst,
+                                                                  memory_order_relaxed);
+    atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+    return is_taken;
+}
+
+// any thread, takes the oldest job
+static bool steal(JobWorker *const victim, QueuedJob *const job) {
+    size_t top = atomic_load_explicit(&victim->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    size_t const bottom = atomic_load_explicit(&victim->bottom, memory_order_acquire);
+    if ((ptrdiff_t)(bottom - top) <= 0) return false;
+    read_slot(&victim->queue[top % JOB_QUEUE_CAPACITY], job);
+    return atomic_compare_exchange_strong_explicit(&victim->top, &top, top + 1, memory_order_seq_cst,
+                                                   memory_order_relaxed);
+}
+
+// the own deque first, then every other one starting at a random victim so thieves spread out
+static bool find_job(JobWorker *const worker, QueuedJob *const job) {
+    if (pop(worker, job)) return true;
+    auto const jobs = worker->jobs;
+    uint32_t const start = next_random(worker) % jobs->thread_count;
+    for (uint32_t i = 0; i < jobs->thread_count; ++i) {
+        auto const victim = &jobs->workers[(start + i) % jobs->thread_count];
+        if (victim != worker && steal(victim, job)) return true;
+    }
+    return false;
+}
+
+static void wake_workers(JobSystem *const jobs, uint32_t count) {
+    // pairs with the fence a worker passes between announcing it sleeps and looking for work one last time
+    atomic_thread_fence(memory_order_seq_cst);
+    for (; count; --count) {
+        uint32_t sleeping_count = atomic_load(&jobs->sleeping_count);
+        do {
+            if (!sleeping_count) return;
+        } while (!atomic_compare_exchange_weak(&jobs->sleeping_count, &sleeping_count, sleeping_count - 1));
+#ifdef _WIN32
+        ReleaseSemaphore(jobs->wake_semaphore, 1, nullptr);
+#else
+        sem_post(&jobs->wake_semaphore);
+#endif
+    }
+}
+
+static void run_job(JobSystem *jobs, QueuedJob const *job);
+
+static void enqueue_jobs(JobSystem *const jobs, Job const *const job_list, uint32_t const count,
+                         JobCounter *const counter) {
+    for (uint32_t i = 0; i < count; ++i) {
+        QueuedJob const job = {
+            .job = job_list[i],
+            .counter = counter,
+        };
+        // a full deque runs the job on the spot rather than dropping it
+        if (!push(current_worker, &job)) run_job(jobs, &job);
+    }
+    wake_workers(jobs, count);
+}
+
+static void finish_counted_job(JobSystem *const jobs, JobCounter *const counter) {
+    uint32_t pending = atomic_load_explicit(&counter->pending, memory_order_relaxed);
+    while (pending > 1)
+        if (atomic_compare_exchange_weak_explicit(&counter->pending, &pending, pending - 1, memory_order_acq_rel,
+                                                  memory_order_relaxed)) return;
+
+    // the last job drops the counter to zero under the lock, waiters hold on until it is released so a counter on
+    // their stack outlives this
+    lock(&counter->lock);
+    JobContinuation *continuation = nullptr;
+    if (atomic_fetch_sub_explicit(&counter->pending, 1, memory_order_acq_rel) == 1) {
+        continuation = counter->continuations;
+        counter->continuations = nullptr;
+    }
+    unlock(&counter->lock);
+    while (continuation) {
+        auto const next = continuation->next;
+        enqueue_jobs(jobs, continuation->jobs, continuation->count, continuation->counter);
+        free(continuation);
+        continuation = next;
+    }
+}
+
+static void run_job(JobSystem *const jobs, QueuedJob const *const job) {
+    job->job.function(job->job.data);
+    if (job->counter) finish_counted_job(jobs, job->counter);
+}
+
+static void worker_loop(JobWorker *const worker) {
+    auto const jobs = worker->jobs;
+    current_worker = worker;
+    QueuedJob job;
+    while (!atomic_load_explicit(&jobs->is_quitting, memory_order_acquire)) {
+        bool is_found = false;
+        for (uint32_t spin = 0; spin < IDLE_SPIN_COUNT && !(is_found = find_job(worker, &job)); ++spin) spin_pause();
+        if (is_found) {
+            run_job(jobs, &job);
+            continue;
+        }
+
+        // announce the sleep before the last look, so a submitter either sees the count or this look sees its job
+        atomic_fetch_add(&jobs->sleeping_count, 1);
+        if (find_job(worker, &job)) {
+            // a submitter may already have taken this worker off the count, then the release just wakes it once more
+            uint32_t sleeping_count = atomic_load(&jobs->sleeping_count);
+            while (sleeping_count &&
+                   !atomic_compare_exchange_weak(&jobs->sleeping_count, &sleeping_count, sleeping_count - 1)) {}
+            run_job(jobs, &job);
+            continue;
+        }
+        if (atomic_load_explicit(&jobs->is_quitting, memory_order_acquire)) break;
+#ifdef _WIN32
+        WaitForSingleObject(jobs->wake_semaphore, INFINITE);
+#else
+        while (sem_wait(&jobs->wake_semaphore)) {}
+#endif
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_thread(void *const worker) {
+    worker_loop(worker);
+    return 0;
+}
+#else
+static void *worker_thread(void *const worker) {
+    worker_loop(worker);
+    return nullptr;
+}
+#endif
+
+uint32_t job_system_hardware_thread_count() {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long const count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+#endif
+}
+
+JobSystem *job_system_create(uint32_t thread_count) {
+    if (!thread_count) {
+        // the creating thread only runs jobs while it waits, so the default always starts one worker thread at least
+        thread_count = job_system_hardware_thread_count();
+        if (thread_count < 2) thread_count = 2;
+    }
+    if (thread_count > MAX_JOB_WORKERS) thread_count = MAX_JOB_WORKERS;
+
+    JobSystem *const jobs = calloc(1, sizeof(JobSystem));
+    jobs->thread_count = thread_count;
+    jobs->workers = calloc(thread_count, sizeof(JobWorker));
+#ifdef _WIN32
+    jobs->wake_semaphore = CreateSemaphoreW(nullptr, 0, MAX_JOB_WORKERS, nullptr);
+#else
+    sem_init(&jobs->wake_semaphore, 0, 0);
+#endif
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        jobs->workers[i].jobs = jobs;
+        jobs->workers[i].random_state = 0x9E3779B9u * (i + 1);
+    }
+
+    current_worker = &jobs->workers[0];
+    for (uint32_t i = 1; i < thread_count; ++i) {
+#ifdef _WIN32
+        jobs->workers[i].thread = CreateThread(nullptr, 0, worker_thread, &jobs->workers[i], 0, nullptr);
+#else
+        pthread_create(&jobs->workers[i].thread, nullptr, worker_thread, &jobs->workers[i]);
+#endif
+    }
+    return jobs;
+}
+
+void job_system_destroy(JobSystem *const jobs) {
+    atomic_store_explicit(&jobs->is_quitting, true, memory_order_release);
+    for (uint32_t i = 1; i < jobs->thread_count; ++i) {
+#ifdef _WIN32
+        ReleaseSemaphore(jobs->wake_semaphore, 1, nullptr);
+#else
+        sem_post(&jobs->wake_semaphore);
+#endif
+    }
+    for (uint32_t i = 1; i < jobs->thread_count; ++i) {
+#ifdef _WIN32
+        WaitForSingleObject(jobs->workers[i].thread, INFINITE);
+        CloseHandle(jobs->workers[i].thread);
+#else
+        pthread_join(jobs->workers[i].thread, nullptr);
+#endif
+    }
+#ifdef _WIN32
+    CloseHandle(jobs->wake_semaphore);
+#else
+    sem_destroy(&jobs->wake_semaphore);
+#endif
+    current_worker = nullptr;
+    free(jobs->main_callbacks);
+    free(jobs->running_callbacks);
+    free(jobs->workers);
+    free(jobs);
+}
+
+uint32_t job_system_thread_count(JobSystem const *const jobs) { return jobs->thread_count; }
+
+uint32_t job_system_worker_index(JobSystem const *const jobs) { return (uint32_t)(current_worker - jobs->workers); }
+
+void job_system_submit(JobSystem *const jobs, Job const *const job_list, uint32_t const count,
+                       JobCounter *const counter) {
+    if (counter) atomic_fetch_add_explicit(&counter->pending, count, memory_order_relaxed);
+    enqueue_jobs(jobs, job_list, count, counter);
+}
+
+void job_system_submit_after(JobSystem *const jobs, JobCounter *const dependency, Job const *const job_list,
+                             uint32_t const count, JobCounter *const counter) {
+    if (counter) atomic_fetch_add_explicit(&counter->pending, count, memory_order_relaxed);
+
+    // the lock orders this against the job that brings dependency to zero taking the continuations
+    lock(&dependency->lock);
+    if (atomic_load_explicit(&dependency->pending, memory_order_acquire)) {
+        JobContinuation *const continuation = malloc(sizeof(JobContinuation) + count * sizeof(Job));
+        continuation->next = dependency->continuations;
+        continuation->counter = counter;
+        continuation->count = count;
+        for (uint32_t i = 0; i < count; ++i) continuation->jobs[i] = job_list[i];
+        dependency->continuations = continuation;
+        unlock(&dependency->lock);
+        return;
+    }
+    unlock(&dependency->lock);
+    enqueue_jobs(jobs, job_list, count, counter);
+}
+
+void job_system_wait(JobSystem *const jobs, JobCounter *const counter) {
+    QueuedJob job;
+    while (atomic_load_explicit(&counter->pending, memory_order_acquire) ||
+           atomic_load_explicit(&counter->lock, memory_order_acquire)) {
+        if (find_job(current_worker, &job)) run_job(jobs, &job);
+        else spin_pause();
+    }
+}
+
+void job_system_defer_to_main(JobSystem *const jobs, JobFunction const function, void *const data) {
+    lock(&jobs->main_callback_lock);
+    if (jobs->main_callback_count == jobs->main_callback_capacity) {
+        jobs->main_callback_capacity =
+            jobs->main_callback_capacity ? jobs->main_callback_capacity * 2 : INITIAL_MAIN_CALLBACK_CAPACITY;
+        jobs->main_callbacks = realloc(jobs->main_callbacks, jobs->main_callback_capacity * sizeof(Job));
+    }
+    jobs->main_callbacks[jobs->main_callback_count++] = (Job){
+        .function = function,
+        .data = data,
+    };
+    unlock(&jobs->main_callback_lock);
+}
+
+uint32_t job_system_run_main_callbacks(JobSystem *const jobs) {
+    // swapped out under the lock so callbacks deferring more callbacks do not deadlock, those run next time
+    lock(&jobs->main_callback_lock);
+    auto const callbacks = jobs->main_callbacks;
+    uint32_t const count = jobs->main_callback_count;
+    uint32_t const capacity = jobs->main_callback_capacity;
+    jobs->main_callbacks = jobs->running_callbacks;
+    jobs->main_callback_capacity = jobs->running_callback_capacity;
+    jobs->main_callback_count = 0;
+    unlock(&jobs->main_callback_lock);
+
+    for (uint32_t i = 0; i < count; ++i) callbacks[i].function(callbacks[i].data);
+    jobs->running_callbacks = callbacks;
+    jobs->running_callback_capacity = capacity;
+    return count;
+}
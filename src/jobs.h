@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// job system, one worker thread per core besides the thread that creates it
+// every worker owns a deque, it pushes and pops its own jobs at the bottom and steals from the top of the others when
+// it runs dry, the creating thread is worker 0 and only runs jobs while it waits on a counter
+// only the creating thread and the workers may submit
+
+constexpr uint32_t MAX_JOB_WORKERS = 64;
+constexpr uint32_t JOB_QUEUE_CAPACITY = 4096;
+
+typedef void (*JobFunction)(void *data);
+
+typedef struct {
+    JobFunction function;
+    void *data;
+} Job;
+
+typedef struct JobContinuation JobContinuation;
+
+// counts unfinished jobs, zero initialized is ready to use
+// jobs submitted after a counter run once it drops to zero
+typedef struct {
+    atomic_uint pending;
+    atomic_bool lock;
+    JobContinuation *continuations;
+} JobCounter;
+
+typedef struct JobSystem JobSystem;
+
+uint32_t job_system_hardware_thread_count();
+// thread_count includes the calling thread, 0 picks one per hardware thread but at least 2
+JobSystem *job_system_create(uint32_t thread_count);
+// waits for the workers to finish what they are running, queued jobs are dropped
+void job_system_destroy(JobSystem *jobs);
+uint32_t job_system_thread_count(JobSystem const *jobs);
+// 0 for the creating thread, then 1 up to thread_count - 1, for indexing per worker scratch memory
+uint32_t job_system_worker_index(JobSystem const *jobs);
+
+// counter may be null, otherwise it is raised by count before any job can run
+void job_system_submit(JobSystem *jobs, Job const *job_list, uint32_t count, JobCounter *counter);
+// queues the jobs once dependency reaches zero, counter is raised right away
+void job_system_submit_after(JobSystem *jobs, JobCounter *dependency, Job const *job_list, uint32_t count,
+                             JobCounter *counter);
+// runs other jobs until counter reaches zero
+void job_system_wait(JobSystem *jobs, JobCounter *counter);
+
+// for work that has to finish on the render thread, such as recording uploads
+void job_system_defer_to_main(JobSystem *jobs, JobFunction function, void *data);
+// runs the callbacks deferred so far on the calling thread, returns how many ran
+uint32_t job_system_run_main_callbacks(JobSystem *jobs);
@@ -0,0 +1,198 @@
+#include "ktx2.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static uint8_t const identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+constexpr size_t HEADER_SIZE = 80;
+constexpr size_t LEVEL_INDEX_ENTRY_SIZE = 24;
+
+// data format descriptor constants from the khronos data format specification
+enum {
+    DF_MODEL_RGBSDA = 1,
+    DF_MODEL_BC1A = 128,
+    DF_MODEL_BC7 = 134,
+    DF_PRIMARIES_BT709 = 1,
+    DF_TRANSFER_SRGB = 2,
+    DF_FLAG_ALPHA_PREMULTIPLIED = 1,
+    DF_CHANNEL_RED = 0,
+    DF_CHANNEL_GREEN = 1,
+    DF_CHANNEL_BLUE = 2,
+    DF_CHANNEL_ALPHA = 15,
+    DF_SAMPLE_LINEAR = 0x10,
+};
+
+static uint32_t read_le32(uint8_t const *const bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+static uint64_t read_le64(uint8_t const *const bytes) {
+    return (uint64_t)read_le32(bytes) | (uint64_t)read_le32(bytes + 4) << 32;
+}
+
+static void write_le32(uint8_t *const bytes, uint32_t const value) {
+    for (uint32_t i = 0; i < 4; ++i) bytes[i] = (uint8_t)(value >> i * 8);
+}
+
+static void write_le64(uint8_t *const bytes, uint64_t const value) {
+    write_le32(bytes, (uint32_t)value);
+    write_le32(bytes + 4, (uint32_t)(value >> 32));
+}
+
+uint32_t ktx2_format_block_size(VkFormat const format) {
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return 8;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK: return 16;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_B8G8R8A8_UNORM:
+        case VK_FORMAT_B8G8R8A8_SRGB: return 4;
+        default: return 0;
+    }
+}
+
+bool ktx2_is_block_compressed(VkFormat const format) { return ktx2_format_block_size(format) > 4; }
+
+size_t ktx2_level_size(VkFormat const format, uint32_t const width, uint32_t const height, uint32_t const level) {
+    size_t level_width = width >> level ? width >> level : 1;
+    size_t level_height = height >> level ? height >> level : 1;
+    if (ktx2_is_block_compressed(format)) {
+        level_width = (level_width + 3) / 4;
+        level_height = (level_height + 3) / 4;
+    }
+    return level_width * level_height * ktx2_format_block_size(format);
+}
+
+bool ktx2_read_info(void const *const data, size_t const size, Ktx2Info *const info) {
+    auto const bytes = (uint8_t const*)data;
+    if (size < HEADER_SIZE || memcmp(bytes, identifier, sizeof(identifier))) return false;
+
+    *info = (Ktx2Info){
+        .format = (VkFormat)read_le32(bytes + 12),
+        .width = read_le32(bytes + 20),
+        .height = read_le32(bytes + 24),
+        .level_count = read_le32(bytes + 40),
+    };
+    uint32_t const depth = read_le32(bytes + 28);
+    uint32_t const layer_count = read_le32(bytes + 32);
+    uint32_t const face_count = read_le32(bytes + 36);
+    uint32_t const supercompression_scheme = read_le32(bytes + 44);
+    if (!ktx2_format_block_size(info->format) || !info->width || !info->height || depth || layer_count > 1 ||
+        face_count != 1 || supercompression_scheme)
+        return false;
+
+    // a level count of 0 asks the loader to generate the mips
+    if (!info->level_count) info->level_count = 1;
+    if (info->level_count > KTX2_MAX_LEVELS ||
+        (info->width >> (info->level_count - 1) == 0 && info->height >> (info->level_count - 1) == 0))
+        return false;
+    if (size < HEADER_SIZE + info->level_count * LEVEL_INDEX_ENTRY_SIZE) return false;
+
+    for (uint32_t i = 0; i < info->level_count; ++i) {
+        auto const entry = bytes + HEADER_SIZE + i * LEVEL_INDEX_ENTRY_SIZE;
+        info->levels[i] = (Ktx2Level){
+            .offset = read_le64(entry),
+            .size = read_le64(entry + 8),
+        };
+        if (info->levels[i].offset > size || info->levels[i].size > size - info->levels[i].offset ||
+            info->levels[i].size != ktx2_level_size(info->format, info->width, info->height, i))
+            return false;
+    }
+    return true;
+}
+
+static uint32_t build_data_format_descriptor(VkFormat const format, uint8_t *const descriptor) {
+    uint32_t const block_size = ktx2_format_block_size(format);
+    bool const is_compressed = ktx2_is_block_compressed(format);
+    bool const is_bgra = format == VK_FORMAT_B8G8R8A8_SRGB || format == VK_FORMAT_B8G8R8A8_UNORM;
+    bool const is_srgb = format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK ||
+                         format == VK_FORMAT_BC7_SRGB_BLOCK || format == VK_FORMAT_R8G8B8A8_SRGB ||
+                         format == VK_FORMAT_B8G8R8A8_SRGB;
+    uint32_t const sample_count = is_compressed ? 1 : 4;
+    uint32_t const block_byte_size = 24 + sample_count * 16;
+
+    uint8_t model = DF_MODEL_RGBSDA;
+    if (format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK) model = DF_MODEL_BC1A;
+    if (format == VK_FORMAT_BC7_UNORM_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK) model = DF_MODEL_BC7;
+
+    memset(descriptor, 0, 4 + block_byte_size);
+    write_le32(descriptor, 4 + block_byte_size);
+    auto const block = descriptor + 4;
+    // vendor and descriptor type are both 0 for the basic descriptor block, version 2
+    write_le32(block + 4, 2 | block_byte_size << 16);
+    block[8] = model;
+    block[9] = DF_PRIMARIES_BT709;
+    block[10] = is_srgb ? DF_TRANSFER_SRGB : 1;
+    block[11] = DF_FLAG_ALPHA_PREMULTIPLIED;
+    // texel block dimensions are stored minus one
+    block[12] = is_compressed ? 3 : 0;
+    block[13] = is_compressed ? 3 : 0;
+    block[16] = (uint8_t)block_size;
+
+    auto const samples = block + 24;
+    if (is_compressed) {
+        // one sample spanning the whole block
+        write_le32(samples, (block_size * 8 - 1) << 16);
+        write_le32(samples + 12, UINT32_MAX);
+        return 4 + block_byte_size;
+    }
+    uint8_t const channels[4] = {
+        is_bgra ? DF_CHANNEL_BLUE : DF_CHANNEL_RED, DF_CHANNEL_GREEN, is_bgra ? DF_CHANNEL_RED : DF_CHANNEL_BLUE,
+        DF_CHANNEL_ALPHA | DF_SAMPLE_LINEAR
+    };
+    for (uint32_t i = 0; i < 4; ++i) {
+        write_le32(samples + i * 16, i * 8 | 7 << 16 | (uint32_t)channels[i] << 24);
+        write_le32(samples + i * 16 + 12, 255);
+    }
+    return 4 + block_byte_size;
+}
+
+void *ktx2_write(VkFormat const format, uint32_t const width, uint32_t const height, uint32_t const level_count,
+                 void const *const *const levels, size_t *const size) {
+    if (!ktx2_format_block_size(format) || !level_count || level_count > KTX2_MAX_LEVELS) return nullptr;
+
+    uint8_t descriptor[4 + 24 + 4 * 16];
+    uint32_t const descriptor_size = build_data_format_descriptor(format, descriptor);
+    size_t const descriptor_offset = HEADER_SIZE + level_count * LEVEL_INDEX_ENTRY_SIZE;
+
+    // levels are stored smallest first, each aligned to the texel block size and to 4 bytes
+    size_t const alignment = ktx2_format_block_size(format) > 4 ? ktx2_format_block_size(format) : 4;
+    size_t level_offsets[KTX2_MAX_LEVELS];
+    size_t cursor = descriptor_offset + descriptor_size;
+    for (uint32_t i = level_count; i-- > 0;) {
+        cursor = (cursor + alignment - 1) / alignment * alignment;
+        level_offsets[i] = cursor;
+        cursor += ktx2_level_size(format, width, height, i);
+    }
+
+    uint8_t *const bytes = calloc(cursor, 1);
+    if (!bytes) return nullptr;
+    memcpy(bytes, identifier, sizeof(identifier));
+    write_le32(bytes + 12, (uint32_t)format);
+    // type size is 1 for block compressed and 8 bit formats alike
+    write_le32(bytes + 16, 1);
+    write_le32(bytes + 20, width);
+    write_le32(bytes + 24, height);
+    write_le32(bytes + 36, 1);
+    write_le32(bytes + 40, level_count);
+    write_le32(bytes + 48, (uint32_t)descriptor_offset);
+    write_le32(bytes + 52, descriptor_size);
+
+    for (uint32_t i = 0; i < level_count; ++i) {
+        size_t const level_size = ktx2_level_size(format, width, height, i);
+        auto const entry = bytes + HEADER_SIZE + i * LEVEL_INDEX_ENTRY_SIZE;
+        write_le64(entry, level_offsets[i]);
+        write_le64(entry + 8, level_size);
+        write_le64(entry + 16, level_size);
+        memcpy(bytes + level_offsets[i], levels[i], level_size);
+    }
+    memcpy(bytes + descriptor_offset, descriptor, descriptor_size);
+
+    *size = cursor;
+    return bytes;
+}
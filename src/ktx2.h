@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+// ktx2 containers holding one 2d texture with its mip chain, no supercompression
+// block compressed data is stored exactly as vulkan expects it, so levels copy straight into the staging ring
+
+constexpr uint32_t KTX2_MAX_LEVELS = 16;
+
+typedef struct {
+    uint64_t offset, size;
+} Ktx2Level;
+
+typedef struct {
+    VkFormat format;
+    uint32_t width, height;
+    // 1 when the file only holds the base level and the mips are left to the loader
+    uint32_t level_count;
+    // level 0 is the full size image, offsets are from the start of the file
+    Ktx2Level levels[KTX2_MAX_LEVELS];
+} Ktx2Info;
+
+// validates the header and level index against size, rejects arrays, cubemaps, 3d and supercompressed files
+bool ktx2_read_info(void const *data, size_t size, Ktx2Info *info);
+
+// bytes per 4x4 block for the block compressed formats, bytes per texel for the rest, 0 when unsupported
+uint32_t ktx2_format_block_size(VkFormat format);
+bool ktx2_is_block_compressed(VkFormat format);
+size_t ktx2_level_size(VkFormat format, uint32_t width, uint32_t height, uint32_t level);
+
+// levels[i] points at the data of level i, the result is allocated with malloc
+void *ktx2_write(VkFormat format, uint32_t width, uint32_t height, uint32_t level_count, void const *const *levels,
+                 size_t *size);
@@ -0,0 +1,552 @@
+#include "light.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "mesher.h"
+
+enum {
+    LIGHT_CHANNEL_SKY,
+    LIGHT_CHANNEL_BLOCK,
+    LIGHT_CHANNEL_COUNT,
+};
+
+// what a message asks of the voxel it names
+enum {
+    // take the level if it is brighter
+    MESSAGE_ADD,
+    // the neighbor lost the level it had, clear what it lit or spread again if brighter
+    MESSAGE_REMOVE,
+    // the neighbor turned transparent, spread into it
+    MESSAGE_RELIGHT,
+};
+
+// the voxel index in the low bits, then the level, the kind, the channel and whether the step went down
+constexpr uint32_t MESSAGE_VOXEL_MASK = CHUNK_VOLUME - 1;
+constexpr uint32_t MESSAGE_LEVEL_SHIFT = 16;
+constexpr uint32_t MESSAGE_KIND_SHIFT = 20;
+constexpr uint32_t MESSAGE_CHANNEL_SHIFT = 22;
+constexpr uint32_t MESSAGE_DOWN = 1u << 23;
+constexpr uint32_t REMOVAL_LEVEL_SHIFT = 16;
+constexpr uint32_t EDIT_BLOCK_SHIFT = 16;
+constexpr uint32_t INITIAL_MESSAGE_CAPACITY = 256;
+constexpr uint32_t INITIAL_BATCH_CAPACITY = 64;
+
+static int32_t const face_offsets[CHUNK_FACE_COUNT][3] = {
+    {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1},
+};
+
+// where each axis lives in a voxel index, x y z as CHUNK_FACE_* orders them
+static uint32_t const axis_shifts[3] = {0, CHUNK_SIZE_LOG2 * 2, CHUNK_SIZE_LOG2};
+
+typedef struct {
+    uint32_t count, capacity;
+    uint32_t *items;
+} MessageList;
+
+typedef struct {
+    LightBatch *batch;
+    Chunk *chunk;
+    // lit from scratch in the next pass
+    bool needs_seed;
+    // bit f is set when the neighbor through face f is lit from scratch and takes in the light along that border
+    uint8_t border_requests;
+    bool changed;
+    uint8_t min[3], max[3];
+    MessageList inbox;
+    // by the face the messages leave through, their voxel indices are already the ones in the neighbor
+    MessageList outboxes[CHUNK_FACE_COUNT];
+    // voxel index and the old block above EDIT_BLOCK_SHIFT
+    MessageList edits;
+} LightChunk;
+
+struct LightBatch {
+    World const *world;
+    LightScratch *scratches;
+    JobSystem *jobs;
+    JobCounter *counter;
+    JobCounter pass_counter;
+    bool is_started;
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+    LightChunk *chunks;
+    // index into chunks plus one, keyed by the chunk address, always a power of two kept at most half full
+    uint32_t slot_capacity;
+    uint32_t *slots;
+    // both chunk_capacity long
+    Job *pass_jobs;
+    LightChange *changes;
+    uint32_t change_count;
+};
+
+// one chunk in one pass
+typedef struct {
+    LightChunk *state;
+    LightScratch *scratch;
+    uint8_t *light;
+    bool is_open_sky;
+    uint32_t channel;
+    uint32_t removal_count;
+    uint32_t addition_head;
+    uint32_t addition_count;
+} LightPass;
+
+static void push_message(MessageList *const list, uint32_t const message) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : INITIAL_MESSAGE_CAPACITY;
+        list->items = realloc(list->items, list->capacity * sizeof(uint32_t));
+    }
+    list->items[list->count++] = message;
+}
+
+static uint32_t hash_chunk_address(Chunk const *const chunk) {
+    uint64_t const hash = (uint64_t)(uintptr_t)chunk * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(hash >> 32);
+}
+
+// the slot holding the chunk, or the empty slot where it would be inserted
+static uint32_t *find_slot(LightBatch const *const batch, Chunk const *const chunk) {
+    uint32_t const mask = batch->slot_capacity - 1;
+    for (uint32_t i = hash_chunk_address(chunk) & mask;; i = (i + 1) & mask) {
+        auto const slot = &batch->slots[i];
+        if (!*slot || batch->chunks[*slot - 1].chunk == chunk) return slot;
+    }
+}
+
+static LightChunk *get_or_add_chunk(LightBatch *const batch, Chunk *const chunk) {
+    auto slot = find_slot(batch, chunk);
+    if (*slot) return &batch->chunks[*slot - 1];
+
+    if (batch->chunk_count == batch->chunk_capacity) {
+        batch->chunk_capacity = batch->chunk_capacity ? batch->chunk_capacity * 2 : INITIAL_BATCH_CAPACITY;
+        batch->chunks = realloc(batch->chunks, batch->chunk_capacity * sizeof(LightChunk));
+        batch->pass_jobs = realloc(batch->pass_jobs, batch->chunk_capacity * sizeof(Job));
+        batch->changes = realloc(batch->changes, batch->chunk_capacity * sizeof(LightChange));
+    }
+    if (2 * (batch->chunk_count + 1) > batch->slot_capacity) {
+        free(batch->slots);
+        batch->slot_capacity *= 2;
+        batch->slots = calloc(batch->slot_capacity, sizeof(uint32_t));
+        for (uint32_t i = 0; i < batch->chunk_count; ++i) *find_slot(batch, batch->chunks[i].chunk) = i + 1;
+        slot = find_slot(batch, chunk);
+    }
+    batch->chunks[batch->chunk_count] = (LightChunk){.batch = batch, .chunk = chunk};
+    *slot = ++batch->chunk_count;
+    return &batch->chunks[batch->chunk_count - 1];
+}
+
+static Chunk *get_neighbor_chunk(LightBatch const *const batch, Chunk const *const chunk, uint32_t const face) {
+    auto const offset = face_offsets[face];
+    return world_get_chunk(batch->world, chunk->x + offset[0], chunk->y + offset[1], chunk->z + offset[2]);
+}
+
+// pass
+
+static BlockId get_voxel_block(Chunk const *const chunk, uint32_t const voxel) {
+    return chunk->palette[chunk_get_palette_index(chunk, voxel)];
+}
+
+static void load_opacity(LightScratch *const scratch, Chunk const *const chunk) {
+    if (!chunk->bits_per_index) {
+        memset(scratch->opaque, is_block_opaque(chunk->palette[0]) ? 0xFF : 0, sizeof(scratch->opaque));
+        return;
+    }
+    for (uint32_t word = 0; word < CHUNK_VOLUME / 64; ++word) {
+        uint64_t bits = 0;
+        for (uint32_t i = 0; i < 64; ++i)
+            bits |= (uint64_t)is_block_opaque(get_voxel_block(chunk, word * 64 + i)) << i;
+        scratch->opaque[word] = bits;
+    }
+}
+
+static bool is_opaque(LightPass const *const pass, uint32_t const voxel) {
+    return pass->scratch->opaque[voxel / 64] >> voxel % 64 & 1;
+}
+
+static uint32_t get_level(LightPass const *const pass, uint32_t const voxel) {
+    return pass->channel == LIGHT_CHANNEL_SKY ? pass->light[voxel] >> LIGHT_SKY_SHIFT
+                                              : pass->light[voxel] & LIGHT_BLOCK_MASK;
+}
+
+static void mark_changed(LightChunk *const state, uint32_t const voxel) {
+    uint8_t coordinates[3];
+    for (uint32_t axis = 0; axis < 3; ++axis) coordinates[axis] = voxel >> axis_shifts[axis] & (CHUNK_SIZE - 1);
+    if (!state->changed) {
+        state->changed = true;
+        memcpy(state->min, coordinates, sizeof(coordinates));
+        memcpy(state->max, coordinates, sizeof(coordinates));
+        return;
+    }
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        if (coordinates[axis] < state->min[axis]) state->min[axis] = coordinates[axis];
+        if (coordinates[axis] > state->max[axis]) state->max[axis] = coordinates[axis];
+    }
+}
+
+static void set_level(LightPass *const pass, uint32_t const voxel, uint32_t const level) {
+    auto const light = &pass->light[voxel];
+    *light = pass->channel == LIGHT_CHANNEL_SKY ? (uint8_t)((*light & LIGHT_BLOCK_MASK) | level << LIGHT_SKY_SHIFT)
+                                                : (uint8_t)((*light & ~LIGHT_BLOCK_MASK) | level);
+    mark_changed(pass->state, voxel);
+}
+
+static void push_addition(LightPass *const pass, uint32_t const voxel) {
+    auto const queued = &pass->scratch->queued[voxel / 64];
+    if (*queued >> voxel % 64 & 1) return;
+    *queued |= 1ull << voxel % 64;
+    pass->scratch->additions[(pass->addition_head + pass->addition_count++) & (CHUNK_VOLUME - 1)] = (uint16_t)voxel;
+}
+
+// a voxel is only pushed when its light drops to zero, so it is pushed at most once
+static void push_removal(LightPass *const pass, uint32_t const voxel, uint32_t const level) {
+    pass->scratch->removals[pass->removal_count++] = voxel | level << REMOVAL_LEVEL_SHIFT;
+}
+
+static void send_message(LightPass *const pass, uint32_t const face, uint32_t const voxel, uint32_t const kind,
+                         uint32_t const level) {
+    auto const down = kind == MESSAGE_REMOVE && face == CHUNK_FACE_NEGATIVE_Y ? MESSAGE_DOWN : 0;
+    push_message(&pass->state->outboxes[face], voxel | level << MESSAGE_LEVEL_SHIFT | kind << MESSAGE_KIND_SHIFT |
+                                                   pass->channel << MESSAGE_CHANNEL_SHIFT | down);
+}
+
+// the neighbor of voxel through face, false when it lies in the neighbor chunk, which neighbor then indexes
+static bool step_voxel(uint32_t const voxel, uint32_t const face, uint32_t *const neighbor) {
+    auto const shift = axis_shifts[face / 2];
+    uint32_t const coordinate = voxel >> shift & (CHUNK_SIZE - 1);
+    uint32_t const stepped = (coordinate + (face & 1 ? 1 : CHUNK_SIZE - 1)) & (CHUNK_SIZE - 1);
+    *neighbor = (voxel & ~((CHUNK_SIZE - 1) << shift)) | stepped << shift;
+    return face & 1 ? coordinate < CHUNK_SIZE - 1 : coordinate > 0;
+}
+
+// full sky light falls without losing a level
+static uint32_t spread_level(LightPass const *const pass, uint32_t const level, uint32_t const face) {
+    return pass->channel == LIGHT_CHANNEL_SKY && face == CHUNK_FACE_NEGATIVE_Y && level == LIGHT_MAX ? LIGHT_MAX
+                                                                                                   : level - 1;
+}
+
+// a neighbor lost old_level, light it could have given is cleared, brighter light spreads back in
+static void remove_from(LightPass *const pass, uint32_t const voxel, uint32_t const old_level, bool const down) {
+    auto const level = get_level(pass, voxel);
+    if (!level) return;
+    bool const is_fallen_sky =
+        pass->channel == LIGHT_CHANNEL_SKY && down && old_level == LIGHT_MAX && level == LIGHT_MAX;
+    if (level >= old_level && !is_fallen_sky) {
+        push_addition(pass, voxel);
+        return;
+    }
+    set_level(pass, voxel, 0);
+    push_removal(pass, voxel, level);
+    if (pass->channel == LIGHT_CHANNEL_BLOCK) {
+        auto const emission = block_light_emission(get_voxel_block(pass->state->chunk, voxel));
+        if (emission) {
+            set_level(pass, voxel, emission);
+            push_addition(pass, voxel);
+        }
+    }
+}
+
+static void run_removals(LightPass *const pass) {
+    for (uint32_t i = 0; i < pass->removal_count; ++i) {
+        auto const removal = pass->scratch->removals[i];
+        uint32_t const voxel = removal & MESSAGE_VOXEL_MASK, old_level = removal >> REMOVAL_LEVEL_SHIFT;
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+            uint32_t neighbor;
+            if (step_voxel(voxel, face, &neighbor))
+                remove_from(pass, neighbor, old_level, face == CHUNK_FACE_NEGATIVE_Y);
+            else send_message(pass, face, neighbor, MESSAGE_REMOVE, old_level);
+        }
+    }
+    pass->removal_count = 0;
+}
+
+static void run_additions(LightPass *const pass) {
+    auto const scratch = pass->scratch;
+    while (pass->addition_count) {
+        uint32_t const voxel = scratch->additions[pass->addition_head];
+        pass->addition_head = (pass->addition_head + 1) & (CHUNK_VOLUME - 1);
+        --pass->addition_count;
+        scratch->queued[voxel / 64] &= ~(1ull << voxel % 64);
+
+        auto const level = get_level(pass, voxel);
+        if (level <= 1) continue;
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+            auto const spread = spread_level(pass, level, face);
+            uint32_t neighbor;
+            if (!step_voxel(voxel, face, &neighbor)) send_message(pass, face, neighbor, MESSAGE_ADD, spread);
+            else if (!is_opaque(pass, neighbor) && get_level(pass, neighbor) < spread) {
+                set_level(pass, neighbor, spread);
+                push_addition(pass, neighbor);
+            }
+        }
+    }
+}
+
+// full sky light straight down every open column, only voxels with darker neighbors to light start the fill
+static void seed_sky(LightPass *const pass) {
+    if (!pass->is_open_sky) return;
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x)
+            for (auto y = (int32_t)CHUNK_SIZE - 1; y >= 0; --y) {
+                auto const voxel = chunk_voxel_index(x, (uint32_t)y, z);
+                if (is_opaque(pass, voxel)) break;
+                pass->light[voxel] |= LIGHT_MAX << LIGHT_SKY_SHIFT;
+            }
+
+    for (uint32_t voxel = 0; voxel < CHUNK_VOLUME; ++voxel) {
+        if (get_level(pass, voxel) != LIGHT_MAX) continue;
+        bool is_seed = voxel >> axis_shifts[1] == 0;
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT && !is_seed; ++face) {
+            if (face / 2 == 1) continue;
+            uint32_t neighbor;
+            is_seed = !step_voxel(voxel, face, &neighbor) ||
+                      (!is_opaque(pass, neighbor) && get_level(pass, neighbor) < LIGHT_MAX);
+        }
+        if (is_seed) push_addition(pass, voxel);
+    }
+}
+
+static void seed_emitters(LightPass *const pass) {
+    auto const chunk = pass->state->chunk;
+    bool has_emitter = false;
+    for (uint32_t i = 0; i < chunk->palette_count; ++i) has_emitter |= block_light_emission(chunk->palette[i]) > 0;
+    if (!has_emitter) return;
+    for (uint32_t voxel = 0; voxel < CHUNK_VOLUME; ++voxel) {
+        auto const emission = block_light_emission(get_voxel_block(chunk, voxel));
+        if (!emission) continue;
+        set_level(pass, voxel, emission);
+        push_addition(pass, voxel);
+    }
+}
+
+// the lit voxels along a border spread again, which sends their light across it
+static void seed_borders(LightPass *const pass) {
+    for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+        if (!(pass->state->border_requests >> face & 1)) continue;
+        uint32_t min[3] = {}, max[3] = {CHUNK_SIZE - 1, CHUNK_SIZE - 1, CHUNK_SIZE - 1};
+        min[face / 2] = max[face / 2] = face & 1 ? CHUNK_SIZE - 1 : 0;
+        for (auto y = min[1]; y <= max[1]; ++y)
+            for (auto z = min[2]; z <= max[2]; ++z)
+                for (auto x = min[0]; x <= max[0]; ++x) {
+                    auto const voxel = chunk_voxel_index(x, y, z);
+                    if (get_level(pass, voxel)) push_addition(pass, voxel);
+                }
+    }
+}
+
+// an opaque block takes the light of its voxel away, so does a removed emitter
+static void remove_edited_light(LightPass *const pass) {
+    auto const edits = &pass->state->edits;
+    for (uint32_t i = 0; i < edits->count; ++i) {
+        uint32_t const voxel = edits->items[i] & MESSAGE_VOXEL_MASK;
+        auto const old_block = (BlockId)(edits->items[i] >> EDIT_BLOCK_SHIFT);
+        auto const level = get_level(pass, voxel);
+        if (level && (is_opaque(pass, voxel) ||
+                      (pass->channel == LIGHT_CHANNEL_BLOCK && block_light_emission(old_block)))) {
+            set_level(pass, voxel, 0);
+            push_removal(pass, voxel, level);
+        }
+    }
+}
+
+// a new emitter lights its voxel, a transparent block lets the light around it in
+static void add_edited_light(LightPass *const pass) {
+    auto const edits = &pass->state->edits;
+    for (uint32_t i = 0; i < edits->count; ++i) {
+        uint32_t const voxel = edits->items[i] & MESSAGE_VOXEL_MASK;
+        if (pass->channel == LIGHT_CHANNEL_BLOCK) {
+            auto const emission = block_light_emission(get_voxel_block(pass->state->chunk, voxel));
+            if (emission > get_level(pass, voxel)) {
+                set_level(pass, voxel, emission);
+                push_addition(pass, voxel);
+            }
+        }
+        if (is_opaque(pass, voxel)) continue;
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+            uint32_t neighbor;
+            if (!step_voxel(voxel, face, &neighbor)) send_message(pass, face, neighbor, MESSAGE_RELIGHT, 0);
+            else if (get_level(pass, neighbor)) push_addition(pass, neighbor);
+        }
+        if (pass->channel == LIGHT_CHANNEL_SKY && pass->is_open_sky && voxel >> axis_shifts[1] == CHUNK_SIZE - 1) {
+            set_level(pass, voxel, LIGHT_MAX);
+            push_addition(pass, voxel);
+        }
+    }
+}
+
+static void receive_messages(LightPass *const pass, bool const removals) {
+    auto const inbox = &pass->state->inbox;
+    for (uint32_t i = 0; i < inbox->count; ++i) {
+        auto const message = inbox->items[i];
+        if ((message >> MESSAGE_CHANNEL_SHIFT & 1) != pass->channel) continue;
+        uint32_t const voxel = message & MESSAGE_VOXEL_MASK, level = message >> MESSAGE_LEVEL_SHIFT & 0xF;
+        uint32_t const kind = message >> MESSAGE_KIND_SHIFT & 3;
+        if ((kind == MESSAGE_REMOVE) != removals) continue;
+        if (kind == MESSAGE_REMOVE) {
+            remove_from(pass, voxel, level, message & MESSAGE_DOWN);
+        } else if (kind == MESSAGE_RELIGHT) {
+            if (get_level(pass, voxel)) push_addition(pass, voxel);
+        } else if (!is_opaque(pass, voxel) && get_level(pass, voxel) < level) {
+            set_level(pass, voxel, level);
+            push_addition(pass, voxel);
+        }
+    }
+}
+
+// every removal runs before any light spreads, so the fill never spreads light that is about to be cleared
+static void light_channel(LightPass *const pass, uint32_t const channel, bool const seed) {
+    pass->channel = channel;
+    receive_messages(pass, true);
+    remove_edited_light(pass);
+    run_removals(pass);
+
+    if (seed && channel == LIGHT_CHANNEL_SKY) seed_sky(pass);
+    if (seed && channel == LIGHT_CHANNEL_BLOCK) seed_emitters(pass);
+    seed_borders(pass);
+    add_edited_light(pass);
+    receive_messages(pass, false);
+    run_additions(pass);
+}
+
+static void light_pass_job(void *const data) {
+    LightChunk *const state = data;
+    auto const batch = state->batch;
+    auto const chunk = state->chunk;
+    bool const seed = state->needs_seed;
+    if (seed) {
+        if (chunk->light) memset(chunk->light, 0, CHUNK_VOLUME);
+        else chunk->light = calloc(CHUNK_VOLUME, 1);
+        mark_changed(state, 0);
+        mark_changed(state, CHUNK_VOLUME - 1);
+    }
+    LightPass pass = {
+        .state = state,
+        .scratch = &batch->scratches[job_system_worker_index(batch->jobs)],
+        .light = chunk->light,
+        .is_open_sky = !get_neighbor_chunk(batch, chunk, CHUNK_FACE_POSITIVE_Y),
+    };
+    load_opacity(pass.scratch, chunk);
+    for (uint32_t channel = 0; channel < LIGHT_CHANNEL_COUNT; ++channel) light_channel(&pass, channel, seed);
+
+    state->needs_seed = false;
+    state->border_requests = 0;
+    state->inbox.count = 0;
+    state->edits.count = 0;
+}
+
+// batch
+
+// the lit neighbors of a chunk lit from scratch send it the light along their borders
+static void request_borders(LightBatch *const batch) {
+    for (uint32_t i = 0, count = batch->chunk_count; i < count; ++i) {
+        if (!batch->chunks[i].needs_seed) continue;
+        auto const chunk = batch->chunks[i].chunk;
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+            auto const neighbor = get_neighbor_chunk(batch, chunk, face);
+            if (!neighbor || !neighbor->light) continue;
+            auto const state = get_or_add_chunk(batch, neighbor);
+            if (!state->needs_seed) state->border_requests |= (uint8_t)(1u << (face ^ 1));
+        }
+    }
+}
+
+// messages to a chunk that is not loaded or not lit are dropped, it is lit from scratch once it is
+static void route_messages(LightBatch *const batch) {
+    for (uint32_t i = 0; i < batch->chunk_count; ++i)
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+            if (!batch->chunks[i].outboxes[face].count) continue;
+            auto const neighbor = get_neighbor_chunk(batch, batch->chunks[i].chunk, face);
+            if (neighbor && neighbor->light) {
+                auto const inbox = &get_or_add_chunk(batch, neighbor)->inbox;
+                // adding the neighbor may have moved the chunks
+                auto const outbox = &batch->chunks[i].outboxes[face];
+                for (uint32_t j = 0; j < outbox->count; ++j) push_message(inbox, outbox->items[j]);
+            }
+            batch->chunks[i].outboxes[face].count = 0;
+        }
+}
+
+// runs between passes, alone, so it is free to touch every chunk state
+static void schedule_pass_job(void *const data) {
+    LightBatch *const batch = data;
+    if (!batch->is_started) {
+        batch->is_started = true;
+        request_borders(batch);
+    }
+    route_messages(batch);
+
+    uint32_t pass_job_count = 0;
+    for (uint32_t i = 0; i < batch->chunk_count; ++i) {
+        auto const state = &batch->chunks[i];
+        if (state->needs_seed || state->border_requests || state->inbox.count || state->edits.count)
+            batch->pass_jobs[pass_job_count++] = (Job){.function = light_pass_job, .data = state};
+    }
+    if (pass_job_count) {
+        job_system_submit(batch->jobs, batch->pass_jobs, pass_job_count, &batch->pass_counter);
+        job_system_submit_after(batch->jobs, &batch->pass_counter,
+                                &(Job){.function = schedule_pass_job, .data = batch}, 1, batch->counter);
+        return;
+    }
+
+    batch->change_count = 0;
+    for (uint32_t i = 0; i < batch->chunk_count; ++i) {
+        auto const state = &batch->chunks[i];
+        if (!state->changed) continue;
+        auto const change = &batch->changes[batch->change_count++];
+        *change = (LightChange){.chunk = state->chunk};
+        memcpy(change->min, state->min, sizeof(change->min));
+        memcpy(change->max, state->max, sizeof(change->max));
+    }
+}
+
+LightBatch *light_batch_create(World const *const world, LightScratch *const scratches) {
+    LightBatch *const batch = calloc(1, sizeof(LightBatch));
+    batch->world = world;
+    batch->scratches = scratches;
+    batch->slot_capacity = 2 * INITIAL_BATCH_CAPACITY;
+    batch->slots = calloc(batch->slot_capacity, sizeof(uint32_t));
+    return batch;
+}
+
+void light_batch_destroy(LightBatch *const batch) {
+    for (uint32_t i = 0; i < batch->chunk_count; ++i) {
+        auto const state = &batch->chunks[i];
+        free(state->inbox.items);
+        free(state->edits.items);
+        for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) free(state->outboxes[face].items);
+    }
+    free(batch->chunks);
+    free(batch->slots);
+    free(batch->pass_jobs);
+    free(batch->changes);
+    free(batch);
+}
+
+void light_batch_add_chunk(LightBatch *const batch, Chunk *const chunk) {
+    get_or_add_chunk(batch, chunk)->needs_seed = true;
+}
+
+void light_batch_set_block(LightBatch *const batch, int32_t const x, int32_t const y, int32_t const z,
+                           BlockId const old_block) {
+    auto const chunk = world_get_chunk(batch->world, x >> CHUNK_SIZE_LOG2, y >> CHUNK_SIZE_LOG2, z >> CHUNK_SIZE_LOG2);
+    // an unlit chunk has no light to update
+    if (!chunk || !chunk->light) return;
+    auto const state = get_or_add_chunk(batch, chunk);
+    if (state->needs_seed) return;
+    auto const voxel = chunk_voxel_index((uint32_t)x & (CHUNK_SIZE - 1), (uint32_t)y & (CHUNK_SIZE - 1),
+                                         (uint32_t)z & (CHUNK_SIZE - 1));
+    push_message(&state->edits, voxel | (uint32_t)old_block << EDIT_BLOCK_SHIFT);
+}
+
+void light_batch_submit(LightBatch *const batch, JobSystem *const jobs, JobCounter *const dependency,
+                        JobCounter *const counter) {
+    batch->jobs = jobs;
+    batch->counter = counter;
+    Job const job = {.function = schedule_pass_job, .data = batch};
+    if (dependency) job_system_submit_after(jobs, dependency, &job, 1, counter);
+    else job_system_submit(jobs, &job, 1, counter);
+}
+
+uint32_t light_batch_get_changes(LightBatch const *const batch, LightChange const **const changes) {
+    *changes = batch->changes;
+    return batch->change_count;
+}
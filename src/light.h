@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "chunk.h"
+#include "jobs.h"
+
+// voxel light, a sky and a block level from 0 to LIGHT_MAX in every voxel, stored in Chunk.light
+// light spreads by breadth first flood fills that lose a level per step, except that full sky light falls straight
+// down without losing any, so open columns are lit all the way to the ground
+// a batch lights chunks in passes on the workers, a pass runs one job per chunk with work and writes nothing outside
+// of that chunk, light that crosses a border is sent as a message the neighbor picks up in the next pass, so passes
+// need no locks and the batch is done once a pass sends no more messages
+// removal runs the same way, the old light is cleared along the paths it spread over and the brighter voxels at the
+// edge of the cleared region light it again, messages carry both across chunk borders
+// a chunk without a chunk above it is under open sky
+
+constexpr uint32_t LIGHT_MAX = 15;
+constexpr uint32_t LIGHT_SKY_SHIFT = 4;
+constexpr uint32_t LIGHT_BLOCK_MASK = 0xF;
+
+// glows at full block light, until there is a block registry every other block is air or opaque and dark
+constexpr BlockId BLOCK_LAMP = 4;
+
+static inline uint32_t block_light_emission(BlockId const block) { return block == BLOCK_LAMP ? LIGHT_MAX : 0; }
+
+static inline bool is_block_opaque(BlockId const block) { return block != BLOCK_AIR; }
+
+// an unlit chunk reads as open sky
+static inline uint32_t chunk_get_sky_light(Chunk const *const chunk, uint32_t const voxel_index) {
+    return chunk->light ? chunk->light[voxel_index] >> LIGHT_SKY_SHIFT : LIGHT_MAX;
+}
+
+static inline uint32_t chunk_get_block_light(Chunk const *const chunk, uint32_t const voxel_index) {
+    return chunk->light ? chunk->light[voxel_index] & LIGHT_BLOCK_MASK : 0;
+}
+
+// per thread working memory of the passes, zeroed before the first one
+typedef struct {
+    // bit i is set when voxel i blocks light
+    uint64_t opaque[CHUNK_VOLUME / 64];
+    // voxel index in the low 16 bits and the level it was cleared from above them
+    uint32_t removals[CHUNK_VOLUME];
+    // a ring of voxel indices, each queued at most once thanks to the queued bits
+    uint16_t additions[CHUNK_VOLUME];
+    uint64_t queued[CHUNK_VOLUME / 64];
+} LightScratch;
+
+// the voxels of a chunk whose light changed, in chunk coordinates, min and max included
+typedef struct {
+    Chunk *chunk;
+    uint8_t min[3], max[3];
+} LightChange;
+
+typedef struct LightBatch LightBatch;
+
+// scratches holds a LightScratch for every thread of the job system the batch is submitted to
+LightBatch *light_batch_create(World const *world, LightScratch *scratches);
+void light_batch_destroy(LightBatch *batch);
+// lights the chunk from scratch and takes in the light of its lit neighbors, for chunks that were just generated or
+// loaded, only before the batch is submitted
+void light_batch_add_chunk(LightBatch *batch, Chunk *chunk);
+// block coordinates, the chunk already holds the new block, only before the batch is submitted
+void light_batch_set_block(LightBatch *batch, int32_t x, int32_t y, int32_t z, BlockId old_block);
+// runs the passes on the workers once dependency reaches zero, dependency may be null
+// counter is raised right away and drops to zero once the light settled, until then no chunk of the world may change
+void light_batch_submit(LightBatch *batch, JobSystem *jobs, JobCounter *dependency, JobCounter *counter);
+// every chunk whose light changed, once the counter of the submit dropped to zero
+uint32_t light_batch_get_changes(LightBatch const *batch, LightChange const **changes);
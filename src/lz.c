@@ -0,0 +1,128 @@
+#include "lz.h"
+
+#include <string.h>
+
+constexpr uint32_t HASH_BITS = 14;
+// after this many misses in a row the search starts skipping ahead, so incompressible data passes quickly
+constexpr uint32_t SKIP_TRIGGER_LOG2 = 6;
+
+static uint32_t read32(uint8_t const *const data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t hash_sequence(uint32_t const sequence) { return sequence * 2654435761u >> (32 - HASH_BITS); }
+
+// 15 in the nibble, then the rest in bytes of up to 255
+static uint8_t *write_length(uint8_t *output, uint8_t const *const end, size_t length) {
+    for (; length >= 255; length -= 255) {
+        if (output == end) return nullptr;
+        *output++ = 255;
+    }
+    if (output == end) return nullptr;
+    *output++ = (uint8_t)length;
+    return output;
+}
+
+static uint8_t *write_sequence(uint8_t *output, uint8_t const *const end, uint8_t const *const literals,
+                               size_t const literal_length, size_t const offset, size_t const match_length) {
+    if (output == end) return nullptr;
+    auto const token = output++;
+    *token = (uint8_t)((literal_length < 15 ? literal_length : 15) << 4);
+    if (literal_length >= 15 && !(output = write_length(output, end, literal_length - 15))) return nullptr;
+    if ((size_t)(end - output) < literal_length) return nullptr;
+    memcpy(output, literals, literal_length);
+    output += literal_length;
+    if (!match_length) return output;
+
+    if (end - output < 2) return nullptr;
+    *output++ = (uint8_t)offset;
+    *output++ = (uint8_t)(offset >> 8);
+    auto const length = match_length - LZ_MIN_MATCH;
+    *token |= (uint8_t)(length < 15 ? length : 15);
+    if (length >= 15 && !(output = write_length(output, end, length - 15))) return nullptr;
+    return output;
+}
+
+size_t lz_compress(void const *const source, size_t const size, void *const destination, size_t const capacity) {
+    uint8_t const *const input = source;
+    uint8_t *const output_start = destination;
+    uint8_t const *const output_end = output_start + capacity;
+    uint8_t *output = output_start;
+
+    // position plus one of the last sequence with each hash, 0 for none
+    uint32_t table[1u << HASH_BITS] = {};
+    size_t anchor = 0, position = 0;
+    uint32_t misses = 0;
+    while (size >= LZ_MIN_MATCH && position <= size - LZ_MIN_MATCH) {
+        auto const sequence = read32(input + position);
+        auto const slot = &table[hash_sequence(sequence)];
+        size_t const candidate = *slot;
+        *slot = (uint32_t)position + 1;
+        if (!candidate || position - (candidate - 1) > LZ_MAX_OFFSET || read32(input + candidate - 1) != sequence) {
+            position += 1 + (misses++ >> SKIP_TRIGGER_LOG2);
+            continue;
+        }
+        misses = 0;
+
+        size_t const match = candidate - 1;
+        size_t length = LZ_MIN_MATCH;
+        while (position + length < size && input[match + length] == input[position + length]) ++length;
+        output = write_sequence(output, output_end, input + anchor, position - anchor, position - match, length);
+        if (!output) return 0;
+        position += length;
+        anchor = position;
+    }
+
+    output = write_sequence(output, output_end, input + anchor, size - anchor, 0, 0);
+    return output ? (size_t)(output - output_start) : 0;
+}
+
+// false when the length runs past the input
+static bool read_length(uint8_t const **const input, uint8_t const *const end, size_t *const length) {
+    uint8_t byte;
+    do {
+        if (*input == end) return false;
+        byte = *(*input)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+bool lz_decompress(void const *const source, size_t const size, void *const destination,
+                   size_t const destination_size) {
+    uint8_t const *input = source;
+    uint8_t const *const input_end = input + size;
+    uint8_t *const output_start = destination;
+    uint8_t *output = output_start;
+    uint8_t const *const output_end = output_start + destination_size;
+
+    while (input < input_end) {
+        auto const token = *input++;
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_length(&input, input_end, &literal_length)) return false;
+        if ((size_t)(input_end - input) < literal_length || (size_t)(output_end - output) < literal_length)
+            return false;
+        memcpy(output, input, literal_length);
+        input += literal_length;
+        output += literal_length;
+        if (input == input_end) break;
+
+        if (input_end - input < 2) return false;
+        size_t const offset = input[0] | (size_t)input[1] << 8;
+        input += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15 && !read_length(&input, input_end, &match_length)) return false;
+        match_length += LZ_MIN_MATCH;
+        if (!offset || offset > (size_t)(output - output_start) || (size_t)(output_end - output) < match_length)
+            return false;
+
+        // byte by byte, so a match closer than its length repeats the bytes it is still writing, the matches are short
+        // enough that this beats memcpy calls
+        uint8_t const *const match = output - offset;
+        for (size_t i = 0; i < match_length; ++i) output[i] = match[i];
+        output += match_length;
+    }
+    return output == output_end;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// byte oriented lz77 in the spirit of lz4, built for decode speed over ratio
+// the data is a list of sequences, a token byte holds the literal length in its high nibble and the match length
+// minus LZ_MIN_MATCH in its low one, a nibble of 15 continues in extra bytes that are added up until one is below 255
+// then come the literals, a 16 bit little endian match offset and the match, the last sequence ends after its literals
+
+constexpr uint32_t LZ_MIN_MATCH = 4;
+constexpr uint32_t LZ_MAX_OFFSET = 65535;
+
+// the most lz_compress can write for size bytes, incompressible data grows by about 1 / 255
+// a macro so it can size arrays
+#define LZ_COMPRESS_BOUND(size) ((size) + (size) / 255 + 16)
+
+// returns the compressed size, 0 when it does not fit into capacity
+size_t lz_compress(void const *source, size_t size, void *destination, size_t capacity);
+// true when source decodes to exactly destination_size bytes, every read and write is bounds checked so corrupt data
+// fails instead of overrunning
+bool lz_decompress(void const *source, size_t size, void *destination, size_t destination_size);
@@ -1,112 +1,659 @@
-#define WIN32_LEAN_AND_MEAN
 #define VK_NO_PROTOTYPES
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 
+#include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#ifdef _WIN32
 #include <windows.h>
+#else
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif
 #include <vulkan/vulkan.h>
-#include <wincodec.h>
+
+#include "chunk.h"
+#include "culling.h"
+#include "jobs.h"
+#include "ktx2.h"
+#include "light.h"
+#include "mesher.h"
+#include "pack.h"
+#include "png.h"
+#include "profiler.h"
+#include "region.h"
 
 // one window
 // minimal error handling
 // designated initializers
 // one struct and one file
+// headless mode renders offscreen for benchmarking on any platform
 
-typedef struct Vec2 {
-    float x, y;
-} Vec2;
+#ifdef _WIN32
+typedef wchar_t NativeChar;
+#define NATIVE_TEXT(text) L##text
+#define native_compare wcscmp
+#define native_to_ulong wcstoul
+#define native_duplicate _wcsdup
+#define native_print swprintf
+#define native_make_directory(path) CreateDirectoryW(path, nullptr)
+#define NATIVE_STRING_FORMAT L"%ls"
+// missing from older mingw headers
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+#else
+typedef char NativeChar;
+#define NATIVE_TEXT(text) text
+#define native_compare strcmp
+#define native_to_ulong strtoul
+#define native_duplicate strdup
+#define native_print snprintf
+#define native_make_directory(path) mkdir(path, 0755)
+#define NATIVE_STRING_FORMAT "%s"
+#endif
+
+typedef struct Vec3 {
+    float x, y, z;
+} Vec3;
+
+// column major like glsl, columns[c][r]
+typedef struct Mat4 {
+    float columns[4][4];
+} Mat4;
 
 constexpr size_t MAX_SWAPCHAIN_IMAGES = 8;
-constexpr size_t IN_FLIGHT_FRAMES = 1;
+constexpr size_t MAX_IN_FLIGHT_FRAMES = 3;
+constexpr uint32_t DEFAULT_IN_FLIGHT_FRAMES = 2;
+// a frame slot has room for this much on top of a draw info and a culling list entry per section of the world
+constexpr VkDeviceSize FRAME_MEMORY_SIZE = 256 * 1024;
+constexpr VkDeviceSize FRAME_MEMORY_ALIGNMENT = 256;
+constexpr VkDeviceSize MEMORY_BLOCK_SIZE = 64 * 1024 * 1024;
+constexpr size_t MAX_MEMORY_BLOCKS = 32;
+constexpr uint32_t INITIAL_FREE_RANGES = 128;
+constexpr VkDeviceSize UPLOAD_RING_SIZE = 32 * 1024 * 1024;
+constexpr size_t MAX_UPLOAD_BATCHES = 16;
+// a swapchain rebuild retires about 2 * MAX_SWAPCHAIN_IMAGES + 4 objects and one can happen every frame in flight,
+// a burst of edits retires the old mesh range of every section it remeshed
+constexpr size_t MAX_DEFERRED_DELETIONS = 1024;
+// every chunk mesh lives in one vertex and one index arena and is drawn by one indirect command, the arenas double
+// when they run out and the draws grow with the world
+constexpr uint32_t INITIAL_CHUNK_DRAWS = 4096;
+// the arenas are handed out in quads, 4 vertices and 6 indices each, 56 bytes with 64 bit vertices
+// the checkerboard bench scene meshes into 1.57M quads and the demo world into 0.61M, the first arenas hold both
+// with room for the ranges the frames in flight still draw, 64 MB of vertices and 48 MB of indices
+constexpr uint32_t INITIAL_CHUNK_ARENA_QUADS = 1u << 21;
+constexpr uint32_t INITIAL_MESH_FREE_RANGES = 4096;
+constexpr uint32_t CULL_GROUP_SIZE = 64;
+// slots of the bindless texture array, a face finds its slot through the block texture table
+constexpr uint32_t MAX_TEXTURES = 1024;
+// timestamp pairs per frame, one per gpu zone
+constexpr uint32_t MAX_GPU_ZONES = 8;
+// the demo world is DEMO_WORLD_SIZE by DEMO_WORLD_SIZE chunks
+constexpr int32_t DEMO_WORLD_SIZE = 16;
+constexpr uint32_t MAX_STARTUP_STEPS = 32;
+
+typedef struct {
+    VkDeviceSize offset, size;
+} MemoryRange;
+
+// one driver allocation that is carved into sub-ranges, free ranges are sorted by offset and coalesced on free
+// live ranges are never moved, there is no defragmentation, a fragmented block only recovers as its ranges are freed
+typedef struct {
+    VkDeviceMemory memory;
+    uint32_t memory_type_index;
+    // linear and optimal resources never share a block so bufferImageGranularity can be ignored
+    bool optimal_tiling;
+    VkDeviceSize size;
+    VkDeviceSize used;
+    char *data;
+    uint32_t free_range_count;
+    // kept when the block is released, for the next block in its slot
+    uint32_t free_range_capacity;
+    MemoryRange *free_ranges;
+} MemoryBlock;
+
+typedef struct {
+    uint32_t block_index;
+    // offset is what gets bound, the range also covers the alignment padding in front of it
+    VkDeviceSize offset;
+    MemoryRange range;
+} MemoryAllocation;
+
+// one transfer queue submission, its staging ring space is reclaimed once the timeline reaches timeline_value
+typedef struct {
+    VkCommandBuffer command_buffer;
+    uint64_t timeline_value;
+    VkDeviceSize ring_end;
+} UploadBatch;
+
+// an uploaded image whose levels past the first are filled by blits on the graphics queue
+typedef struct {
+    VkImage image;
+    VkExtent2D extent;
+    uint32_t mip_levels;
+} MipmapRequest;
+
+typedef struct {
+    VkImage image;
+    VkImageView view;
+    MemoryAllocation allocation;
+    VkFormat format;
+    uint32_t mip_levels;
+} Texture;
+
+// how the faces of a block look, BlockTextures in shader.vert
+typedef struct {
+    // texture indices indexed by CHUNK_FACE_*
+    uint32_t textures[CHUNK_FACE_COUNT];
+    // rgba8 the textures are multiplied with, red in the low byte
+    uint32_t tint;
+    uint32_t padding;
+} BlockTextures;
+
+// a texture read and decoded off the render thread, its levels wait in memory until upload_texture copies them into
+// the staging ring
+typedef struct {
+    VkFormat format;
+    uint32_t width, height;
+    // 1 leaves the mips to the gpu when the format allows it
+    uint32_t level_count;
+    // offsets from data
+    Ktx2Level levels[KTX2_MAX_LEVELS];
+    void const *data;
+    // freed once uploaded, nullptr when data points into the asset pack
+    void *file_data;
+    void *pixels;
+} TextureSource;
+
+typedef enum {
+    DEFERRED_IMAGE_VIEW,
+    DEFERRED_IMAGE,
+    DEFERRED_MEMORY,
+    DEFERRED_SWAPCHAIN,
+    DEFERRED_SEMAPHORE,
+    DEFERRED_BUFFER,
+    // not an object, the texture index goes back to the free list
+    DEFERRED_TEXTURE_INDEX,
+    // a range of quads in the chunk arenas
+    DEFERRED_MESH_RANGE,
+} DeferredDeletionType;
+
+// an object the frames in flight may still use, destroyed once frame_count frames completed
+typedef struct {
+    DeferredDeletionType type;
+    uint64_t frame_count;
+    union {
+        VkImageView image_view;
+        VkImage image;
+        MemoryAllocation allocation;
+        VkSwapchainKHR swapchain;
+        VkSemaphore semaphore;
+        VkBuffer buffer;
+        uint32_t texture_index;
+        MemoryRange mesh_range;
+    };
+} DeferredDeletion;
+
+// matches DrawCount in cull.comp, one per frame in flight, copied to frame memory so the cpu can read it back
+typedef struct {
+    uint32_t draw_count;
+    uint32_t index_count;
+} DrawCounts;
+
+// sums over the frames whose results came back, reset by whoever reads them
+typedef struct {
+    uint64_t gpu_frame_count;
+    uint64_t gpu_time_ns;
+    uint64_t draw_count;
+    uint64_t triangle_count;
+} FrameTotals;
+
+// one step of the startup graph, times are from the start of the startup
+typedef struct {
+    char const *name;
+    uint32_t worker_index;
+    uint64_t start_ns, end_ns;
+} StartupStep;
+
+// a chunk of the world with its meshes in the arenas, its draws are the CHUNK_SECTION_COUNT entries of
+// chunk_info_buffer from its index times CHUNK_SECTION_COUNT on
+typedef struct {
+    Chunk *chunk;
+    // in quads, empty when the section has no faces
+    MemoryRange ranges[CHUNK_SECTION_COUNT];
+    // sections to remesh because their voxels or the voxels next to them changed
+    uint32_t dirty_sections;
+    // an edit changed its blocks since it was last saved
+    bool is_edited;
+} LoadedChunk;
+
+typedef struct {
+    int32_t x, y, z;
+    BlockId block;
+} BlockEdit;
+
+typedef struct RemeshBatch RemeshBatch;
+
+constexpr VkExtent2D DEFAULT_HEADLESS_EXTENT = {1280, 720};
+constexpr uint32_t DEFAULT_HEADLESS_FRAME_COUNT = 1000;
+// falls back to fifo, the only mode every surface supports
+constexpr VkPresentModeKHR DEFAULT_PRESENT_MODE = VK_PRESENT_MODE_MAILBOX_KHR;
+// the frame limiter sleeps until this long before the deadline and spins the rest, sleeps wake up late
+constexpr uint64_t FRAME_LIMITER_SPIN_NS = 1000000;
+
+// every vulkan entry point the app calls, loaded once into App so no call site looks anything up by name
+#ifdef _WIN32
+#define PLATFORM_INSTANCE_FUNCTIONS(X) \
+    X(vkCreateWin32SurfaceKHR)
+#else
+#define PLATFORM_INSTANCE_FUNCTIONS(X)
+#endif
+
+#define INSTANCE_FUNCTIONS(X) \
+    PLATFORM_INSTANCE_FUNCTIONS(X) \
+    X(vkEnumeratePhysicalDevices) \
+    X(vkGetPhysicalDeviceProperties) \
+    X(vkGetPhysicalDeviceFeatures) \
+    X(vkGetPhysicalDeviceFormatProperties) \
+    X(vkGetPhysicalDeviceQueueFamilyProperties) \
+    X(vkGetPhysicalDeviceMemoryProperties) \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR) \
+    X(vkGetPhysicalDeviceSurfacePresentModesKHR) \
+    X(vkCreateDevice)
+
+#define DEVICE_FUNCTIONS(X) \
+    X(vkGetDeviceQueue) \
+    X(vkDeviceWaitIdle) \
+    X(vkQueueSubmit2) \
+    X(vkCreateSwapchainKHR) \
+    X(vkDestroySwapchainKHR) \
+    X(vkGetSwapchainImagesKHR) \
+    X(vkAcquireNextImageKHR) \
+    X(vkQueuePresentKHR) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkGetBufferDeviceAddress) \
+    X(vkBindBufferMemory) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkBindImageMemory) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkCreateSampler) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreatePipelineLayout) \
+    X(vkCreateGraphicsPipelines) \
+    X(vkCreateComputePipelines) \
+    X(vkCreatePipelineCache) \
+    X(vkGetPipelineCacheData) \
+    X(vkCreateDescriptorPool) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkAllocateDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCreateCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkResetCommandBuffer) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkCreateSemaphore) \
+    X(vkDestroySemaphore) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkWaitForFences) \
+    X(vkWaitSemaphores) \
+    X(vkGetSemaphoreCounterValue) \
+    X(vkResetFences) \
+    X(vkCmdPipelineBarrier2) \
+    X(vkCmdCopyBuffer) \
+    X(vkCmdFillBuffer) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkCmdBlitImage) \
+    X(vkCmdBeginRendering) \
+    X(vkCmdEndRendering) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdPushConstants) \
+    X(vkCmdBindIndexBuffer) \
+    X(vkCmdSetViewport) \
+    X(vkCmdSetScissor) \
+    X(vkCmdDispatch) \
+    X(vkCmdDrawIndexedIndirectCount) \
+    X(vkCreateQueryPool) \
+    X(vkGetQueryPoolResults) \
+    X(vkCmdResetQueryPool) \
+    X(vkCmdWriteTimestamp2)
+
+#define DECLARE_VULKAN_FUNCTION(name) PFN_##name name;
 
 typedef struct {
     wchar_t const *window_title;
 
+    JobSystem *jobs;
+    // indexed by job_system_worker_index
+    MesherScratch *mesher_scratches;
+    ConnectivityScratch *connectivity_scratches;
+    LightScratch *light_scratches;
+    // nullptr unless the world is saved
+    RegionScratch *region_scratches;
+
+    Profiler profiler;
+    // written on exit when set
+    NativeChar const *trace_path;
+    // the directory of the region files, chunks saved there are loaded instead of generated and generated ones are
+    // saved, nullptr to always generate
+    NativeChar const *world_path;
+    // the region files covering the world, world_region_span per side, nullptr when the world is not saved
+    // workers only read them while the world is generated, the render thread writes the generated and edited chunks
+    RegionFile *world_regions;
+    int32_t world_region_span;
+    // one timestamp pool per frame in flight, it is read back after the frame fence so the read never waits
+    VkQueryPool timestamp_pools[MAX_IN_FLIGHT_FRAMES];
+    char const *gpu_zone_names[MAX_IN_FLIGHT_FRAMES][MAX_GPU_ZONES];
+    uint32_t gpu_zone_counts[MAX_IN_FLIGHT_FRAMES];
+    uint64_t gpu_zone_frames[MAX_IN_FLIGHT_FRAMES];
+    uint64_t gpu_submit_times[MAX_IN_FLIGHT_FRAMES];
+    // added to gpu times to get cpu times, raised whenever a frame would start on the gpu before its submit
+    int64_t gpu_time_offset;
+    bool has_gpu_time_offset;
+    // the copy of the draw counts of each frame in flight, nullptr when the frame drew no chunks
+    DrawCounts const *frame_draw_counts[MAX_IN_FLIGHT_FRAMES];
+    FrameTotals frame_totals;
+    // when the loop last drained input, taken over by the next frame, latency runs from there to the end of the frame
+    // on the gpu
+    uint64_t input_sample_ns;
+    uint64_t frame_input_times[MAX_IN_FLIGHT_FRAMES];
+
+    // frames per second, 0 renders as fast as the present mode lets it
+    uint32_t frame_rate_limit;
+    uint64_t next_frame_ns;
+
+    bool headless;
+    uint32_t headless_frame_count;
+    VkExtent2D headless_extent;
+
+#ifdef _WIN32
     HANDLE process_heap;
     HINSTANCE hinstance;
     HWND window;
+    // high resolution waitable timer for the frame limiter
+    HANDLE frame_timer;
+    // while an edge or the title bar is dragged windows runs its own message loop and main_loop does not get to render
+    bool is_sizing;
 
     HMODULE vulkan_library;
+#else
+    void *vulkan_library;
+#endif
     PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr;
     VkInstance instance;
     PFN_vkGetDeviceProcAddr vkGetDeviceProcAddr;
+    INSTANCE_FUNCTIONS(DECLARE_VULKAN_FUNCTION)
+    DEVICE_FUNCTIONS(DECLARE_VULKAN_FUNCTION)
+
     VkSurfaceKHR surface;
     VkPhysicalDevice physical_device;
+    VkPhysicalDeviceProperties physical_device_properties;
+    VkPhysicalDeviceFeatures physical_device_features;
+    VkPhysicalDeviceMemoryProperties memory_properties;
     VkDevice device;
+    uint32_t graphics_queue_family;
     VkQueue queue;
+    // 0 when the graphics queue cannot write timestamps
+    uint32_t timestamp_valid_bits;
+    // a dedicated transfer family when the device has one, otherwise the graphics family and queue
+    uint32_t transfer_queue_family;
+    VkQueue transfer_queue;
 
     VkPipelineLayout pipeline_layout;
+    VkPipelineLayout cull_pipeline_layout;
     VkShaderModule shader_module;
+    // read on a worker while the device is created, points into the asset pack or at shader_module_bytes
+    void const *shader_code;
+    size_t shader_code_size;
+    // nullptr when the spir-v is read from the asset pack
     void *shader_module_bytes;
+    // mapped while the renderer is created, without entries when there is no pack
+    Pack asset_pack;
+    // read with the shaders, uploaded by create_buffers
+    TextureSource block_texture_source;
+
+    // recorded by whichever thread ran the step, printed once the first frame is submitted
+    uint64_t startup_start_ns;
+    atomic_uint startup_step_count;
+    StartupStep startup_steps[MAX_STARTUP_STEPS];
+    bool is_startup_reported;
 
     VkSurfaceCapabilitiesKHR surface_capabilities;
 
     VkCommandPool command_pool;
 
+    uint32_t in_flight_frame_count;
     size_t current_frame;
-    VkCommandBuffer command_buffers[IN_FLIGHT_FRAMES];
-    VkSemaphore image_available_semaphores[IN_FLIGHT_FRAMES];
-    VkSemaphore render_finished_semaphores[IN_FLIGHT_FRAMES];
-    VkFence in_flight_fences[IN_FLIGHT_FRAMES];
+    uint64_t frame_count;
+    // fences signal in submission order, so every frame before this one is done
+    uint64_t completed_frame_count;
+    uint32_t deferred_deletion_first;
+    uint32_t deferred_deletion_count;
+    DeferredDeletion deferred_deletions[MAX_DEFERRED_DELETIONS];
+    VkCommandBuffer command_buffers[MAX_IN_FLIGHT_FRAMES];
+    VkSemaphore image_available_semaphores[MAX_IN_FLIGHT_FRAMES];
+    VkFence in_flight_fences[MAX_IN_FLIGHT_FRAMES];
+    // indexed by swapchain image, an image can still be in use by an older frame when it is acquired again
+    VkSemaphore render_finished_semaphores[MAX_SWAPCHAIN_IMAGES];
+    VkFence image_in_flight_fences[MAX_SWAPCHAIN_IMAGES];
+
+    // one frame_memory_size slot per frame in flight, a slot is overwritten only after its frame fence signaled
+    VkDeviceSize frame_memory_size;
+    VkBuffer frame_memory_buffer;
+    MemoryAllocation frame_memory;
+    char *frame_memory_data;
+    VkDeviceAddress frame_memory_device_address;
+    VkDeviceSize frame_memory_cursor;
 
     VkSwapchainKHR swapchain;
+    // the mode asked for on the command line, present_mode is the one the surface supports
+    VkPresentModeKHR requested_present_mode;
+    VkPresentModeKHR present_mode;
     bool is_swapchain_dirty;
     uint32_t swapchain_image_count;
     VkImage swapchain_images[MAX_SWAPCHAIN_IMAGES];
     VkImageView swapchain_image_views[MAX_SWAPCHAIN_IMAGES];
-    VkFramebuffer framebuffers[MAX_SWAPCHAIN_IMAGES];
+    VkFormat depth_format;
+    VkImage depth_image;
+    VkImageView depth_image_view;
+    MemoryAllocation depth_image_allocation;
+    MemoryAllocation offscreen_image_allocations[MAX_SWAPCHAIN_IMAGES];
 
-    VkRenderPass renderpass;
+    VkPipelineCache pipeline_cache;
+    bool cold_pipeline_cache;
+    bool is_pipeline_cache_warm;
     VkPipeline pipeline;
+    VkPipeline cull_pipeline;
+
+
+    uint32_t memory_block_count;
+    MemoryBlock memory_blocks[MAX_MEMORY_BLOCKS];
+
+    // section meshes get ranges of quads in the arenas, free ranges are sorted and coalesced like in a memory block
+    VkBuffer chunk_vertex_buffer;
+    MemoryAllocation chunk_vertex_allocation;
+    VkDeviceAddress chunk_vertex_buffer_device_address;
+    VkBuffer chunk_index_buffer;
+    MemoryAllocation chunk_index_allocation;
+    uint32_t chunk_arena_quads;
+    uint32_t chunk_quad_count;
+    uint32_t mesh_free_range_count;
+    uint32_t mesh_free_range_capacity;
+    MemoryRange *mesh_free_ranges;
+    // one ChunkDrawInfo per chunk section, cull.comp turns the visible ones into draws
+    // it is only written by the frames, they copy the entries from dirty_draw_info_begin to dirty_draw_info_end out
+    // of chunk_draw_infos, so no frame in flight sees a section switch ranges
+    VkBuffer chunk_info_buffer;
+    MemoryAllocation chunk_info_allocation;
+    VkDeviceAddress chunk_info_buffer_device_address;
+    ChunkDrawInfo *chunk_draw_infos;
+    // sections the draw buffers and loaded_chunks have room for
+    uint32_t chunk_draw_capacity;
+    uint32_t dirty_draw_info_begin;
+    uint32_t dirty_draw_info_end;
+    // the chunks stay loaded after they are meshed, so edits can remesh them
+    World world;
+    LoadedChunk *loaded_chunks;
+    uint32_t chunk_count;
+    // edits wait here while a remesh batch reads the chunks
+    BlockEdit *block_edits;
+    uint32_t block_edit_count;
+    uint32_t block_edit_capacity;
+    // the chunks remeshed on the workers, nullptr while none are
+    RemeshBatch *remesh_batch;
+    // chunk_draw_capacity commands and one DrawCounts per frame in flight
+    VkBuffer draw_command_buffer;
+    MemoryAllocation draw_command_allocation;
+    VkDeviceAddress draw_command_buffer_device_address;
+    VkBuffer draw_count_buffer;
+    VkDeviceAddress draw_count_buffer_device_address;
+    Vec3 camera_target;
+    // set once the last chunk of the world is uploaded
+    bool is_world_ready;
+    // the cpu walks the open space from the camera, cull.comp only sees the chunks of the cells it reached
+    VisibilityGrid visibility;
+    uint32_t *visible_cells;
+    // per cell, the chunk index in chunk_info_buffer or UINT32_MAX while the cell has no mesh
+    uint32_t *cell_chunk_indices;
+
+    // persistently mapped staging ring, head and tail only grow and are taken modulo UPLOAD_RING_SIZE
+    VkBuffer upload_buffer;
+    MemoryAllocation upload_memory;
+    char *upload_data;
+    VkDeviceSize upload_head;
+    VkDeviceSize upload_tail;
+    VkCommandPool upload_command_pool;
+    VkSemaphore upload_semaphore;
+    uint64_t upload_timeline_value;
+    uint64_t frame_upload_timeline_value;
+    bool is_upload_recording;
+    uint32_t upload_batch_first;
+    uint32_t upload_batch_count;
+    UploadBatch upload_batches[MAX_UPLOAD_BATCHES];
+    // queue family ownership acquires the next frame records before it touches the uploaded images, buffers are
+    // shared by both queue families and need none
+    VkImageMemoryBarrier2 *upload_image_acquires;
+    uint32_t upload_image_acquire_count;
+    uint32_t upload_image_acquire_capacity;
+    MipmapRequest *mipmap_requests;
+    uint32_t mipmap_request_count;
+    uint32_t mipmap_request_capacity;
 
-    PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
-    PFN_vkQueuePresentKHR vkQueuePresentKHR;
-    PFN_vkWaitForFences vkWaitForFences;
-    PFN_vkResetFences vkResetFences;
-    PFN_vkResetCommandBuffer vkResetCommandBuffer;
-    PFN_vkBeginCommandBuffer vkBeginCommandBuffer;
-    PFN_vkEndCommandBuffer vkEndCommandBuffer;
-    PFN_vkCmdBeginRenderPass vkCmdBeginRenderPass;
-    PFN_vkCmdEndRenderPass vkCmdEndRenderPass;
-    PFN_vkCmdBindPipeline vkCmdBindPipeline;
-    PFN_vkCmdSetViewport vkCmdSetViewport;
-    PFN_vkCmdSetScissor vkCmdSetScissor;
-    PFN_vkCmdDrawIndexed vkCmdDrawIndexed;
-    PFN_vkQueueSubmit vkQueueSubmit;
-    PFN_vkCmdBindVertexBuffers vkCmdBindVertexBuffers;
-    PFN_vkCmdBindIndexBuffer vkCmdBindIndexBuffer;
-
-    VkBuffer vertex_buffer;
-    VkBuffer index_buffer;
-    VkBuffer staging_buffer;
-
-    IWICImagingFactory *imaging_factory;
     VkDescriptorPool descriptor_pool;
     VkDescriptorSetLayout descriptor_set_layout;
     VkDescriptorSet descriptor_set;
-    PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets;
+    VkSampler texture_sampler;
+    // the bindless texture array, an index stays the same until its texture is removed and is only handed out again
+    // once no frame in flight can sample the old texture
+    uint32_t texture_count;
+    Texture textures[MAX_TEXTURES];
+    uint32_t free_texture_index_count;
+    uint32_t free_texture_indices[MAX_TEXTURES];
+    // indexed by texture layer, mirrored in block_texture_buffer for shader.vert
+    // like the draw infos it is only written by the frames, they copy the layers from dirty_block_texture_begin to
+    // dirty_block_texture_end out of block_textures
+    BlockTextures block_textures[MESH_VERTEX_MAX_LAYERS];
+    VkBuffer block_texture_buffer;
+    VkDeviceAddress block_texture_buffer_device_address;
+    uint32_t dirty_block_texture_begin;
+    uint32_t dirty_block_texture_end;
 } App;
 
-void show_window(App const *app, int const nCmdShow) { ShowWindow(app->window, nCmdShow); }
+[[noreturn]] void fatal_error(App const *app, wchar_t const *message) {
+#ifdef _WIN32
+    if (!app->headless) {
+        MessageBoxW(nullptr, message, app->window_title, MB_OK);
+        ExitProcess(1);
+    }
+#endif
+    fprintf(stderr, "%ls: %ls\n", app->window_title, message);
+    exit(1);
+}
+
+uint64_t get_time_ns() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000000ull +
+                      counter.QuadPart % frequency.QuadPart * 1000000000ull / frequency.QuadPart);
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
+
+// safe from any thread, each step takes its own slot
+void record_startup_step(App *const app, char const *const name, uint64_t const start_ns, uint64_t const end_ns) {
+    auto const index = atomic_fetch_add_explicit(&app->startup_step_count, 1, memory_order_relaxed);
+    if (index >= MAX_STARTUP_STEPS) return;
+    app->startup_steps[index] = (StartupStep){
+        .name = name,
+        .worker_index = job_system_worker_index(app->jobs),
+        .start_ns = start_ns - app->startup_start_ns,
+        .end_ns = end_ns - app->startup_start_ns,
+    };
+}
+
+void run_startup_step(App *const app, char const *const name, void (*const step)(App *app)) {
+    auto const start = get_time_ns();
+    step(app);
+    record_startup_step(app, name, start, get_time_ns());
+}
 
-WPARAM main_loop() {
-    MSG message;
-    while (GetMessageW(&message, nullptr, 0, 0)) {
-        TranslateMessage(&message);
-        DispatchMessageW(&message);
+// every step joined the render thread before the first frame, so the slots are complete and visible here
+void report_startup(App *const app) {
+    app->is_startup_reported = true;
+    auto const step_count = atomic_load_explicit(&app->startup_step_count, memory_order_relaxed);
+    printf("first frame submitted %.3f ms after startup began\n",
+           (double)(get_time_ns() - app->startup_start_ns) / 1e6);
+    printf("%10s %10s %6s  %s\n", "start ms", "end ms", "thread", "startup step");
+    for (uint32_t i = 0; i < step_count && i < MAX_STARTUP_STEPS; ++i) {
+        auto const step = &app->startup_steps[i];
+        printf("%10.3f %10.3f %6u  %s\n", (double)step->start_ns / 1e6, (double)step->end_ns / 1e6, step->worker_index,
+               step->name);
     }
-    return message.wParam;
 }
 
+#ifdef _WIN32
+void show_window(App const *app, int const nCmdShow) { ShowWindow(app->window, nCmdShow); }
+#endif
+
 void load_vulkan_library(App *const app) {
+#ifdef _WIN32
     app->vulkan_library = LoadLibraryW(L"vulkan-1.dll");
-    if (!app->vulkan_library) {
-        MessageBoxW(nullptr, L"Cannot find vulkan, please make sure to update your driver!", app->window_title,
-                    MB_OK);
-        ExitProcess(1);
-    }
+#else
+    app->vulkan_library = dlopen("libvulkan.so.1", RTLD_NOW | RTLD_LOCAL);
+#endif
+    if (!app->vulkan_library)
+        fatal_error(app, L"Cannot find vulkan, please make sure to update your driver!");
+#ifdef _WIN32
     app->vkGetInstanceProcAddr = (PFN_vkGetInstanceProcAddr)GetProcAddress(
         app->vulkan_library, "vkGetInstanceProcAddr");
+#else
+    // POSIX sanctioned way to turn dlsym's object pointer into a function pointer
+    *(void**)&app->vkGetInstanceProcAddr = dlsym(app->vulkan_library, "vkGetInstanceProcAddr");
+#endif
 }
 
 void create_instance(App *const app) {
@@ -118,903 +665,3527 @@ void create_instance(App *const app) {
                              .sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
                              .apiVersion = VK_API_VERSION_1_3,
                          },
-                         .enabledExtensionCount = 2,
+#ifdef _WIN32
+                         .enabledExtensionCount = app->headless ? 0 : 2,
                          .ppEnabledExtensionNames = (const char*[]){"VK_KHR_surface", "VK_KHR_win32_surface"},
+#endif
                      }, nullptr, &app->instance);
 
     app->vkGetDeviceProcAddr = (PFN_vkGetDeviceProcAddr)app->
         vkGetInstanceProcAddr(app->instance, "vkGetDeviceProcAddr");
+#define LOAD_INSTANCE_FUNCTION(name) app->name = (PFN_##name)app->vkGetInstanceProcAddr(app->instance, #name);
+    INSTANCE_FUNCTIONS(LOAD_INSTANCE_FUNCTION)
+#undef LOAD_INSTANCE_FUNCTION
 }
 
 void pick_physical_device(App *const app) {
-    auto const vkEnumeratePhysicalDevices = (PFN_vkEnumeratePhysicalDevices)app->vkGetInstanceProcAddr(
-        app->instance, "vkEnumeratePhysicalDevices");
-    vkEnumeratePhysicalDevices(app->instance, &(uint32_t){1}, &app->physical_device);
+    app->vkEnumeratePhysicalDevices(app->instance, &(uint32_t){1}, &app->physical_device);
+    app->vkGetPhysicalDeviceProperties(app->physical_device, &app->physical_device_properties);
+    app->vkGetPhysicalDeviceFeatures(app->physical_device, &app->physical_device_features);
+    app->vkGetPhysicalDeviceMemoryProperties(app->physical_device, &app->memory_properties);
+}
+
+void pick_queue_families(App *const app) {
+    uint32_t family_count = 0;
+    app->vkGetPhysicalDeviceQueueFamilyProperties(app->physical_device, &family_count, nullptr);
+    VkQueueFamilyProperties families[family_count];
+    app->vkGetPhysicalDeviceQueueFamilyProperties(app->physical_device, &family_count, families);
+
+    app->graphics_queue_family = 0;
+    for (uint32_t i = 0; i < family_count; ++i)
+        if (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+            app->graphics_queue_family = i;
+            break;
+        }
+    app->timestamp_valid_bits = families[app->graphics_queue_family].timestampValidBits;
+
+    // prefer a pure copy engine, then any non graphics family that can transfer
+    app->transfer_queue_family = app->graphics_queue_family;
+    uint32_t best_flag_count = UINT32_MAX;
+    for (uint32_t i = 0; i < family_count; ++i) {
+        auto const flags = families[i].queueFlags;
+        if (!(flags & VK_QUEUE_TRANSFER_BIT) || flags & VK_QUEUE_GRAPHICS_BIT) continue;
+        uint32_t const flag_count = (uint32_t)__builtin_popcount(flags);
+        if (flag_count < best_flag_count) {
+            app->transfer_queue_family = i;
+            best_flag_count = flag_count;
+        }
+    }
 }
 
 void create_device(App *const app) {
-    auto const vkCreateDevice = (PFN_vkCreateDevice)app->vkGetInstanceProcAddr(app->instance, "vkCreateDevice");
-    auto const vkGetDeviceQueue = (PFN_vkGetDeviceQueue)app->vkGetDeviceProcAddr(app->device, "vkGetDeviceQueue");
-
-    vkCreateDevice(app->physical_device, &(VkDeviceCreateInfo){
-                       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-                       .enabledExtensionCount = 1,
-                       .ppEnabledExtensionNames = (const char*[]){VK_KHR_SWAPCHAIN_EXTENSION_NAME},
-                       .queueCreateInfoCount = 1,
-                       .pQueueCreateInfos = &(VkDeviceQueueCreateInfo){
-                           .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-                           .queueCount = 1,
-                           .pQueuePriorities = (float[]){1.0f},
-                       },
-                       .pNext = &(VkPhysicalDeviceFeatures2){
-                           .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
-                           .pNext = &(VkPhysicalDeviceVulkan12Features){
-                               .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
-                           },
-                       },
-                   },
-                   nullptr, &app->device);
-    vkGetDeviceQueue(app->device, 0, 0, &app->queue);
+    pick_queue_families(app);
+    bool const has_transfer_queue = app->transfer_queue_family != app->graphics_queue_family;
+
+    app->vkCreateDevice(app->physical_device, &(VkDeviceCreateInfo){
+                            .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+                            .enabledExtensionCount = app->headless ? 0 : 1,
+                            .ppEnabledExtensionNames = (const char*[]){VK_KHR_SWAPCHAIN_EXTENSION_NAME},
+                            .queueCreateInfoCount = has_transfer_queue ? 2 : 1,
+                            .pQueueCreateInfos = (VkDeviceQueueCreateInfo[]){
+                                {
+                                    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                                    .queueFamilyIndex = app->graphics_queue_family,
+                                    .queueCount = 1,
+                                    .pQueuePriorities = (float[]){1.0f},
+                                },
+                                {
+                                    .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                                    .queueFamilyIndex = app->transfer_queue_family,
+                                    .queueCount = 1,
+                                    .pQueuePriorities = (float[]){1.0f},
+                                },
+                            },
+                            .pNext = &(VkPhysicalDeviceFeatures2){
+                                .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+                                .features = {
+                                    .textureCompressionBC = app->physical_device_features.textureCompressionBC,
+                                    .multiDrawIndirect = true,
+                                    .drawIndirectFirstInstance = true,
+                                },
+                                .pNext = &(VkPhysicalDeviceVulkan12Features){
+                                    .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+                                    .timelineSemaphore = true,
+                                    .bufferDeviceAddress = true,
+                                    .drawIndirectCount = true,
+                                    // the subset every 1.3 device has, enough for one array of every texture
+                                    .descriptorIndexing = true,
+                                    .shaderSampledImageArrayNonUniformIndexing = true,
+                                    .descriptorBindingSampledImageUpdateAfterBind = true,
+                                    .descriptorBindingUpdateUnusedWhilePending = true,
+                                    .descriptorBindingPartiallyBound = true,
+                                    .runtimeDescriptorArray = true,
+                                    .pNext = &(VkPhysicalDeviceVulkan13Features){
+                                        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+                                        .synchronization2 = true,
+                                        .dynamicRendering = true,
+                                    },
+                                },
+                            },
+                        },
+                        nullptr, &app->device);
+#define LOAD_DEVICE_FUNCTION(name) app->name = (PFN_##name)app->vkGetDeviceProcAddr(app->device, #name);
+    DEVICE_FUNCTIONS(LOAD_DEVICE_FUNCTION)
+#undef LOAD_DEVICE_FUNCTION
+    app->vkGetDeviceQueue(app->device, app->graphics_queue_family, 0, &app->queue);
+    app->vkGetDeviceQueue(app->device, app->transfer_queue_family, 0, &app->transfer_queue);
 }
 
+#ifdef _WIN32
 void create_surface(App *const app) {
-    auto const vkCreateWin32SurfaceKHR = (PFN_vkCreateWin32SurfaceKHR)app->vkGetInstanceProcAddr(
-        app->instance, "vkCreateWin32SurfaceKHR");
-    vkCreateWin32SurfaceKHR(app->instance, &(VkWin32SurfaceCreateInfoKHR){
-                                .sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR,
-                                .hinstance = app->hinstance,
-                                .hwnd = app->window,
-                            },
-                            nullptr, &app->surface);
+    app->vkCreateWin32SurfaceKHR(app->instance, &(VkWin32SurfaceCreateInfoKHR){
+                                     .sType = VK_STRUCTURE_TYPE_WIN32_SURFACE_CREATE_INFO_KHR,
+                                     .hinstance = app->hinstance,
+                                     .hwnd = app->window,
+                                 },
+                                 nullptr, &app->surface);
 }
+#endif
 
-void configure_swapchain(App *const app) {
-    auto const vkCreateSwapchainKHR = (PFN_vkCreateSwapchainKHR)app->vkGetInstanceProcAddr(
-        app->instance, "vkCreateSwapchainKHR");
-    auto const vkGetImagesKHR = (PFN_vkGetSwapchainImagesKHR)app->vkGetInstanceProcAddr(
-        app->instance, "vkGetSwapchainImagesKHR");
-    auto const vkCreateImageView = (PFN_vkCreateImageView)app->vkGetDeviceProcAddr(app->device, "vkCreateImageView");
+uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties *pMemoryProperties,
+                          uint32_t const memoryTypeBitsRequirement,
+                          VkMemoryPropertyFlags const requiredProperties) {
+    const uint32_t memoryCount = pMemoryProperties->memoryTypeCount;
+    for (uint32_t memoryIndex = 0; memoryIndex < memoryCount; ++memoryIndex) {
+        const uint32_t memoryTypeBits = (1 << memoryIndex);
+        const bool isRequiredMemoryType = memoryTypeBitsRequirement & memoryTypeBits;
 
-    auto const old_swapchain = app->swapchain;
-    vkCreateSwapchainKHR(app->device, &(VkSwapchainCreateInfoKHR){
-                             .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
-                             .surface = app->surface,
-                             .minImageCount = app->surface_capabilities.minImageCount + 1,
-                             .imageFormat = VK_FORMAT_B8G8R8A8_SRGB,
-                             .imageExtent = app->surface_capabilities.currentExtent,
-                             .imageArrayLayers = 1,
-                             .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-                             .preTransform = app->surface_capabilities.currentTransform,
-                             .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
-                             .presentMode = VK_PRESENT_MODE_MAILBOX_KHR,
-                             .clipped = true,
-                             .oldSwapchain = old_swapchain,
-                         },
-                         nullptr, &app->swapchain);
-    if (old_swapchain) {
-        auto const vkDestroySwapchainKHR = (PFN_vkDestroySwapchainKHR)app->vkGetDeviceProcAddr(
-            app->device, "vkDestroySwapchainKHR");
-        auto const vkDestroyImageView = (PFN_vkDestroyImageView)app->vkGetDeviceProcAddr(
-            app->device, "vkDestroyImageView");
+        const VkMemoryPropertyFlags properties =
+            pMemoryProperties->memoryTypes[memoryIndex].propertyFlags;
+        const bool hasRequiredProperties =
+            (properties & requiredProperties) == requiredProperties;
 
-        for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
-            vkDestroyImageView(app->device, app->swapchain_image_views[i], nullptr);
-        vkDestroySwapchainKHR(app->device, old_swapchain, nullptr);
+        if (isRequiredMemoryType && hasRequiredProperties)
+            return memoryIndex;
     }
-
-    vkGetImagesKHR(app->device, app->swapchain, &app->swapchain_image_count, nullptr);
-    vkGetImagesKHR(app->device, app->swapchain, &app->swapchain_image_count, app->swapchain_images);
-
-    for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
-        vkCreateImageView(app->device, &(VkImageViewCreateInfo){
-                              .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                              .image = app->swapchain_images[i],
-                              .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                              .format = VK_FORMAT_B8G8R8A8_SRGB,
-                              .subresourceRange = {
-                                  .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                  .levelCount = 1,
-                                  .layerCount = 1,
-                              },
-                          },
-                          nullptr, &app->swapchain_image_views[i]);
+    return UINT32_MAX;
 }
 
-void update_surface_capabilities(App *const app) {
-    auto const vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)app->
-        vkGetInstanceProcAddr(app->instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(app->physical_device, app->surface, &app->surface_capabilities);
-}
+// best fit out of free ranges sorted by offset, the alignment padding in front of the allocation is kept with it so
+// a free range never splits in two, returns the aligned offset
+bool take_free_range(MemoryRange *const free_ranges, uint32_t *const free_range_count, VkDeviceSize const size,
+                     VkDeviceSize const alignment, VkDeviceSize *const offset, MemoryRange *const taken) {
+    uint32_t best = UINT32_MAX;
+    VkDeviceSize best_leftover = 0;
+    for (uint32_t i = 0; i < *free_range_count; ++i) {
+        auto const range = free_ranges[i];
+        auto const aligned = (range.offset + alignment - 1) & ~(alignment - 1);
+        if (aligned + size > range.offset + range.size) continue;
+        auto const leftover = range.offset + range.size - (aligned + size);
+        if (best == UINT32_MAX || leftover < best_leftover) {
+            best = i;
+            best_leftover = leftover;
+        }
+    }
+    if (best == UINT32_MAX) return false;
 
-void destroy_framebuffers(App const *app) {
-    auto const vkDestroyFramebuffer = (PFN_vkDestroyFramebuffer)app->vkGetDeviceProcAddr(
-        app->device, "vkDestroyFramebuffer");
-    for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
-        vkDestroyFramebuffer(app->device, app->framebuffers[i], nullptr);
+    auto const range = &free_ranges[best];
+    *offset = (range->offset + alignment - 1) & ~(alignment - 1);
+    *taken = (MemoryRange){
+        .offset = range->offset,
+        .size = *offset + size - range->offset,
+    };
+    if (best_leftover) {
+        range->offset += taken->size;
+        range->size = best_leftover;
+    } else {
+        memmove(range, range + 1, (*free_range_count - best - 1) * sizeof(MemoryRange));
+        --*free_range_count;
+    }
+    return true;
 }
 
-void configure_framebuffers(App *app) {
-    auto const vkCreateFramebuffer = (PFN_vkCreateFramebuffer)app->vkGetDeviceProcAddr(
-        app->device, "vkCreateFramebuffer");
+// merges the range with its neighbors, false when it needs an entry of its own and there is none left
+bool return_free_range(MemoryRange *const free_ranges, uint32_t *const free_range_count, uint32_t const capacity,
+                       MemoryRange const range) {
+    uint32_t i = 0;
+    while (i < *free_range_count && free_ranges[i].offset < range.offset) ++i;
+    auto const previous = i > 0 ? &free_ranges[i - 1] : nullptr;
+    auto const next = i < *free_range_count ? &free_ranges[i] : nullptr;
+    bool const merge_previous = previous && previous->offset + previous->size == range.offset;
+    bool const merge_next = next && range.offset + range.size == next->offset;
 
-    auto const extent = app->surface_capabilities.currentExtent;
-    for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
-        vkCreateFramebuffer(app->device, &(VkFramebufferCreateInfo){
-                                .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-                                .renderPass = app->renderpass,
-                                .attachmentCount = 1,
-                                .pAttachments = &app->swapchain_image_views[i],
-                                .width = extent.width,
-                                .height = extent.height,
-                                .layers = 1,
-                            },
-                            nullptr, &app->framebuffers[i]);
+    if (merge_previous && merge_next) {
+        previous->size += range.size + next->size;
+        memmove(next, next + 1, (*free_range_count - i - 1) * sizeof(MemoryRange));
+        --*free_range_count;
+    } else if (merge_previous) {
+        previous->size += range.size;
+    } else if (merge_next) {
+        next->offset = range.offset;
+        next->size += range.size;
+    } else {
+        if (*free_range_count == capacity) return false;
+        memmove(&free_ranges[i + 1], &free_ranges[i], (*free_range_count - i) * sizeof(MemoryRange));
+        free_ranges[i] = range;
+        ++*free_range_count;
+    }
+    return true;
 }
 
-void setup_swapchain_dependent_resources(App *const app) {
-    update_surface_capabilities(app);
-    auto const extent = app->surface_capabilities.currentExtent;
-    if (extent.width == 0 || extent.height == 0) return;
-    auto const vkQueueWaitIdle = (PFN_vkQueueWaitIdle)app->vkGetDeviceProcAddr(app->device, "vkQueueWaitIdle");
-    vkQueueWaitIdle(app->queue);
-    destroy_framebuffers(app);
-    configure_swapchain(app);
-    configure_framebuffers(app);
+// doubles the free list when the range needs an entry of its own and every entry is taken
+void return_free_range_or_grow(MemoryRange **const free_ranges, uint32_t *const free_range_count,
+                               uint32_t *const capacity, MemoryRange const range) {
+    while (!return_free_range(*free_ranges, free_range_count, *capacity, range)) {
+        *capacity *= 2;
+        *free_ranges = realloc(*free_ranges, *capacity * sizeof(MemoryRange));
+    }
 }
 
-typedef struct {
-    VkDeviceAddress vertex_buffer_device_address;
-} PushConstants;
+bool allocate_from_block(MemoryBlock *const block, VkDeviceSize const size, VkDeviceSize const alignment,
+                         MemoryAllocation *const allocation) {
+    if (!take_free_range(block->free_ranges, &block->free_range_count, size, alignment, &allocation->offset,
+                         &allocation->range))
+        return false;
+    block->used += allocation->range.size;
+    return true;
+}
 
-void render(App *const app) {
-    app->vkWaitForFences(app->device, 1, &app->in_flight_fences[app->current_frame], true, UINT64_MAX);
+MemoryAllocation allocate_device_memory(App *const app, VkMemoryRequirements const *const requirements,
+                                        VkMemoryPropertyFlags const required_properties, bool const optimal_tiling) {
+    uint32_t const memory_type_index = find_memory_type(&app->memory_properties, requirements->memoryTypeBits,
+                                                        required_properties);
+    if (memory_type_index == UINT32_MAX) fatal_error(app, L"No suitable memory type!");
 
-    if (app->is_swapchain_dirty) {
-        app->is_swapchain_dirty = false;
-        setup_swapchain_dependent_resources(app);
+    MemoryAllocation allocation = {};
+    for (uint32_t i = 0; i < app->memory_block_count; ++i) {
+        auto const block = &app->memory_blocks[i];
+        if (!block->memory || block->memory_type_index != memory_type_index ||
+            block->optimal_tiling != optimal_tiling)
+            continue;
+        allocation.block_index = i;
+        if (allocate_from_block(block, requirements->size, requirements->alignment, &allocation)) return allocation;
     }
 
-    if (app->surface_capabilities.currentExtent.width == 0 || app->surface_capabilities.currentExtent.height == 0)
-        return;
-
-    app->vkResetFences(app->device, 1, &app->in_flight_fences[app->current_frame]);
-
-    uint32_t image_index;
-    app->vkAcquireNextImageKHR(app->device, app->swapchain, UINT64_MAX,
-                               app->image_available_semaphores[app->current_frame], nullptr,
-                               &image_index);
+    uint32_t block_index = 0;
+    while (block_index < app->memory_block_count && app->memory_blocks[block_index].memory) ++block_index;
+    if (block_index == MAX_MEMORY_BLOCKS) fatal_error(app, L"Out of device memory blocks!");
+    if (block_index == app->memory_block_count) ++app->memory_block_count;
 
-    auto const command_buffer = app->command_buffers[app->current_frame];
-    app->vkResetCommandBuffer(command_buffer, 0);
-    app->vkBeginCommandBuffer(command_buffer, &(VkCommandBufferBeginInfo){
-                                  .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                              });
-    app->vkCmdBeginRenderPass(command_buffer, &(VkRenderPassBeginInfo){
-                                  .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-                                  .renderPass = app->renderpass,
-                                  .framebuffer = app->framebuffers[image_index],
-                                  .renderArea = {
-                                      .extent = app->surface_capabilities.currentExtent,
-                                  },
-                                  .clearValueCount = 1,
-                                  .pClearValues = &(VkClearValue){
-                                      .color = {
-                                          .float32 = {0.0f, 0.0f, 0.0f, 1.0f}
-                                      },
+    auto const block = &app->memory_blocks[block_index];
+    auto const size = requirements->size > MEMORY_BLOCK_SIZE ? requirements->size : MEMORY_BLOCK_SIZE;
+    block->memory_type_index = memory_type_index;
+    block->optimal_tiling = optimal_tiling;
+    block->size = size;
+    block->used = 0;
+    block->data = nullptr;
+    if (!block->free_ranges) {
+        block->free_range_capacity = INITIAL_FREE_RANGES;
+        block->free_ranges = malloc(INITIAL_FREE_RANGES * sizeof(MemoryRange));
+    }
+    block->free_range_count = 1;
+    block->free_ranges[0] = (MemoryRange){.size = size};
+    // every block can back buffers the shaders reach through their device address
+    if (app->vkAllocateMemory(app->device, &(VkMemoryAllocateInfo){
+                                  .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
+                                  .allocationSize = size,
+                                  .memoryTypeIndex = memory_type_index,
+                                  .pNext = &(VkMemoryAllocateFlagsInfo){
+                                      .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO,
+                                      .flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
                                   },
                               },
-                              VK_SUBPASS_CONTENTS_INLINE);
-    app->vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app->pipeline);
-    app->vkCmdSetViewport(command_buffer, 0, 1, &(VkViewport){
-                              .width = (float)app->surface_capabilities.currentExtent.width,
-                              .height = (float)app->surface_capabilities.currentExtent.height,
-                              .maxDepth = 1.0f,
-                          });
-    app->vkCmdSetScissor(command_buffer, 0, 1, &(VkRect2D){
-                             .extent = app->surface_capabilities.currentExtent,
-                         });
-    app->vkCmdBindVertexBuffers(command_buffer, 0, 1, &app->vertex_buffer, &(VkDeviceSize){0});
-    app->vkCmdBindIndexBuffer(command_buffer, app->index_buffer, 0, VK_INDEX_TYPE_UINT32);
-    app->vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app->pipeline_layout, 0, 1,
-                                 &app->descriptor_set, 0, nullptr);
-    app->vkCmdDrawIndexed(command_buffer, 6, 1, 0, 0, 0);
-    app->vkCmdEndRenderPass(command_buffer);
-    app->vkEndCommandBuffer(command_buffer);
+                              nullptr, &block->memory) != VK_SUCCESS)
+        fatal_error(app, L"Out of device memory!");
 
-    app->vkQueueSubmit(app->queue, 1, &(VkSubmitInfo){
-                           .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                           .waitSemaphoreCount = 1,
-                           .pWaitSemaphores = &app->image_available_semaphores[app->current_frame],
-                           .pWaitDstStageMask = (VkPipelineStageFlags[]){VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
-                           .commandBufferCount = 1,
-                           .pCommandBuffers = &command_buffer,
-                           .signalSemaphoreCount = 1,
-                           .pSignalSemaphores = &app->render_finished_semaphores[app->current_frame],
-                       },
-                       app->in_flight_fences[app->current_frame]);
-    app->vkQueuePresentKHR(app->queue, &(VkPresentInfoKHR){
-                               .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
-                               .waitSemaphoreCount = 1,
-                               .pWaitSemaphores = &app->render_finished_semaphores[app->current_frame],
-                               .swapchainCount = 1,
-                               .pSwapchains = &app->swapchain,
-                               .pImageIndices = &image_index,
-                           });
-    app->current_frame = (app->current_frame + 1) % IN_FLIGHT_FRAMES;
+    // host visible blocks stay mapped for their whole lifetime
+    if (app->memory_properties.memoryTypes[memory_type_index].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+        app->vkMapMemory(app->device, block->memory, 0, VK_WHOLE_SIZE, 0, (void**)&block->data);
+
+    allocation.block_index = block_index;
+    allocate_from_block(block, requirements->size, requirements->alignment, &allocation);
+    return allocation;
 }
 
-LRESULT handle_message(App *const app, HWND const window, unsigned int const message, WPARAM const wparam,
-                       LPARAM const lparam) {
-    switch (message) {
-        case WM_DESTROY:
-            PostQuitMessage(0);
-            return 0;
-        case WM_SIZE:
-            app->is_swapchain_dirty = true;
-            return 0;
-        case WM_PAINT:
-            render(app);
-            return 0;
-        default:
-            return DefWindowProcW(window, message, wparam, lparam);
-    }
+void free_device_memory(App *const app, MemoryAllocation const *const allocation) {
+    auto const block = &app->memory_blocks[allocation->block_index];
+    block->used -= allocation->range.size;
+    return_free_range_or_grow(&block->free_ranges, &block->free_range_count, &block->free_range_capacity,
+                              allocation->range);
 }
 
-LRESULT CALLBACK window_procedure(HWND const window, unsigned int const message, WPARAM const wparam,
-                                  LPARAM const lparam) {
-    auto const app = (App*)GetWindowLongPtrW(window, GWLP_USERDATA);
-    if (app) return handle_message(app, window, message, wparam, lparam);
-    if (message == WM_CREATE)
-        SetWindowLongPtrW(window, GWLP_USERDATA,
-                          (LONG_PTR)((CREATESTRUCTW*)lparam)->lpCreateParams);
-    return DefWindowProcW(window, message, wparam, lparam);
+void return_mesh_range(App *const app, MemoryRange const range) {
+    return_free_range_or_grow(&app->mesh_free_ranges, &app->mesh_free_range_count, &app->mesh_free_range_capacity,
+                              range);
 }
 
-void create_window(App *const app) {
-    RegisterClassExW(&(WNDCLASSEXW){
-        .cbSize = sizeof(WNDCLASSEXW),
-        .style = CS_HREDRAW | CS_VREDRAW,
-        .lpfnWndProc = window_procedure,
-        .hInstance = app->hinstance,
-        .hCursor = LoadCursorA(nullptr, IDC_ARROW),
-        .lpszClassName = app->window_title,
-    });
-    app->window = CreateWindowExW(0, app->window_title, app->window_title, WS_OVERLAPPEDWINDOW, CW_USEDEFAULT,
-                                  CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
-                                  nullptr, nullptr, app->hinstance, app);
+void free_mesh_range(App *const app, MemoryRange const range) {
+    app->chunk_quad_count -= (uint32_t)range.size;
+    return_mesh_range(app, range);
 }
 
-bool load_file(wchar_t const *filename, void **data, size_t *size) {
-    HANDLE const file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
-                                    FILE_ATTRIBUTE_NORMAL,
-                                    nullptr);
-    if (file == INVALID_HANDLE_VALUE) {
-        *data = nullptr;
-        *size = 0;
-        return false;
+// every quad of the arenas is free again, only while no frame in flight draws from them
+void reset_mesh_ranges(App *const app) {
+    if (!app->mesh_free_ranges) {
+        app->mesh_free_range_capacity = INITIAL_MESH_FREE_RANGES;
+        app->mesh_free_ranges = malloc(INITIAL_MESH_FREE_RANGES * sizeof(MemoryRange));
     }
-    *size = GetFileSize(file, nullptr);
-    *data = HeapAlloc(GetProcessHeap(), 0, *size);
-    DWORD read;
-    ReadFile(file, *data, *size, &read, nullptr);
-    CloseHandle(file);
-    return true;
+    app->chunk_quad_count = 0;
+    app->mesh_free_range_count = 1;
+    app->mesh_free_ranges[0] = (MemoryRange){.size = app->chunk_arena_quads};
 }
 
-void load_shaders(App *const app) {
-    auto const vkCreateShaderModule = (PFN_vkCreateShaderModule)app->vkGetDeviceProcAddr(
-        app->device, "vkCreateShaderModule");
+void *memory_allocation_data(App const *const app, MemoryAllocation const *const allocation) {
+    auto const block = &app->memory_blocks[allocation->block_index];
+    return block->data ? block->data + allocation->offset : nullptr;
+}
 
-    size_t shader_size;
-    if (!load_file(RESOURCES_PATH L"shaders/shader.spv", &app->shader_module_bytes, &shader_size)) {
-        MessageBoxW(nullptr, L"Cannot find shader!", app->window_title, MB_OK);
-        ExitProcess(1);
+// gives fully unused blocks back to the driver, live resources are never moved, so a fragmented block only
+// recovers once everything in it is freed
+void release_empty_memory_blocks(App *const app) {
+    for (uint32_t i = 0; i < app->memory_block_count; ++i) {
+        auto const block = &app->memory_blocks[i];
+        if (!block->memory || block->used) continue;
+        app->vkFreeMemory(app->device, block->memory, nullptr);
+        block->memory = nullptr;
     }
-
-    vkCreateShaderModule(app->device, &(VkShaderModuleCreateInfo){
-                             .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
-                             .codeSize = shader_size,
-                             .pCode = (uint32_t*)app->shader_module_bytes,
-                         },
-                         nullptr, &app->shader_module);
+    while (app->memory_block_count && !app->memory_blocks[app->memory_block_count - 1].memory)
+        --app->memory_block_count;
 }
 
-void unload_shaders(App const *const app) {
-    auto const vkDestroyShaderModule = (PFN_vkDestroyShaderModule)app->vkGetDeviceProcAddr(
-        app->device, "vkDestroyShaderModule");
-    vkDestroyShaderModule(app->device, app->shader_module, nullptr);
-    HeapFree(app->process_heap, 0, app->shader_module_bytes);
+MemoryAllocation bind_image_memory(App *const app, VkImage const image, VkMemoryPropertyFlags const required_properties) {
+    VkMemoryRequirements memory_requirements;
+    app->vkGetImageMemoryRequirements(app->device, image, &memory_requirements);
+    auto const allocation = allocate_device_memory(app, &memory_requirements, required_properties, true);
+    app->vkBindImageMemory(app->device, image, app->memory_blocks[allocation.block_index].memory, allocation.offset);
+    return allocation;
 }
 
-void create_pipeline_layout(App *const app) {
-    auto const vkCreatePipelineLayout = (PFN_vkCreatePipelineLayout)app->vkGetDeviceProcAddr(
-        app->device, "vkCreatePipelineLayout");
-    vkCreatePipelineLayout(app->device, &(VkPipelineLayoutCreateInfo){
-                               .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-                               .setLayoutCount = 1,
-                               .pSetLayouts = &app->descriptor_set_layout,
-                           },
-                           nullptr, &app->pipeline_layout);
+char const *present_mode_name(VkPresentModeKHR const present_mode) {
+    switch (present_mode) {
+        case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+        case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+        case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+        case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo relaxed";
+        default: return "unknown";
+    }
 }
 
-void create_pipeline(App *const app) {
-    auto const vkCreateGraphicsPipelines = (PFN_vkCreateGraphicsPipelines)app->vkGetDeviceProcAddr(
-        app->device, "vkCreateGraphicsPipelines");
-
-    vkCreateGraphicsPipelines(app->device, nullptr, 1, &(VkGraphicsPipelineCreateInfo){
-                                  .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-                                  .stageCount = 2,
-                                  .pStages = (VkPipelineShaderStageCreateInfo[]){
-                                      {
-                                          .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                                          .stage = VK_SHADER_STAGE_VERTEX_BIT,
-                                          .module = app->shader_module,
-                                          .pName = "main",
-                                      },
-                                      {
-                                          .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-                                          .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-                                          .module = app->shader_module,
-                                          .pName = "main",
-                                      },
-                                  },
-                                  .pVertexInputState = &(VkPipelineVertexInputStateCreateInfo){
-                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
-                                      .vertexBindingDescriptionCount = 1,
-                                      .pVertexBindingDescriptions = &(VkVertexInputBindingDescription){
-                                          .stride = sizeof(Vec2),
-                                      },
-                                      .vertexAttributeDescriptionCount = 1,
-                                      .pVertexAttributeDescriptions = (VkVertexInputAttributeDescription[]){
-                                          {
-                                              .format = VK_FORMAT_R32G32_SFLOAT,
-                                          }
-                                      },
+VkPresentModeKHR pick_present_mode(App const *const app) {
+    uint32_t mode_count = 0;
+    app->vkGetPhysicalDeviceSurfacePresentModesKHR(app->physical_device, app->surface, &mode_count, nullptr);
+    VkPresentModeKHR modes[mode_count];
+    app->vkGetPhysicalDeviceSurfacePresentModesKHR(app->physical_device, app->surface, &mode_count, modes);
+    for (uint32_t i = 0; i < mode_count; ++i)
+        if (modes[i] == app->requested_present_mode) return modes[i];
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
 
-                                  },
-                                  .pInputAssemblyState = &(VkPipelineInputAssemblyStateCreateInfo){
-                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-                                      .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
-                                  },
-                                  .pRasterizationState = &(VkPipelineRasterizationStateCreateInfo){
-                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-                                      .lineWidth = 1.0f,
-                                      .frontFace = VK_FRONT_FACE_CLOCKWISE,
-                                  },
-                                  .pMultisampleState = &(VkPipelineMultisampleStateCreateInfo){
-                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-                                      .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-                                  },
-                                  .pColorBlendState = &(VkPipelineColorBlendStateCreateInfo){
-                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-                                      .attachmentCount = 1,
-                                      .pAttachments = &(VkPipelineColorBlendAttachmentState){
-                                          .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-                                          VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
-                                      },
-                                  },
-                                  .layout = app->pipeline_layout,
-                                  .renderPass = app->renderpass,
-                                  .pDynamicState = &(VkPipelineDynamicStateCreateInfo){
-                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-                                      .dynamicStateCount = 2,
-                                      .pDynamicStates = (VkDynamicState[]){
-                                          VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR
-                                      },
-                                  },
-                                  .pViewportState = &(VkPipelineViewportStateCreateInfo){
-                                      .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-                                      .viewportCount = 1,
-                                      .scissorCount = 1,
-                                      .pViewports = &(VkViewport){},
-                                      .pScissors = &(VkRect2D){},
-                                  }
-                              },
-                              nullptr, &app->pipeline);
+// one image more than the minimum so the cpu does not wait for the presentation engine to release one
+uint32_t pick_swapchain_image_count(App const *const app) {
+    auto const capabilities = &app->surface_capabilities;
+    auto count = capabilities->minImageCount + 1;
+    if (capabilities->maxImageCount && count > capabilities->maxImageCount) count = capabilities->maxImageCount;
+    return count < MAX_SWAPCHAIN_IMAGES ? count : MAX_SWAPCHAIN_IMAGES;
 }
 
-void create_renderpass(App *app) {
-    auto const vkCreateRenderPass = (PFN_vkCreateRenderPass)app->vkGetDeviceProcAddr(app->device, "vkCreateRenderPass");
-    vkCreateRenderPass(app->device, &(VkRenderPassCreateInfo){
-                           .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
-                           .attachmentCount = 1,
-                           .pAttachments = &(VkAttachmentDescription){
-                               .format = VK_FORMAT_B8G8R8A8_SRGB,
-                               .samples = VK_SAMPLE_COUNT_1_BIT,
-                               .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
-                               .finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-                           },
-                           .subpassCount = 1,
-                           .pSubpasses = &(VkSubpassDescription){
-                               .colorAttachmentCount = 1,
-                               .pColorAttachments = &(VkAttachmentReference){
-                                   .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                               },
-                           },
-                           .pDependencies = &(VkSubpassDependency){
-                               .srcSubpass = VK_SUBPASS_EXTERNAL,
-                               .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                               .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                               .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-                           }
-                       },
-                       nullptr, &app->renderpass);
+void destroy_deferred(App *const app, DeferredDeletion const *const deletion) {
+    switch (deletion->type) {
+        case DEFERRED_IMAGE_VIEW:
+            app->vkDestroyImageView(app->device, deletion->image_view, nullptr);
+            break;
+        case DEFERRED_IMAGE:
+            app->vkDestroyImage(app->device, deletion->image, nullptr);
+            break;
+        case DEFERRED_MEMORY:
+            free_device_memory(app, &deletion->allocation);
+            break;
+        case DEFERRED_SWAPCHAIN:
+            app->vkDestroySwapchainKHR(app->device, deletion->swapchain, nullptr);
+            break;
+        case DEFERRED_SEMAPHORE:
+            app->vkDestroySemaphore(app->device, deletion->semaphore, nullptr);
+            break;
+        case DEFERRED_BUFFER:
+            app->vkDestroyBuffer(app->device, deletion->buffer, nullptr);
+            break;
+        case DEFERRED_TEXTURE_INDEX:
+            app->free_texture_indices[app->free_texture_index_count++] = deletion->texture_index;
+            break;
+        case DEFERRED_MESH_RANGE:
+            free_mesh_range(app, deletion->mesh_range);
+            break;
+    }
+}
+
+// destroys what no frame in flight uses anymore, deletions are queued in frame order
+void run_deferred_deletions(App *const app) {
+    while (app->deferred_deletion_count) {
+        auto const deletion = &app->deferred_deletions[app->deferred_deletion_first];
+        if (deletion->frame_count > app->completed_frame_count) break;
+        destroy_deferred(app, deletion);
+        app->deferred_deletion_first = (app->deferred_deletion_first + 1) % MAX_DEFERRED_DELETIONS;
+        --app->deferred_deletion_count;
+    }
+}
+
+// the object goes once frame_count frames are done, a full queue waits for the device instead
+void defer_deletion_until(App *const app, DeferredDeletion deletion, uint64_t const frame_count) {
+    if (app->deferred_deletion_count == MAX_DEFERRED_DELETIONS) {
+        app->vkDeviceWaitIdle(app->device);
+        app->completed_frame_count = app->frame_count;
+        run_deferred_deletions(app);
+    }
+    deletion.frame_count = frame_count;
+    app->deferred_deletions[(app->deferred_deletion_first + app->deferred_deletion_count++) %
+                            MAX_DEFERRED_DELETIONS] = deletion;
+}
+
+// the object goes once the frames recorded so far are done
+void defer_deletion(App *const app, DeferredDeletion const deletion) {
+    defer_deletion_until(app, deletion, app->frame_count);
+}
+
+void configure_swapchain(App *const app) {
+    auto const old_swapchain = app->swapchain;
+    if (!old_swapchain) {
+        app->present_mode = pick_present_mode(app);
+        printf("presenting with %s\n", present_mode_name(app->present_mode));
+    }
+    app->vkCreateSwapchainKHR(app->device, &(VkSwapchainCreateInfoKHR){
+                                  .sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR,
+                                  .surface = app->surface,
+                                  .minImageCount = pick_swapchain_image_count(app),
+                                  .imageFormat = VK_FORMAT_B8G8R8A8_SRGB,
+                                  .imageExtent = app->surface_capabilities.currentExtent,
+                                  .imageArrayLayers = 1,
+                                  .imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
+                                  .preTransform = app->surface_capabilities.currentTransform,
+                                  .compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR,
+                                  .presentMode = app->present_mode,
+                                  .clipped = true,
+                                  .oldSwapchain = old_swapchain,
+                              },
+                              nullptr, &app->swapchain);
+    // the old swapchain keeps presenting what was already rendered into it, and its presents may still wait on the
+    // render finished semaphores, so the new images get semaphores of their own
+    if (old_swapchain) {
+        for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
+            defer_deletion(app, (DeferredDeletion){
+                               .type = DEFERRED_IMAGE_VIEW,
+                               .image_view = app->swapchain_image_views[i],
+                           });
+        defer_deletion(app, (DeferredDeletion){.type = DEFERRED_SWAPCHAIN, .swapchain = old_swapchain});
+        for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
+            defer_deletion(app, (DeferredDeletion){
+                               .type = DEFERRED_SEMAPHORE,
+                               .semaphore = app->render_finished_semaphores[i],
+                           });
+    }
+
+    app->vkGetSwapchainImagesKHR(app->device, app->swapchain, &app->swapchain_image_count, nullptr);
+    app->vkGetSwapchainImagesKHR(app->device, app->swapchain, &app->swapchain_image_count, app->swapchain_images);
+
+    for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
+        app->vkCreateSemaphore(app->device, &(VkSemaphoreCreateInfo){.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO},
+                               nullptr, &app->render_finished_semaphores[i]);
+    for (uint32_t i = 0; i < app->swapchain_image_count; ++i)
+        app->vkCreateImageView(app->device, &(VkImageViewCreateInfo){
+                                   .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                                   .image = app->swapchain_images[i],
+                                   .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                                   .format = VK_FORMAT_B8G8R8A8_SRGB,
+                                   .subresourceRange = {
+                                       .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                       .levelCount = 1,
+                                       .layerCount = 1,
+                                   },
+                               },
+                               nullptr, &app->swapchain_image_views[i]);
+}
+
+void update_surface_capabilities(App *const app) {
+    app->vkGetPhysicalDeviceSurfaceCapabilitiesKHR(app->physical_device, app->surface, &app->surface_capabilities);
+}
+
+void retire_depth_image(App *const app) {
+    if (!app->depth_image) return;
+    defer_deletion(app, (DeferredDeletion){.type = DEFERRED_IMAGE_VIEW, .image_view = app->depth_image_view});
+    defer_deletion(app, (DeferredDeletion){.type = DEFERRED_IMAGE, .image = app->depth_image});
+    defer_deletion(app, (DeferredDeletion){.type = DEFERRED_MEMORY, .allocation = app->depth_image_allocation});
+    app->depth_image = nullptr;
+}
+
+// one depth image shared by every swapchain image, the barrier before rendering orders its writes across frames
+void configure_depth_image(App *const app) {
+    auto const extent = app->surface_capabilities.currentExtent;
+    app->vkCreateImage(app->device, &(VkImageCreateInfo){
+                           .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                           .imageType = VK_IMAGE_TYPE_2D,
+                           .format = app->depth_format,
+                           .extent = {
+                               .width = extent.width,
+                               .height = extent.height,
+                               .depth = 1,
+                           },
+                           .mipLevels = 1,
+                           .arrayLayers = 1,
+                           .samples = VK_SAMPLE_COUNT_1_BIT,
+                           .tiling = VK_IMAGE_TILING_OPTIMAL,
+                           .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+                           .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                       },
+                       nullptr, &app->depth_image);
+    app->depth_image_allocation = bind_image_memory(app, app->depth_image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    app->vkCreateImageView(app->device, &(VkImageViewCreateInfo){
+                               .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                               .image = app->depth_image,
+                               .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                               .format = app->depth_format,
+                               .subresourceRange = {
+                                   .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                                   .levelCount = 1,
+                                   .layerCount = 1,
+                               },
+                           },
+                           nullptr, &app->depth_image_view);
+}
+
+// never waits for the gpu, the frames in flight finish with the old resources while the next one uses the new ones
+void setup_swapchain_dependent_resources(App *const app) {
+    update_surface_capabilities(app);
+    auto const extent = app->surface_capabilities.currentExtent;
+    if (extent.width == 0 || extent.height == 0) return;
+    retire_depth_image(app);
+    configure_swapchain(app);
+    configure_depth_image(app);
+    memset(app->image_in_flight_fences, 0, sizeof(app->image_in_flight_fences));
+}
+
+void retire_uploads(App *const app) {
+    uint64_t completed;
+    app->vkGetSemaphoreCounterValue(app->device, app->upload_semaphore, &completed);
+    while (app->upload_batch_count && app->upload_batches[app->upload_batch_first].timeline_value <= completed) {
+        app->upload_tail = app->upload_batches[app->upload_batch_first].ring_end;
+        app->upload_batch_first = (app->upload_batch_first + 1) % MAX_UPLOAD_BATCHES;
+        --app->upload_batch_count;
+    }
+    if (app->upload_tail == app->upload_head) app->upload_head = app->upload_tail = 0;
+}
+
+void wait_for_upload(App *const app, uint64_t const timeline_value) {
+    app->vkWaitSemaphores(app->device, &(VkSemaphoreWaitInfo){
+                              .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+                              .semaphoreCount = 1,
+                              .pSemaphores = &app->upload_semaphore,
+                              .pValues = &timeline_value,
+                          },
+                          UINT64_MAX);
+    retire_uploads(app);
+}
+
+bool is_upload_complete(App const *const app, uint64_t const timeline_value) {
+    uint64_t completed;
+    app->vkGetSemaphoreCounterValue(app->device, app->upload_semaphore, &completed);
+    return completed >= timeline_value;
+}
+
+// submits everything recorded since the last flush, returns the timeline value that marks its completion
+uint64_t flush_uploads(App *const app) {
+    if (!app->is_upload_recording) return app->upload_timeline_value;
+
+    auto const batch = &app->upload_batches[(app->upload_batch_first + app->upload_batch_count) % MAX_UPLOAD_BATCHES];
+    app->vkEndCommandBuffer(batch->command_buffer);
+    batch->timeline_value = ++app->upload_timeline_value;
+    batch->ring_end = app->upload_head;
+    app->vkQueueSubmit2(app->transfer_queue, 1, &(VkSubmitInfo2){
+                            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                            .commandBufferInfoCount = 1,
+                            .pCommandBufferInfos = &(VkCommandBufferSubmitInfo){
+                                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+                                .commandBuffer = batch->command_buffer,
+                            },
+                            .signalSemaphoreInfoCount = 1,
+                            .pSignalSemaphoreInfos = &(VkSemaphoreSubmitInfo){
+                                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                .semaphore = app->upload_semaphore,
+                                .value = batch->timeline_value,
+                                .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                            },
+                        },
+                        nullptr);
+    ++app->upload_batch_count;
+    app->is_upload_recording = false;
+    return batch->timeline_value;
+}
+
+VkCommandBuffer begin_upload_batch(App *const app) {
+    if (!app->is_upload_recording && app->upload_batch_count == MAX_UPLOAD_BATCHES)
+        wait_for_upload(app, app->upload_batches[app->upload_batch_first].timeline_value);
+
+    auto const command_buffer = app->upload_batches[(app->upload_batch_first + app->upload_batch_count) %
+                                                    MAX_UPLOAD_BATCHES].command_buffer;
+    if (!app->is_upload_recording) {
+        app->vkBeginCommandBuffer(command_buffer, &(VkCommandBufferBeginInfo){
+                                      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                                      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+                                  });
+        app->is_upload_recording = true;
+    }
+    return command_buffer;
+}
+
+// returns the offset of size free bytes in the ring, only waits for the transfer queue when the ring is full
+VkDeviceSize reserve_upload_memory(App *const app, VkDeviceSize const size) {
+    if (size > UPLOAD_RING_SIZE) fatal_error(app, L"Upload does not fit into the staging ring!");
+    auto const alignment = app->physical_device_properties.limits.optimalBufferCopyOffsetAlignment > 16
+                               ? app->physical_device_properties.limits.optimalBufferCopyOffsetAlignment
+                               : 16;
+    for (;;) {
+        auto offset = (app->upload_head + alignment - 1) / alignment * alignment;
+        // a range never wraps around the end of the ring
+        if (offset % UPLOAD_RING_SIZE + size > UPLOAD_RING_SIZE)
+            offset = (offset / UPLOAD_RING_SIZE + 1) * UPLOAD_RING_SIZE;
+        if (offset + size - app->upload_tail <= UPLOAD_RING_SIZE) {
+            app->upload_head = offset + size;
+            return offset % UPLOAD_RING_SIZE;
+        }
+        if (!app->upload_batch_count) flush_uploads(app);
+        wait_for_upload(app, app->upload_batches[app->upload_batch_first].timeline_value);
+    }
+}
+
+bool is_queue_family_transfer(App const *const app) { return app->transfer_queue_family != app->graphics_queue_family; }
+
+VkBuffer create_buffer(App *const app, VkDeviceSize const size,
+                       MemoryAllocation *const allocation, VkBufferUsageFlags const usage,
+                       VkMemoryPropertyFlags const required_properties) {
+    // buffers the transfer queue writes are shared with the graphics queue, so an upload into a range of one that
+    // is being drawn from needs no ownership transfer of the whole buffer
+    uint32_t const queue_families[] = {app->graphics_queue_family, app->transfer_queue_family};
+    bool const is_shared = (usage & VK_BUFFER_USAGE_TRANSFER_DST_BIT) && is_queue_family_transfer(app);
+    VkBuffer buffer;
+    app->vkCreateBuffer(app->device, &(VkBufferCreateInfo){
+                            .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+                            .size = size,
+                            .usage = usage,
+                            .sharingMode = is_shared ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+                            .queueFamilyIndexCount = is_shared ? 2 : 0,
+                            .pQueueFamilyIndices = is_shared ? queue_families : nullptr,
+                        },
+                        nullptr, &buffer);
+
+    VkMemoryRequirements memory_requirements;
+    app->vkGetBufferMemoryRequirements(app->device, buffer, &memory_requirements);
+    *allocation = allocate_device_memory(app, &memory_requirements, required_properties, false);
+
+    app->vkBindBufferMemory(app->device, buffer, app->memory_blocks[allocation->block_index].memory, allocation->offset);
+    return buffer;
+}
+
+VkDeviceAddress get_buffer_device_address(App const *const app, VkBuffer const buffer) {
+    return app->vkGetBufferDeviceAddress(app->device, &(VkBufferDeviceAddressInfo){
+                                             .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO,
+                                             .buffer = buffer,
+                                         });
+}
+
+void destroy_buffer(App *const app, VkBuffer const buffer, MemoryAllocation const *const allocation) {
+    app->vkDestroyBuffer(app->device, buffer, nullptr);
+    free_device_memory(app, allocation);
+}
+
+// returns where the caller writes size bytes, they land in buffer at offset once the batch executes
+// the frame waits for the batch on the upload timeline before it reads anything, which also makes the copy visible
+void *upload_buffer_region(App *const app, VkBuffer const buffer, VkDeviceSize const offset, VkDeviceSize const size) {
+    auto const ring_offset = reserve_upload_memory(app, size);
+    auto const command_buffer = begin_upload_batch(app);
+    app->vkCmdCopyBuffer(command_buffer, app->upload_buffer, buffer, 1, &(VkBufferCopy){
+                             .srcOffset = ring_offset,
+                             .dstOffset = offset,
+                             .size = size,
+                         });
+    return app->upload_data + ring_offset;
+}
+
+void upload_buffer(App *const app, VkBuffer const buffer, VkDeviceSize const offset, void const *data,
+                   VkDeviceSize const size) {
+    memcpy(upload_buffer_region(app, buffer, offset, size), data, size);
+}
+
+// the vertex arena is read through its address and the index arena is bound, both are copied from when they grow
+void create_chunk_arenas(App *const app, uint32_t const quad_count) {
+    app->chunk_arena_quads = quad_count;
+    app->chunk_vertex_buffer = create_buffer(app, (VkDeviceSize)quad_count * 4 * sizeof(MeshVertex),
+                                             &app->chunk_vertex_allocation,
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    app->chunk_vertex_buffer_device_address = get_buffer_device_address(app, app->chunk_vertex_buffer);
+    app->chunk_index_buffer = create_buffer(app, (VkDeviceSize)quad_count * 6 * sizeof(uint32_t),
+                                            &app->chunk_index_allocation,
+                                            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+}
+
+// doubles the arenas, the meshes keep their offsets and the frames in flight keep drawing from the old arenas
+void grow_chunk_arenas(App *const app) {
+    auto const old_vertex_buffer = app->chunk_vertex_buffer;
+    auto const old_vertex_allocation = app->chunk_vertex_allocation;
+    auto const old_index_buffer = app->chunk_index_buffer;
+    auto const old_index_allocation = app->chunk_index_allocation;
+    auto const old_quads = app->chunk_arena_quads;
+    create_chunk_arenas(app, old_quads * 2);
+
+    // the copies wait for the uploads into the old arenas, the uploads after them for the copies
+    auto const command_buffer = begin_upload_batch(app);
+    VkDependencyInfo const copy_dependency = {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+        .memoryBarrierCount = 1,
+        .pMemoryBarriers = &(VkMemoryBarrier2){
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+            .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+            .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+            .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        },
+    };
+    app->vkCmdPipelineBarrier2(command_buffer, &copy_dependency);
+    app->vkCmdCopyBuffer(command_buffer, old_vertex_buffer, app->chunk_vertex_buffer, 1, &(VkBufferCopy){
+                             .size = (VkDeviceSize)old_quads * 4 * sizeof(MeshVertex),
+                         });
+    app->vkCmdCopyBuffer(command_buffer, old_index_buffer, app->chunk_index_buffer, 1, &(VkBufferCopy){
+                             .size = (VkDeviceSize)old_quads * 6 * sizeof(uint32_t),
+                         });
+    app->vkCmdPipelineBarrier2(command_buffer, &copy_dependency);
+    // nothing waits here, the next frame to be submitted waits for the copies on the upload timeline like for any
+    // upload, so the old arenas go once that frame is done too
+    defer_deletion_until(app, (DeferredDeletion){.type = DEFERRED_BUFFER, .buffer = old_vertex_buffer},
+                         app->frame_count + 1);
+    defer_deletion_until(app, (DeferredDeletion){.type = DEFERRED_MEMORY, .allocation = old_vertex_allocation},
+                         app->frame_count + 1);
+    defer_deletion_until(app, (DeferredDeletion){.type = DEFERRED_BUFFER, .buffer = old_index_buffer},
+                         app->frame_count + 1);
+    defer_deletion_until(app, (DeferredDeletion){.type = DEFERRED_MEMORY, .allocation = old_index_allocation},
+                         app->frame_count + 1);
+    return_mesh_range(app, (MemoryRange){.offset = old_quads, .size = old_quads});
+}
+
+// ranges of the chunk arenas are counted in quads, the arenas grow until one fits
+MemoryRange allocate_mesh_range(App *const app, uint32_t const quad_count) {
+    VkDeviceSize offset;
+    MemoryRange range;
+    while (!take_free_range(app->mesh_free_ranges, &app->mesh_free_range_count, quad_count, 1, &offset, &range))
+        grow_chunk_arenas(app);
+    app->chunk_quad_count += quad_count;
+    return range;
+}
+
+// regions are relative to the returned pointer, the image ends up in SHADER_READ_ONLY_OPTIMAL for all mip levels
+void *upload_image(App *const app, VkImage const image, uint32_t const mip_levels, uint32_t const region_count,
+                   VkBufferImageCopy const *regions, VkDeviceSize const size) {
+    auto const ring_offset = reserve_upload_memory(app, size);
+    auto const command_buffer = begin_upload_batch(app);
+    VkImageSubresourceRange const subresource_range = {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .levelCount = mip_levels,
+        .layerCount = 1,
+    };
+
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .imageMemoryBarrierCount = 1,
+                                   .pImageMemoryBarriers = &(VkImageMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                       .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                                       .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                       .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                       .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                       .image = image,
+                                       .subresourceRange = subresource_range,
+                                   },
+                               });
+
+    VkBufferImageCopy ring_regions[region_count];
+    for (uint32_t i = 0; i < region_count; ++i) {
+        ring_regions[i] = regions[i];
+        ring_regions[i].bufferOffset += ring_offset;
+    }
+    app->vkCmdCopyBufferToImage(command_buffer, app->upload_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                region_count, ring_regions);
+
+    // with a dedicated transfer queue this is the release half of the ownership transfer, the frame acquires it
+    // the frame waits for the batch on its timeline semaphore before any use, so nothing is blocked here
+    VkImageMemoryBarrier2 const release = {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+        .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+        .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .srcQueueFamilyIndex = is_queue_family_transfer(app) ? app->transfer_queue_family : VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = is_queue_family_transfer(app) ? app->graphics_queue_family : VK_QUEUE_FAMILY_IGNORED,
+        .image = image,
+        .subresourceRange = subresource_range,
+    };
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .imageMemoryBarrierCount = 1,
+                                   .pImageMemoryBarriers = &release,
+                               });
+    if (is_queue_family_transfer(app)) {
+        if (app->upload_image_acquire_count == app->upload_image_acquire_capacity) {
+            app->upload_image_acquire_capacity = app->upload_image_acquire_capacity
+                                                     ? app->upload_image_acquire_capacity * 2
+                                                     : 64;
+            app->upload_image_acquires = realloc(app->upload_image_acquires, app->upload_image_acquire_capacity *
+                                                                             sizeof(VkImageMemoryBarrier2));
+        }
+        auto const acquire = &app->upload_image_acquires[app->upload_image_acquire_count++];
+        *acquire = release;
+        acquire->srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+        acquire->srcAccessMask = VK_ACCESS_2_NONE;
+        acquire->dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        acquire->dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    }
+    return app->upload_data + ring_offset;
+}
+
+// the image was uploaded with only its first level filled, the frame blits the rest before drawing
+void request_mipmaps(App *const app, VkImage const image, VkExtent2D const extent, uint32_t const mip_levels) {
+    if (mip_levels < 2) return;
+    if (app->mipmap_request_count == app->mipmap_request_capacity) {
+        app->mipmap_request_capacity = app->mipmap_request_capacity ? app->mipmap_request_capacity * 2 : 16;
+        app->mipmap_requests = realloc(app->mipmap_requests, app->mipmap_request_capacity * sizeof(MipmapRequest));
+    }
+    app->mipmap_requests[app->mipmap_request_count++] = (MipmapRequest){
+        .image = image,
+        .extent = extent,
+        .mip_levels = mip_levels,
+    };
+    // the ownership acquire has to make the base level visible to the blits as well
+    for (uint32_t i = 0; i < app->upload_image_acquire_count; ++i)
+        if (app->upload_image_acquires[i].image == image) {
+            app->upload_image_acquires[i].dstStageMask |= VK_PIPELINE_STAGE_2_BLIT_BIT;
+            app->upload_image_acquires[i].dstAccessMask |= VK_ACCESS_2_TRANSFER_READ_BIT;
+        }
+}
+
+void generate_mipmaps(App *const app, VkCommandBuffer const command_buffer) {
+    for (uint32_t i = 0; i < app->mipmap_request_count; ++i) {
+        auto const request = &app->mipmap_requests[i];
+        // the blit stage chains these after the ownership acquire, which blocks the blits as well
+        VkImageMemoryBarrier2 barriers[] = {
+            {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT,
+                .dstAccessMask = VK_ACCESS_2_TRANSFER_READ_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = request->image,
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .levelCount = 1,
+                    .layerCount = 1,
+                },
+            },
+            {
+                .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                .srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT,
+                .dstStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT,
+                .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                .image = request->image,
+                .subresourceRange = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .baseMipLevel = 1,
+                    .levelCount = request->mip_levels - 1,
+                    .layerCount = 1,
+                },
+            },
+        };
+        app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                       .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                       .imageMemoryBarrierCount = 2,
+                                       .pImageMemoryBarriers = barriers,
+                                   });
+
+        // each level is blitted from the one above it, which then becomes the next source
+        int32_t width = (int32_t)request->extent.width, height = (int32_t)request->extent.height;
+        for (uint32_t level = 1; level < request->mip_levels; ++level) {
+            int32_t const level_width = width > 1 ? width / 2 : 1, level_height = height > 1 ? height / 2 : 1;
+            app->vkCmdBlitImage(command_buffer, request->image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, request->image,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &(VkImageBlit){
+                                    .srcSubresource = {
+                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                        .mipLevel = level - 1,
+                                        .layerCount = 1,
+                                    },
+                                    .srcOffsets = {{}, {width, height, 1}},
+                                    .dstSubresource = {
+                                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                        .mipLevel = level,
+                                        .layerCount = 1,
+                                    },
+                                    .dstOffsets = {{}, {level_width, level_height, 1}},
+                                },
+                                VK_FILTER_LINEAR);
+            barriers[0].srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+            barriers[0].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barriers[0].subresourceRange.baseMipLevel = level;
+            app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                           .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                           .imageMemoryBarrierCount = 1,
+                                           .pImageMemoryBarriers = barriers,
+                                       });
+            width = level_width;
+            height = level_height;
+        }
+
+        app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                       .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                       .imageMemoryBarrierCount = 1,
+                                       .pImageMemoryBarriers = &(VkImageMemoryBarrier2){
+                                           .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                                           .srcStageMask = VK_PIPELINE_STAGE_2_BLIT_BIT,
+                                           .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                           .dstStageMask = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                                           .dstAccessMask = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                                           .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                           .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                           .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                           .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                           .image = request->image,
+                                           .subresourceRange = {
+                                               .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                               .levelCount = request->mip_levels,
+                                               .layerCount = 1,
+                                           },
+                                       },
+                                   });
+    }
+    app->mipmap_request_count = 0;
+}
+
+// matches the push constant block in shader.vert
+typedef struct {
+    Mat4 view_projection;
+    VkDeviceAddress chunk_info_buffer_device_address;
+    VkDeviceAddress vertex_buffer_device_address;
+    VkDeviceAddress block_texture_buffer_device_address;
+} PushConstants;
+
+// matches the push constant block in cull.comp
+typedef struct {
+    VkDeviceAddress cull_frame_device_address;
+    VkDeviceAddress chunk_info_buffer_device_address;
+    VkDeviceAddress draw_command_buffer_device_address;
+    VkDeviceAddress draw_count_buffer_device_address;
+} CullConstants;
+
+// matches CullFrame in cull.comp, written to frame memory every frame
+typedef struct {
+    float frustum_planes[6][4];
+    uint32_t visible_count;
+    uint32_t visible_chunks[];
+} CullFrame;
+
+// matches the std430 layout of ChunkDrawInfo in cull.comp and shader.vert, bounds are in world space
+typedef struct {
+    float origin[3];
+    uint32_t index_count;
+    float bounds_min[3];
+    uint32_t first_index;
+    float bounds_max[3];
+    int32_t vertex_offset;
+} ChunkDrawInfo;
+
+Vec3 vec3_subtract(Vec3 const a, Vec3 const b) { return (Vec3){a.x - b.x, a.y - b.y, a.z - b.z}; }
+
+float vec3_dot(Vec3 const a, Vec3 const b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Vec3 vec3_cross(Vec3 const a, Vec3 const b) {
+    return (Vec3){a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+Vec3 vec3_normalize(Vec3 const v) {
+    float const inverse_length = 1.0f / sqrtf(vec3_dot(v, v));
+    return (Vec3){v.x * inverse_length, v.y * inverse_length, v.z * inverse_length};
+}
+
+Mat4 mat4_multiply(Mat4 const *const a, Mat4 const *const b) {
+    Mat4 result = {};
+    for (uint32_t column = 0; column < 4; ++column)
+        for (uint32_t row = 0; row < 4; ++row)
+            for (uint32_t k = 0; k < 4; ++k)
+                result.columns[column][row] += a->columns[k][row] * b->columns[column][k];
+    return result;
+}
+
+// right handed view space looking down -z
+Mat4 mat4_look_at(Vec3 const eye, Vec3 const target, Vec3 const up) {
+    auto const forward = vec3_normalize(vec3_subtract(target, eye));
+    auto const right = vec3_normalize(vec3_cross(forward, up));
+    auto const camera_up = vec3_cross(right, forward);
+    return (Mat4){
+        .columns = {
+            {right.x, camera_up.x, -forward.x, 0.0f},
+            {right.y, camera_up.y, -forward.y, 0.0f},
+            {right.z, camera_up.z, -forward.z, 0.0f},
+            {-vec3_dot(right, eye), -vec3_dot(camera_up, eye), vec3_dot(forward, eye), 1.0f},
+        },
+    };
+}
+
+// vulkan clip space, y points down and depth goes from 0 at near to 1 at far
+Mat4 mat4_perspective(float const vertical_fov, float const aspect, float const near, float const far) {
+    float const focal_length = 1.0f / tanf(vertical_fov * 0.5f);
+    return (Mat4){
+        .columns = {
+            {focal_length / aspect, 0.0f, 0.0f, 0.0f},
+            {0.0f, -focal_length, 0.0f, 0.0f},
+            {0.0f, 0.0f, far / (near - far), -1.0f},
+            {0.0f, 0.0f, near * far / (near - far), 0.0f},
+        },
+    };
+}
+
+// gribb hartmann planes for a 0 to 1 depth range, left right bottom top near far, normals point inside
+void extract_frustum_planes(Mat4 const *const view_projection, float planes[6][4]) {
+    for (uint32_t i = 0; i < 4; ++i) {
+        auto const column = view_projection->columns[i];
+        planes[0][i] = column[3] + column[0];
+        planes[1][i] = column[3] - column[0];
+        planes[2][i] = column[3] + column[1];
+        planes[3][i] = column[3] - column[1];
+        planes[4][i] = column[2];
+        planes[5][i] = column[3] - column[2];
+    }
+}
+
+typedef struct {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkDeviceAddress device_address;
+    void *data;
+} FrameAllocation;
+
+// valid until the same frame slot comes around again
+FrameAllocation allocate_frame_memory(App *const app, VkDeviceSize const size) {
+    auto const offset = (app->frame_memory_cursor + FRAME_MEMORY_ALIGNMENT - 1) & ~(FRAME_MEMORY_ALIGNMENT - 1);
+    if (offset + size > app->frame_memory_size) fatal_error(app, L"Out of per frame memory!");
+    app->frame_memory_cursor = offset + size;
+
+    auto const buffer_offset = app->current_frame * app->frame_memory_size + offset;
+    return (FrameAllocation){
+        .buffer = app->frame_memory_buffer,
+        .offset = buffer_offset,
+        .device_address = app->frame_memory_device_address + buffer_offset,
+        .data = app->frame_memory_data + buffer_offset,
+    };
+}
+
+// timestamps bracket the work recorded between them, zones are skipped when the queue has no timestamps
+uint32_t begin_gpu_zone(App *const app, VkCommandBuffer const command_buffer, char const *const name) {
+    auto const frame = app->current_frame;
+    if (!app->timestamp_valid_bits || app->gpu_zone_counts[frame] == MAX_GPU_ZONES) return UINT32_MAX;
+    auto const zone = app->gpu_zone_counts[frame]++;
+    app->gpu_zone_names[frame][zone] = name;
+    app->vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_NONE, app->timestamp_pools[frame], zone * 2);
+    return zone;
+}
+
+void end_gpu_zone(App *const app, VkCommandBuffer const command_buffer, uint32_t const zone) {
+    if (zone == UINT32_MAX) return;
+    app->vkCmdWriteTimestamp2(command_buffer, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                              app->timestamp_pools[app->current_frame], zone * 2 + 1);
+}
+
+// only called once the fence of the frame slot signaled, so the results are there without waiting
+void resolve_gpu_zones(App *const app, size_t const frame) {
+    auto const zone_count = app->gpu_zone_counts[frame];
+    app->gpu_zone_counts[frame] = 0;
+    if (!zone_count) return;
+
+    uint64_t timestamps[MAX_GPU_ZONES * 2];
+    if (app->vkGetQueryPoolResults(app->device, app->timestamp_pools[frame], 0, zone_count * 2, sizeof(timestamps),
+                                   timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+        return;
+
+    auto const mask = app->timestamp_valid_bits == 64 ? UINT64_MAX : (1ull << app->timestamp_valid_bits) - 1;
+    double const period = app->physical_device_properties.limits.timestampPeriod;
+    uint64_t first = UINT64_MAX;
+    for (uint32_t i = 0; i < zone_count * 2; ++i) {
+        timestamps[i] = (uint64_t)((double)(timestamps[i] & mask) * period);
+        if (timestamps[i] < first) first = timestamps[i];
+    }
+    // the gpu clock is only known up to an offset, a frame cannot start on the gpu before the cpu submitted it
+    auto const earliest_offset = (int64_t)app->gpu_submit_times[frame] - (int64_t)first;
+    if (!app->has_gpu_time_offset || earliest_offset > app->gpu_time_offset) {
+        app->gpu_time_offset = earliest_offset;
+        app->has_gpu_time_offset = true;
+    }
+    // the first zone of every frame spans all of it
+    ++app->frame_totals.gpu_frame_count;
+    app->frame_totals.gpu_time_ns += timestamps[1] - timestamps[0];
+    // the frame cannot be presented before the gpu finished it, without present timing that is as close as it gets
+    auto const input_ns = (int64_t)app->frame_input_times[frame];
+    auto const finished_ns = (int64_t)timestamps[1] + app->gpu_time_offset;
+    if (input_ns && finished_ns > input_ns) profiler_add_latency(&app->profiler, (uint64_t)(finished_ns - input_ns));
+    for (uint32_t i = 0; i < zone_count; ++i)
+        profiler_add_zone(&app->profiler, PROFILER_TRACK_GPU, app->gpu_zone_names[frame][i],
+                          (uint64_t)((int64_t)timestamps[i * 2] + app->gpu_time_offset),
+                          (uint64_t)((int64_t)timestamps[i * 2 + 1] + app->gpu_time_offset),
+                          app->gpu_zone_frames[frame]);
+}
+
+RegionFile *chunk_region(App const *const app, int32_t const chunk_x, int32_t const chunk_z) {
+    return &app->world_regions[region_coordinate(chunk_x) + region_coordinate(chunk_z) * app->world_region_span];
+}
+
+// the world is played without saving when a region file cannot be opened
+void open_world_regions(App *const app, int32_t const size) {
+    constexpr size_t MAX_REGION_PATH_LENGTH = 1024;
+    native_make_directory(app->world_path);
+    auto const span = region_coordinate(size - 1) + 1;
+    RegionFile *const regions = malloc((size_t)(span * span) * sizeof(RegionFile));
+    for (int32_t i = 0; i < span * span; ++i) {
+        NativeChar path[MAX_REGION_PATH_LENGTH];
+        native_print(path, MAX_REGION_PATH_LENGTH, NATIVE_STRING_FORMAT NATIVE_TEXT("/r.%d.0.%d.region"),
+                     app->world_path, i % span, i / span);
+        if (region_open(&regions[i], path, i % span, 0, i / span)) continue;
+        fprintf(stderr, "failed to open a region file, the world is not saved\n");
+        for (int32_t j = 0; j < i; ++j) region_close(&regions[j]);
+        free(regions);
+        return;
+    }
+    app->world_regions = regions;
+    app->world_region_span = span;
+}
+
+void close_world_regions(App *const app) {
+    if (!app->world_regions) return;
+    for (int32_t i = 0; i < app->world_region_span * app->world_region_span; ++i)
+        region_close(&app->world_regions[i]);
+    free(app->world_regions);
+    app->world_regions = nullptr;
+}
+
+void save_chunk(App *const app, Chunk const *const chunk) {
+    if (!region_write_chunk(chunk_region(app, chunk->x, chunk->z),
+                            &app->region_scratches[job_system_worker_index(app->jobs)], chunk))
+        fprintf(stderr, "failed to save chunk %d %d %d\n", chunk->x, chunk->y, chunk->z);
+}
+
+// the next frame copies the entry to chunk_info_buffer along with every other entry changed until then
+void set_draw_info(App *const app, uint32_t const draw_index, ChunkDrawInfo const *const info) {
+    app->chunk_draw_infos[draw_index] = *info;
+    if (app->dirty_draw_info_begin == app->dirty_draw_info_end) {
+        app->dirty_draw_info_begin = draw_index;
+        app->dirty_draw_info_end = draw_index + 1;
+    } else {
+        if (draw_index < app->dirty_draw_info_begin) app->dirty_draw_info_begin = draw_index;
+        if (draw_index >= app->dirty_draw_info_end) app->dirty_draw_info_end = draw_index + 1;
+    }
+}
+
+// the section mesh goes to a new range of the arenas, the old one is only reused once no frame in flight draws it,
+// so the frames keep drawing the old mesh until the one that switches the draw info over
+void replace_section_mesh(App *const app, uint32_t const chunk_index, uint32_t const section,
+                          ChunkMesh const *const mesh) {
+    auto const loaded = &app->loaded_chunks[chunk_index];
+    auto const chunk = loaded->chunk;
+    auto const range = &loaded->ranges[section];
+    if (range->size) defer_deletion(app, (DeferredDeletion){.type = DEFERRED_MESH_RANGE, .mesh_range = *range});
+    auto const quad_count = mesh->vertex_count / 4;
+    *range = quad_count ? allocate_mesh_range(app, quad_count) : (MemoryRange){};
+
+    ChunkDrawInfo info = {
+        .origin = {(float)(chunk->x * (int32_t)CHUNK_SIZE), (float)(chunk->y * (int32_t)CHUNK_SIZE),
+                   (float)(chunk->z * (int32_t)CHUNK_SIZE)},
+        .index_count = mesh->index_count,
+        .first_index = (uint32_t)range->offset * 6,
+        .vertex_offset = (int32_t)range->offset * 4,
+    };
+    // bounds of the corners the mesh actually uses, terrain rarely reaches the top of its chunk
+    uint32_t min[3] = {CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE}, max[3] = {};
+    for (uint32_t i = 0; i < mesh->vertex_count; ++i)
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            auto const corner = (uint32_t)(mesh->vertices[i] >> axis * MESH_VERTEX_POSITION_BITS) &
+                                ((1u << MESH_VERTEX_POSITION_BITS) - 1);
+            if (corner < min[axis]) min[axis] = corner;
+            if (corner > max[axis]) max[axis] = corner;
+        }
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        info.bounds_min[axis] = info.origin[axis] + (float)min[axis];
+        info.bounds_max[axis] = info.origin[axis] + (float)max[axis];
+    }
+
+    if (quad_count) {
+        upload_buffer(app, app->chunk_vertex_buffer, range->offset * 4 * sizeof(MeshVertex), mesh->vertices,
+                      mesh->vertex_count * sizeof(MeshVertex));
+        upload_buffer(app, app->chunk_index_buffer, range->offset * 6 * sizeof(uint32_t), mesh->indices,
+                      mesh->index_count * sizeof(uint32_t));
+    }
+    set_draw_info(app, chunk_index * CHUNK_SECTION_COUNT + section, &info);
+}
+
+// registers a chunk for culling with the meshes of all of its sections, the next frame can draw it
+// load_world made room for every chunk of the world
+void add_loaded_chunk(App *const app, Chunk *const chunk, ChunkMesh const meshes[CHUNK_SECTION_COUNT]) {
+    auto const chunk_index = app->chunk_count++;
+    app->loaded_chunks[chunk_index] = (LoadedChunk){.chunk = chunk};
+    for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section)
+        replace_section_mesh(app, chunk_index, section, &meshes[section]);
+}
+
+// block coordinates, applied by the first frame that finds no remesh batch in flight
+void edit_block(App *const app, int32_t const x, int32_t const y, int32_t const z, BlockId const block) {
+    if (app->block_edit_count == app->block_edit_capacity) {
+        app->block_edit_capacity = app->block_edit_capacity ? app->block_edit_capacity * 2 : 64;
+        app->block_edits = realloc(app->block_edits, app->block_edit_capacity * sizeof(BlockEdit));
+    }
+    app->block_edits[app->block_edit_count++] = (BlockEdit){.x = x, .y = y, .z = z, .block = block};
+}
+
+// the light of an edit settles on the workers first, then the sections of the dirty chunks are remeshed there and
+// the uploads come back to the render thread one chunk at a time, the last one frees the batch
+typedef struct {
+    RemeshBatch *batch;
+    uint32_t chunk_index;
+    uint32_t sections;
+    ChunkConnectivity connectivity;
+    ChunkMesh meshes[CHUNK_SECTION_COUNT];
+} ChunkRemesh;
+
+struct RemeshBatch {
+    App *app;
+    LightBatch *light;
+    JobCounter lit;
+    JobCounter meshed;
+    uint32_t pending_upload_count;
+    ChunkRemesh *chunks;
+};
+
+// every job of the batch deferred its last callback before this runs, the wait only lets the last of them return
+void free_remesh_batch(App *const app) {
+    auto const batch = app->remesh_batch;
+    job_system_wait(app->jobs, &batch->meshed);
+    light_batch_destroy(batch->light);
+    free(batch->chunks);
+    free(batch);
+    app->remesh_batch = nullptr;
+}
+
+void release_remesh_batch(void *const data) {
+    RemeshBatch const *const batch = data;
+    free_remesh_batch(batch->app);
+}
+
+void upload_remeshed_chunk(void *const data) {
+    ChunkRemesh *const remesh = data;
+    auto const batch = remesh->batch;
+    auto const app = batch->app;
+    auto const chunk = app->loaded_chunks[remesh->chunk_index].chunk;
+    for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        if (!(remesh->sections >> section & 1)) continue;
+        replace_section_mesh(app, remesh->chunk_index, section, &remesh->meshes[section]);
+        chunk_mesh_free(&remesh->meshes[section]);
+    }
+    auto const cell = visibility_grid_cell(&app->visibility, chunk->x, chunk->y, chunk->z);
+    if (cell != UINT32_MAX) app->visibility.connectivity[cell] = remesh->connectivity;
+    if (!--batch->pending_upload_count) free_remesh_batch(app);
+}
+
+// the render thread leaves the chunks alone while a batch is in flight, so the jobs read them and their
+// neighbors freely
+void remesh_chunk_job(void *const data) {
+    ChunkRemesh *const remesh = data;
+    auto const app = remesh->batch->app;
+    auto const chunk = app->loaded_chunks[remesh->chunk_index].chunk;
+    Chunk const *neighbors[CHUNK_NEIGHBOR_COUNT];
+    world_get_neighbors(&app->world, chunk->x, chunk->y, chunk->z, neighbors);
+    auto const worker_index = job_system_worker_index(app->jobs);
+    mesh_chunk_sections(&app->mesher_scratches[worker_index], chunk, neighbors, remesh->sections, remesh->meshes);
+    remesh->connectivity = chunk_connectivity(&app->connectivity_scratches[worker_index], chunk);
+    job_system_defer_to_main(app->jobs, upload_remeshed_chunk, remesh);
+}
+
+// for when the chunks have to change right away, such as before a new world is loaded
+void finish_remesh_batch(App *const app) {
+    if (!app->remesh_batch) return;
+    job_system_wait(app->jobs, &app->remesh_batch->meshed);
+    job_system_run_main_callbacks(app->jobs);
+}
+
+// the sections of the loaded chunks that hold any block of the box from min to max, both included, are remeshed
+// the render thread does not touch the dirty sections while a batch is in flight, so its jobs may mark them too
+void mark_dirty_box(App *const app, int32_t const min[3], int32_t const max[3]) {
+    for (auto chunk_y = min[1] >> CHUNK_SIZE_LOG2; chunk_y <= max[1] >> CHUNK_SIZE_LOG2; ++chunk_y)
+        for (auto chunk_z = min[2] >> CHUNK_SIZE_LOG2; chunk_z <= max[2] >> CHUNK_SIZE_LOG2; ++chunk_z)
+            for (auto chunk_x = min[0] >> CHUNK_SIZE_LOG2; chunk_x <= max[0] >> CHUNK_SIZE_LOG2; ++chunk_x) {
+                auto const cell = visibility_grid_cell(&app->visibility, chunk_x, chunk_y, chunk_z);
+                if (cell == UINT32_MAX || app->cell_chunk_indices[cell] == UINT32_MAX) continue;
+                int32_t const bottom = chunk_y * (int32_t)CHUNK_SIZE, top = bottom + (int32_t)CHUNK_SIZE - 1;
+                auto const first = (uint32_t)((min[1] > bottom ? min[1] : bottom) - bottom) >> CHUNK_SECTION_SIZE_LOG2;
+                auto const last = (uint32_t)((max[1] < top ? max[1] : top) - bottom) >> CHUNK_SECTION_SIZE_LOG2;
+                app->loaded_chunks[app->cell_chunk_indices[cell]].dirty_sections |= (2u << last) - (1u << first);
+            }
+}
+
+// runs once the light settled, a face takes its corners from the voxels one step around the one in front of it, so
+// the sections within a block of the changed light are remeshed along with those of the edits
+void start_remesh_job(void *const data) {
+    RemeshBatch *const batch = data;
+    auto const app = batch->app;
+    LightChange const *changes;
+    auto const change_count = light_batch_get_changes(batch->light, &changes);
+    for (uint32_t i = 0; i < change_count; ++i) {
+        auto const change = &changes[i];
+        int32_t const origin[3] = {change->chunk->x * (int32_t)CHUNK_SIZE, change->chunk->y * (int32_t)CHUNK_SIZE,
+                                   change->chunk->z * (int32_t)CHUNK_SIZE};
+        int32_t min[3], max[3];
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            min[axis] = origin[axis] + change->min[axis] - 1;
+            max[axis] = origin[axis] + change->max[axis] + 1;
+        }
+        mark_dirty_box(app, min, max);
+    }
+
+    uint32_t dirty_count = 0;
+    for (uint32_t i = 0; i < app->chunk_count; ++i) dirty_count += app->loaded_chunks[i].dirty_sections != 0;
+    if (!dirty_count) {
+        job_system_defer_to_main(app->jobs, release_remesh_batch, batch);
+        return;
+    }
+    batch->chunks = calloc(dirty_count, sizeof(ChunkRemesh));
+    batch->pending_upload_count = dirty_count;
+    Job jobs[dirty_count];
+    for (uint32_t i = 0, j = 0; i < app->chunk_count; ++i) {
+        auto const loaded = &app->loaded_chunks[i];
+        if (!loaded->dirty_sections) continue;
+        batch->chunks[j] = (ChunkRemesh){.batch = batch, .chunk_index = i, .sections = loaded->dirty_sections};
+        jobs[j] = (Job){.function = remesh_chunk_job, .data = &batch->chunks[j]};
+        loaded->dirty_sections = 0;
+        ++j;
+    }
+    job_system_submit(app->jobs, jobs, dirty_count, &batch->meshed);
+}
+
+// applies the queued edits to the loaded chunks, updates their light and remeshes only the sections whose faces
+// can change, those within a block of an edit or of a voxel whose light changed, which may lie in the chunks next
+// to it
+void update_edited_chunks(App *const app) {
+    if (!app->is_world_ready || app->remesh_batch || !app->block_edit_count) return;
+    PROFILE_ZONE(&app->profiler, "edits");
+    auto const light = light_batch_create(&app->world, app->light_scratches);
+    uint32_t changed_count = 0;
+    for (uint32_t i = 0; i < app->block_edit_count; ++i) {
+        auto const edit = &app->block_edits[i];
+        auto const chunk = world_get_chunk(&app->world, edit->x >> CHUNK_SIZE_LOG2, edit->y >> CHUNK_SIZE_LOG2,
+                                           edit->z >> CHUNK_SIZE_LOG2);
+        if (!chunk) continue;
+        uint32_t const mask = CHUNK_SIZE - 1;
+        uint32_t const x = (uint32_t)edit->x & mask, y = (uint32_t)edit->y & mask, z = (uint32_t)edit->z & mask;
+        auto const old_block = chunk_get_block(chunk, x, y, z);
+        if (old_block == edit->block) continue;
+        chunk_set_block(chunk, x, y, z, edit->block);
+        light_batch_set_block(light, edit->x, edit->y, edit->z, old_block);
+        mark_dirty_box(app, (int32_t[]){edit->x - 1, edit->y - 1, edit->z - 1},
+                       (int32_t[]){edit->x + 1, edit->y + 1, edit->z + 1});
+        auto const cell = visibility_grid_cell(&app->visibility, chunk->x, chunk->y, chunk->z);
+        if (cell != UINT32_MAX && app->cell_chunk_indices[cell] != UINT32_MAX)
+            app->loaded_chunks[app->cell_chunk_indices[cell]].is_edited = true;
+        ++changed_count;
+    }
+    app->block_edit_count = 0;
+    // only the blocks are saved, the light is computed again when the chunk is loaded
+    for (uint32_t i = 0; app->world_regions && i < app->chunk_count; ++i) {
+        auto const loaded = &app->loaded_chunks[i];
+        if (!loaded->is_edited) continue;
+        save_chunk(app, loaded->chunk);
+        loaded->is_edited = false;
+    }
+    if (!changed_count) {
+        light_batch_destroy(light);
+        return;
+    }
+
+    RemeshBatch *const batch = calloc(1, sizeof(RemeshBatch));
+    batch->app = app;
+    batch->light = light;
+    app->remesh_batch = batch;
+    light_batch_submit(light, app->jobs, nullptr, &batch->lit);
+    job_system_submit_after(app->jobs, &batch->lit, &(Job){.function = start_remesh_job, .data = batch}, 1,
+                            &batch->meshed);
+}
+
+// copies the draw infos changed since the previous frame into chunk_info_buffer before culling reads it, on the
+// graphics queue so they switch over between two frames
+void record_draw_info_updates(App *const app, VkCommandBuffer const command_buffer) {
+    if (app->dirty_draw_info_begin == app->dirty_draw_info_end) return;
+    uint32_t const begin = app->dirty_draw_info_begin, count = app->dirty_draw_info_end - begin;
+    auto const infos = allocate_frame_memory(app, count * sizeof(ChunkDrawInfo));
+    memcpy(infos.data, &app->chunk_draw_infos[begin], count * sizeof(ChunkDrawInfo));
+    app->dirty_draw_info_begin = 0;
+    app->dirty_draw_info_end = 0;
+
+    // the earlier frames on the queue may still cull and draw with the old entries
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .memoryBarrierCount = 1,
+                                   .pMemoryBarriers = &(VkMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                                                       VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                   },
+                               });
+    app->vkCmdCopyBuffer(command_buffer, infos.buffer, app->chunk_info_buffer, 1, &(VkBufferCopy){
+                             .srcOffset = infos.offset,
+                             .dstOffset = begin * sizeof(ChunkDrawInfo),
+                             .size = count * sizeof(ChunkDrawInfo),
+                         });
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .memoryBarrierCount = 1,
+                                   .pMemoryBarriers = &(VkMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                       .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT |
+                                                       VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                                   },
+                               });
+}
+
+// the same for the block texture table, which only shader.vert reads
+void record_block_texture_updates(App *const app, VkCommandBuffer const command_buffer) {
+    if (app->dirty_block_texture_begin == app->dirty_block_texture_end) return;
+    uint32_t const begin = app->dirty_block_texture_begin, count = app->dirty_block_texture_end - begin;
+    auto const blocks = allocate_frame_memory(app, count * sizeof(BlockTextures));
+    memcpy(blocks.data, &app->block_textures[begin], count * sizeof(BlockTextures));
+    app->dirty_block_texture_begin = 0;
+    app->dirty_block_texture_end = 0;
+
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .memoryBarrierCount = 1,
+                                   .pMemoryBarriers = &(VkMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                   },
+                               });
+    app->vkCmdCopyBuffer(command_buffer, blocks.buffer, app->block_texture_buffer, 1, &(VkBufferCopy){
+                             .srcOffset = blocks.offset,
+                             .dstOffset = begin * sizeof(BlockTextures),
+                             .size = count * sizeof(BlockTextures),
+                         });
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .memoryBarrierCount = 1,
+                                   .pMemoryBarriers = &(VkMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                       .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                                   },
+                               });
+}
+
+// walks the visibility grid for the chunks the camera can see and resets the draw count of this frame,
+// then one invocation per section of a visible chunk appends a draw when its mesh bounds are in the frustum
+void record_chunk_culling(App *const app, VkCommandBuffer const command_buffer, Mat4 const *const view_projection,
+                          Vec3 const eye) {
+    PROFILE_ZONE(&app->profiler, "culling");
+    auto const cull_frame = allocate_frame_memory(app, sizeof(CullFrame) +
+                                                       app->chunk_count * CHUNK_SECTION_COUNT * sizeof(uint32_t));
+    CullFrame *const frame = cull_frame.data;
+    extract_frustum_planes(view_projection, frame->frustum_planes);
+    auto const visible_cell_count = visibility_grid_cull(&app->visibility, (float[]){eye.x, eye.y, eye.z},
+                                                         frame->frustum_planes, app->visible_cells);
+    frame->visible_count = 0;
+    for (uint32_t i = 0; i < visible_cell_count; ++i) {
+        auto const chunk_index = app->cell_chunk_indices[app->visible_cells[i]];
+        if (chunk_index == UINT32_MAX) continue;
+        // sections without faces never make it to the gpu
+        for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+            auto const draw_index = chunk_index * CHUNK_SECTION_COUNT + section;
+            if (app->chunk_draw_infos[draw_index].index_count)
+                frame->visible_chunks[frame->visible_count++] = draw_index;
+        }
+    }
+
+    auto const draw_count_offset = app->current_frame * sizeof(DrawCounts);
+    app->vkCmdFillBuffer(command_buffer, app->draw_count_buffer, draw_count_offset, sizeof(DrawCounts), 0);
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .memoryBarrierCount = 1,
+                                   .pMemoryBarriers = &(VkMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_CLEAR_BIT,
+                                       .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_SHADER_STORAGE_READ_BIT |
+                                                        VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                   },
+                               });
+
+    CullConstants const cull_constants = {
+        .cull_frame_device_address = cull_frame.device_address,
+        .chunk_info_buffer_device_address = app->chunk_info_buffer_device_address,
+        .draw_command_buffer_device_address = app->draw_command_buffer_device_address +
+                                              app->current_frame * app->chunk_draw_capacity *
+                                              sizeof(VkDrawIndexedIndirectCommand),
+        .draw_count_buffer_device_address = app->draw_count_buffer_device_address + draw_count_offset,
+    };
+    app->vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, app->cull_pipeline);
+    app->vkCmdPushConstants(command_buffer, app->cull_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                            sizeof(cull_constants), &cull_constants);
+    app->vkCmdDispatch(command_buffer, (frame->visible_count + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .memoryBarrierCount = 1,
+                                   .pMemoryBarriers = &(VkMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                                       .srcAccessMask = VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT |
+                                                       VK_PIPELINE_STAGE_2_COPY_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT |
+                                                        VK_ACCESS_2_TRANSFER_READ_BIT,
+                                   },
+                               });
+
+    // the counts come back with the frame fence, for statistics and the benchmark
+    auto const draw_counts = allocate_frame_memory(app, sizeof(DrawCounts));
+    app->vkCmdCopyBuffer(command_buffer, app->draw_count_buffer, draw_counts.buffer, 1, &(VkBufferCopy){
+                             .srcOffset = draw_count_offset,
+                             .dstOffset = draw_counts.offset,
+                             .size = sizeof(DrawCounts),
+                         });
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .memoryBarrierCount = 1,
+                                   .pMemoryBarriers = &(VkMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+                                       .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                                       .dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT,
+                                       .dstAccessMask = VK_ACCESS_2_HOST_READ_BIT,
+                                   },
+                               });
+    app->frame_draw_counts[app->current_frame] = draw_counts.data;
+}
+
+// only called once the fence of the frame slot signaled, like resolve_gpu_zones
+void resolve_draw_counts(App *const app, size_t const frame) {
+    auto const draw_counts = app->frame_draw_counts[frame];
+    if (!draw_counts) return;
+    app->frame_draw_counts[frame] = nullptr;
+    app->frame_totals.draw_count += draw_counts->draw_count;
+    app->frame_totals.triangle_count += draw_counts->index_count / 3;
+}
+
+// for when the device is idle, every submitted frame is done
+void resolve_in_flight_frames(App *const app) {
+    for (size_t i = 0; i < app->in_flight_frame_count; ++i) {
+        resolve_gpu_zones(app, i);
+        resolve_draw_counts(app, i);
+    }
+}
+
+// blocks until the gpu is done with the frame slot, the loop calls it before it samples input so the input is as
+// fresh as possible when the frame is recorded, render calls it again and then it returns right away
+void wait_for_frame(App *const app) {
+    PROFILE_ZONE(&app->profiler, "wait for frame");
+    app->vkWaitForFences(app->device, 1, &app->in_flight_fences[app->current_frame], true, UINT64_MAX);
+    // the slot was last used by the frame in_flight_frame_count frames ago
+    if (app->frame_count >= app->in_flight_frame_count)
+        app->completed_frame_count = app->frame_count - app->in_flight_frame_count + 1;
+    run_deferred_deletions(app);
+}
+
+void sleep_until(App const *const app, uint64_t const deadline_ns) {
+    auto const now = get_time_ns();
+    if (now + FRAME_LIMITER_SPIN_NS < deadline_ns) {
+#ifdef _WIN32
+        // relative, in 100 ns units
+        SetWaitableTimer(app->frame_timer, &(LARGE_INTEGER){
+                             .QuadPart = -(LONGLONG)((deadline_ns - FRAME_LIMITER_SPIN_NS - now) / 100),
+                         }, 0, nullptr, nullptr, false);
+        WaitForSingleObject(app->frame_timer, INFINITE);
+#else
+        (void)app;
+        auto const wake_ns = deadline_ns - FRAME_LIMITER_SPIN_NS;
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &(struct timespec){
+                            .tv_sec = (time_t)(wake_ns / 1000000000ull),
+                            .tv_nsec = (long)(wake_ns % 1000000000ull),
+                        }, nullptr);
+#endif
+    }
+    while (get_time_ns() < deadline_ns) {}
+}
+
+// holds the loop to the frame rate limit, before input is sampled so the wait does not add to the latency
+void pace_frame(App *const app) {
+    if (!app->frame_rate_limit) return;
+    PROFILE_ZONE(&app->profiler, "frame limiter");
+    auto const interval = 1000000000ull / app->frame_rate_limit;
+    auto const now = get_time_ns();
+    if (now < app->next_frame_ns) {
+        sleep_until(app, app->next_frame_ns);
+        app->next_frame_ns += interval;
+    } else {
+        // a late frame moves the schedule instead of rushing the following frames to catch up
+        app->next_frame_ns = now - app->next_frame_ns < interval ? app->next_frame_ns + interval : now + interval;
+    }
+}
+
+// the next frame is recorded from the input up to now
+void sample_input(App *const app) { app->input_sample_ns = profiler_time_ns(); }
+
+void render(App *const app) {
+    PROFILE_ZONE(&app->profiler, "render");
+    wait_for_frame(app);
+    resolve_gpu_zones(app, app->current_frame);
+    resolve_draw_counts(app, app->current_frame);
+
+    if (app->is_swapchain_dirty) {
+        app->is_swapchain_dirty = false;
+        setup_swapchain_dependent_resources(app);
+    }
+
+    if (app->surface_capabilities.currentExtent.width == 0 || app->surface_capabilities.currentExtent.height == 0)
+        return;
+
+    profiler_begin_zone(&app->profiler, "acquire");
+    uint32_t image_index;
+    if (app->headless) {
+        image_index = (uint32_t)(app->frame_count % app->swapchain_image_count);
+    } else {
+        auto const result = app->vkAcquireNextImageKHR(app->device, app->swapchain, UINT64_MAX,
+                                                       app->image_available_semaphores[app->current_frame], nullptr,
+                                                       &image_index);
+        // nothing was acquired and the fence is still signaled, the frame is skipped until the swapchain is rebuilt
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            app->is_swapchain_dirty = true;
+            profiler_end_zone(&app->profiler);
+            return;
+        }
+        // a suboptimal image still presents fine, the swapchain is rebuilt for the next frame
+        if (result == VK_SUBOPTIMAL_KHR) app->is_swapchain_dirty = true;
+    }
+    // before the reset, the image may have been last drawn by this very slot, whose fence would then never signal
+    auto const frame_fence = app->in_flight_fences[app->current_frame];
+    if (app->image_in_flight_fences[image_index] && app->image_in_flight_fences[image_index] != frame_fence)
+        app->vkWaitForFences(app->device, 1, &app->image_in_flight_fences[image_index], true, UINT64_MAX);
+    app->image_in_flight_fences[image_index] = frame_fence;
+    app->vkResetFences(app->device, 1, &frame_fence);
+    app->frame_memory_cursor = 0;
+    profiler_end_zone(&app->profiler);
+
+    // work finished by the jobs records its uploads here, so they go out with this frame
+    profiler_begin_zone(&app->profiler, "uploads");
+    job_system_run_main_callbacks(app->jobs);
+    update_edited_chunks(app);
+
+    // the frame waits on the transfer timeline only when new uploads went out since the previous frame
+    auto const upload_timeline_value = flush_uploads(app);
+    bool const waits_for_uploads = upload_timeline_value > app->frame_upload_timeline_value;
+    app->frame_upload_timeline_value = upload_timeline_value;
+    profiler_end_zone(&app->profiler);
+
+    profiler_begin_zone(&app->profiler, "record");
+    auto const command_buffer = app->command_buffers[app->current_frame];
+    app->vkResetCommandBuffer(command_buffer, 0);
+    app->vkBeginCommandBuffer(command_buffer, &(VkCommandBufferBeginInfo){
+                                  .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+                              });
+    if (app->timestamp_valid_bits)
+        app->vkCmdResetQueryPool(command_buffer, app->timestamp_pools[app->current_frame], 0, MAX_GPU_ZONES * 2);
+    app->gpu_zone_frames[app->current_frame] = app->profiler.frame;
+    app->frame_input_times[app->current_frame] = app->input_sample_ns;
+    app->input_sample_ns = 0;
+    auto const frame_zone = begin_gpu_zone(app, command_buffer, "frame");
+    if (app->upload_image_acquire_count) {
+        app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                       .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                       .imageMemoryBarrierCount = app->upload_image_acquire_count,
+                                       .pImageMemoryBarriers = app->upload_image_acquires,
+                                   });
+        app->upload_image_acquire_count = 0;
+    }
+    auto const mipmap_zone = begin_gpu_zone(app, command_buffer, "mipmaps");
+    generate_mipmaps(app, command_buffer);
+    end_gpu_zone(app, command_buffer, mipmap_zone);
+    record_draw_info_updates(app, command_buffer);
+    record_block_texture_updates(app, command_buffer);
+
+    // a fixed camera above one corner of the world center, looking at it
+    auto const extent = app->surface_capabilities.currentExtent;
+    auto const eye = (Vec3){app->camera_target.x - 28.0f, app->camera_target.y + 30.0f, app->camera_target.z - 36.0f};
+    auto const view = mat4_look_at(eye, app->camera_target, (Vec3){0.0f, 1.0f, 0.0f});
+    auto const projection = mat4_perspective(1.0f, (float)extent.width / (float)extent.height, 0.1f, 1000.0f);
+    auto const view_projection = mat4_multiply(&projection, &view);
+    if (app->chunk_count) {
+        auto const culling_zone = begin_gpu_zone(app, command_buffer, "culling");
+        record_chunk_culling(app, command_buffer, &view_projection, eye);
+        end_gpu_zone(app, command_buffer, culling_zone);
+    }
+
+    auto const main_pass_zone = begin_gpu_zone(app, command_buffer, "main pass");
+
+    // the color write waits for the acquire semaphore, whose wait stage is the color output, the depth clear waits for
+    // the depth tests of the previous frame since every frame shares the one depth image
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .imageMemoryBarrierCount = 2,
+                                   .pImageMemoryBarriers = (VkImageMemoryBarrier2[]){
+                                       {
+                                           .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                                           .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                           .dstStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                           .dstAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                                           .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                                           .newLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
+                                           .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                           .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                           .image = app->swapchain_images[image_index],
+                                           .subresourceRange = {
+                                               .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                               .levelCount = 1,
+                                               .layerCount = 1,
+                                           },
+                                       },
+                                       {
+                                           .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                                           .srcStageMask = VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                                           .srcAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                                           .dstStageMask = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT |
+                                                           VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                                           .dstAccessMask = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                                                            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                                           .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                                           .newLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
+                                           .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                           .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                           .image = app->depth_image,
+                                           .subresourceRange = {
+                                               .aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT,
+                                               .levelCount = 1,
+                                               .layerCount = 1,
+                                           },
+                                       },
+                                   },
+                               });
+    // no render pass or framebuffer, the views are attached per frame so a resize only recreates the images
+    app->vkCmdBeginRendering(command_buffer, &(VkRenderingInfo){
+                                 .sType = VK_STRUCTURE_TYPE_RENDERING_INFO,
+                                 .renderArea = {
+                                     .extent = app->surface_capabilities.currentExtent,
+                                 },
+                                 .layerCount = 1,
+                                 .colorAttachmentCount = 1,
+                                 .pColorAttachments = &(VkRenderingAttachmentInfo){
+                                     .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                                     .imageView = app->swapchain_image_views[image_index],
+                                     .imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
+                                     .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                     .storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+                                     .clearValue = {
+                                         .color = {
+                                             .float32 = {0.0f, 0.0f, 0.0f, 1.0f}
+                                         },
+                                     },
+                                 },
+                                 .pDepthAttachment = &(VkRenderingAttachmentInfo){
+                                     .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+                                     .imageView = app->depth_image_view,
+                                     .imageLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
+                                     .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+                                     .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+                                     .clearValue = {
+                                         .depthStencil = {
+                                             .depth = 1.0f,
+                                         },
+                                     },
+                                 },
+                             });
+    app->vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app->pipeline);
+    app->vkCmdSetViewport(command_buffer, 0, 1, &(VkViewport){
+                              .width = (float)app->surface_capabilities.currentExtent.width,
+                              .height = (float)app->surface_capabilities.currentExtent.height,
+                              .maxDepth = 1.0f,
+                          });
+    app->vkCmdSetScissor(command_buffer, 0, 1, &(VkRect2D){
+                             .extent = app->surface_capabilities.currentExtent,
+                         });
+    app->vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, app->pipeline_layout, 0, 1,
+                                 &app->descriptor_set, 0, nullptr);
+
+    // the vertex shader pulls packed vertices through the buffer address instead of a bound vertex buffer
+    PushConstants const push_constants = {
+        .view_projection = view_projection,
+        .chunk_info_buffer_device_address = app->chunk_info_buffer_device_address,
+        .vertex_buffer_device_address = app->chunk_vertex_buffer_device_address,
+        .block_texture_buffer_device_address = app->block_texture_buffer_device_address,
+    };
+    app->vkCmdPushConstants(command_buffer, app->pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                            sizeof(push_constants), &push_constants);
+    // one call draws every chunk that survived culling, chunks show up from the first frame after their upload
+    if (app->chunk_count) {
+        app->vkCmdBindIndexBuffer(command_buffer, app->chunk_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+        app->vkCmdDrawIndexedIndirectCount(command_buffer, app->draw_command_buffer,
+                                           app->current_frame * app->chunk_draw_capacity *
+                                           sizeof(VkDrawIndexedIndirectCommand), app->draw_count_buffer,
+                                           app->current_frame * sizeof(DrawCounts), app->chunk_draw_capacity,
+                                           sizeof(VkDrawIndexedIndirectCommand));
+    }
+    app->vkCmdEndRendering(command_buffer);
+    // presentation needs no access mask, the present semaphore makes the writes available
+    app->vkCmdPipelineBarrier2(command_buffer, &(VkDependencyInfo){
+                                   .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+                                   .imageMemoryBarrierCount = 1,
+                                   .pImageMemoryBarriers = &(VkImageMemoryBarrier2){
+                                       .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+                                       .srcStageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                       .srcAccessMask = VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                                       .dstStageMask = app->headless ? VK_PIPELINE_STAGE_2_COPY_BIT
+                                                                     : VK_PIPELINE_STAGE_2_NONE,
+                                       .dstAccessMask = app->headless ? VK_ACCESS_2_TRANSFER_READ_BIT
+                                                                      : VK_ACCESS_2_NONE,
+                                       .oldLayout = VK_IMAGE_LAYOUT_ATTACHMENT_OPTIMAL,
+                                       .newLayout = app->headless
+                                                        ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+                                                        : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
+                                       .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                       .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+                                       .image = app->swapchain_images[image_index],
+                                       .subresourceRange = {
+                                           .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                           .levelCount = 1,
+                                           .layerCount = 1,
+                                       },
+                                   },
+                               });
+    end_gpu_zone(app, command_buffer, main_pass_zone);
+    end_gpu_zone(app, command_buffer, frame_zone);
+    app->vkEndCommandBuffer(command_buffer);
+    profiler_end_zone(&app->profiler);
+
+    uint32_t wait_count = 0;
+    VkSemaphoreSubmitInfo waits[2];
+    if (!app->headless)
+        waits[wait_count++] = (VkSemaphoreSubmitInfo){
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = app->image_available_semaphores[app->current_frame],
+            .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+        };
+    if (waits_for_uploads)
+        waits[wait_count++] = (VkSemaphoreSubmitInfo){
+            .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+            .semaphore = app->upload_semaphore,
+            .value = upload_timeline_value,
+            .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+        };
+
+    profiler_begin_zone(&app->profiler, "submit");
+    app->gpu_submit_times[app->current_frame] = profiler_time_ns();
+    app->vkQueueSubmit2(app->queue, 1, &(VkSubmitInfo2){
+                            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+                            .waitSemaphoreInfoCount = wait_count,
+                            .pWaitSemaphoreInfos = waits,
+                            .commandBufferInfoCount = 1,
+                            .pCommandBufferInfos = &(VkCommandBufferSubmitInfo){
+                                .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+                                .commandBuffer = command_buffer,
+                            },
+                            .signalSemaphoreInfoCount = app->headless ? 0 : 1,
+                            .pSignalSemaphoreInfos = &(VkSemaphoreSubmitInfo){
+                                .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+                                .semaphore = app->render_finished_semaphores[image_index],
+                                .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                            },
+                        },
+                        app->in_flight_fences[app->current_frame]);
+    profiler_end_zone(&app->profiler);
+    if (!app->headless) {
+        profiler_begin_zone(&app->profiler, "present");
+        auto const result = app->vkQueuePresentKHR(app->queue, &(VkPresentInfoKHR){
+                                                       .sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR,
+                                                       .waitSemaphoreCount = 1,
+                                                       .pWaitSemaphores = &app->render_finished_semaphores[image_index],
+                                                       .swapchainCount = 1,
+                                                       .pSwapchains = &app->swapchain,
+                                                       .pImageIndices = &image_index,
+                                                   });
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) app->is_swapchain_dirty = true;
+        profiler_end_zone(&app->profiler);
+    }
+    app->current_frame = (app->current_frame + 1) % app->in_flight_frame_count;
+    ++app->frame_count;
+    profiler_end_frame(&app->profiler);
+    if (!app->is_startup_reported) report_startup(app);
+}
+
+#ifdef _WIN32
+LRESULT handle_message(App *const app, HWND const window, unsigned int const message, WPARAM const wparam,
+                       LPARAM const lparam) {
+    switch (message) {
+        case WM_DESTROY:
+            PostQuitMessage(0);
+            return 0;
+        case WM_SIZE:
+            app->is_swapchain_dirty = true;
+            return 0;
+        case WM_ENTERSIZEMOVE:
+            app->is_sizing = true;
+            return 0;
+        case WM_EXITSIZEMOVE:
+            app->is_sizing = false;
+            return 0;
+        case WM_PAINT:
+            // the loop renders continuously, an invalid window would only keep sending WM_PAINT
+            // the window class redraws on every size change, so a drag still renders each new size
+            if (app->is_sizing) render(app);
+            ValidateRect(window, nullptr);
+            return 0;
+        default:
+            return DefWindowProcW(window, message, wparam, lparam);
+    }
+}
+
+LRESULT CALLBACK window_procedure(HWND const window, unsigned int const message, WPARAM const wparam,
+                                  LPARAM const lparam) {
+    auto const app = (App*)GetWindowLongPtrW(window, GWLP_USERDATA);
+    if (app) return handle_message(app, window, message, wparam, lparam);
+    if (message == WM_CREATE)
+        SetWindowLongPtrW(window, GWLP_USERDATA,
+                          (LONG_PTR)((CREATESTRUCTW*)lparam)->lpCreateParams);
+    return DefWindowProcW(window, message, wparam, lparam);
+}
+
+// older systems have no high resolution timers, their timers wake up on the next scheduler tick
+void create_frame_timer(App *const app) {
+    app->frame_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                              TIMER_ALL_ACCESS);
+    if (!app->frame_timer) app->frame_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+}
+
+void create_window(App *const app) {
+    RegisterClassExW(&(WNDCLASSEXW){
+        .cbSize = sizeof(WNDCLASSEXW),
+        .style = CS_HREDRAW | CS_VREDRAW,
+        .lpfnWndProc = window_procedure,
+        .hInstance = app->hinstance,
+        .hCursor = LoadCursorA(nullptr, IDC_ARROW),
+        .lpszClassName = app->window_title,
+    });
+    app->window = CreateWindowExW(0, app->window_title, app->window_title, WS_OVERLAPPEDWINDOW, CW_USEDEFAULT,
+                                  CW_USEDEFAULT, CW_USEDEFAULT, CW_USEDEFAULT,
+                                  nullptr, nullptr, app->hinstance, app);
+}
+
+// renders every iteration instead of on WM_PAINT, the present mode and the frame limiter set the pace
+WPARAM main_loop(App *const app) {
+    for (;;) {
+        wait_for_frame(app);
+        pace_frame(app);
+        MSG message;
+        while (PeekMessageW(&message, nullptr, 0, 0, PM_REMOVE)) {
+            if (message.message == WM_QUIT) return message.wParam;
+            TranslateMessage(&message);
+            DispatchMessageW(&message);
+        }
+        // nothing to render into while minimized
+        if (IsIconic(app->window)) {
+            WaitMessage();
+            continue;
+        }
+        sample_input(app);
+        render(app);
+    }
+}
+#endif
+
+#ifdef _WIN32
+bool load_file(NativeChar const *filename, void **data, size_t *size) {
+    HANDLE const file = CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL,
+                                    nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        *data = nullptr;
+        *size = 0;
+        return false;
+    }
+    *size = GetFileSize(file, nullptr);
+    *data = HeapAlloc(GetProcessHeap(), 0, *size);
+    DWORD read;
+    ReadFile(file, *data, *size, &read, nullptr);
+    CloseHandle(file);
+    return true;
+}
+
+void free_file(void *data) { HeapFree(GetProcessHeap(), 0, data); }
+
+bool save_file(NativeChar const *filename, void const *data, size_t const size) {
+    HANDLE const file = CreateFileW(filename, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL,
+                                    nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    DWORD written;
+    bool const result = WriteFile(file, data, (DWORD)size, &written, nullptr) && written == size;
+    CloseHandle(file);
+    return result;
+}
+#else
+bool load_file(NativeChar const *filename, void **data, size_t *size) {
+    FILE *const file = fopen(filename, "rb");
+    if (!file) {
+        *data = nullptr;
+        *size = 0;
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    *data = malloc(*size);
+    *size = fread(*data, 1, *size, file);
+    fclose(file);
+    return true;
+}
+
+void free_file(void *data) { free(data); }
+
+bool save_file(NativeChar const *filename, void const *data, size_t const size) {
+    FILE *const file = fopen(filename, "wb");
+    if (!file) return false;
+    bool const result = fwrite(data, 1, size, file) == size;
+    return fclose(file) == 0 && result;
+}
+#endif
+
+#define PIPELINE_CACHE_PATH RESOURCES_PATH NATIVE_TEXT("pipeline_cache.bin")
+
+// a cache written by another driver or device is dropped instead of being handed to the driver
+bool is_pipeline_cache_valid(App const *const app, void const *data, size_t const size) {
+    VkPipelineCacheHeaderVersionOne header;
+    if (size < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    return header.headerSize >= sizeof(header) && header.headerSize <= size &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == app->physical_device_properties.vendorID &&
+           header.deviceID == app->physical_device_properties.deviceID &&
+           !memcmp(header.pipelineCacheUUID, app->physical_device_properties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+void create_pipeline_cache(App *const app) {
+    void *data = nullptr;
+    size_t size = 0;
+    if (!app->cold_pipeline_cache && load_file(PIPELINE_CACHE_PATH, &data, &size) &&
+        !is_pipeline_cache_valid(app, data, size)) {
+        free_file(data);
+        data = nullptr;
+        size = 0;
+    }
+    app->is_pipeline_cache_warm = size != 0;
+
+    app->vkCreatePipelineCache(app->device, &(VkPipelineCacheCreateInfo){
+                                   .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+                                   .initialDataSize = size,
+                                   .pInitialData = data,
+                               },
+                               nullptr, &app->pipeline_cache);
+    if (data) free_file(data);
+}
+
+void save_pipeline_cache(App const *const app) {
+    size_t size;
+    app->vkGetPipelineCacheData(app->device, app->pipeline_cache, &size, nullptr);
+    void *const data = malloc(size);
+    app->vkGetPipelineCacheData(app->device, app->pipeline_cache, &size, data);
+    if (!save_file(PIPELINE_CACHE_PATH, data, size))
+        fprintf(stderr, "Cannot write pipeline cache\n");
+    free(data);
+}
+
+#define ASSET_PACK_PATH RESOURCES_PATH NATIVE_TEXT("assets.pack")
+
+// startup assets are read in place from the pack written by codoxel_asset_packer, the loose files under resources
+// are the fallback while developing
+void open_asset_pack(App *const app) {
+    if (!pack_open(&app->asset_pack, ASSET_PACK_PATH)) printf("no asset pack, loading loose files\n");
+}
+
+// only reads, so it runs on a worker while the device is created
+void read_shaders(App *const app) {
+    auto const entry = pack_find(&app->asset_pack, PACK_ENTRY_SHADER, "shader");
+    if (entry) {
+        app->shader_code = pack_entry_data(&app->asset_pack, entry);
+        app->shader_code_size = entry->size;
+        return;
+    }
+    if (!load_file(RESOURCES_PATH NATIVE_TEXT("shaders/shader.spv"), &app->shader_module_bytes,
+                   &app->shader_code_size))
+        fatal_error(app, L"Cannot find shader!");
+    app->shader_code = app->shader_module_bytes;
+}
+
+// the driver reads the spir-v straight out of the mapped pack
+void create_shader_module(App *const app) {
+    app->vkCreateShaderModule(app->device, &(VkShaderModuleCreateInfo){
+                                  .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+                                  .codeSize = app->shader_code_size,
+                                  .pCode = (uint32_t const*)app->shader_code,
+                              },
+                              nullptr, &app->shader_module);
+}
+
+void unload_shaders(App *const app) {
+    app->vkDestroyShaderModule(app->device, app->shader_module, nullptr);
+    if (app->shader_module_bytes) free_file(app->shader_module_bytes);
+    app->shader_module_bytes = nullptr;
+    app->shader_code = nullptr;
+}
+
+void create_pipeline_layout(App *const app) {
+    app->vkCreatePipelineLayout(app->device, &(VkPipelineLayoutCreateInfo){
+                                    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                                    .setLayoutCount = 1,
+                                    .pSetLayouts = &app->descriptor_set_layout,
+                                    .pushConstantRangeCount = 1,
+                                    .pPushConstantRanges = &(VkPushConstantRange){
+                                        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+                                        .size = sizeof(PushConstants),
+                                    },
+                                },
+                                nullptr, &app->pipeline_layout);
+    app->vkCreatePipelineLayout(app->device, &(VkPipelineLayoutCreateInfo){
+                                    .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+                                    .pushConstantRangeCount = 1,
+                                    .pPushConstantRanges = &(VkPushConstantRange){
+                                        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+                                        .size = sizeof(CullConstants),
+                                    },
+                                },
+                                nullptr, &app->cull_pipeline_layout);
+}
+
+void create_pipeline(App *const app) {
+    app->vkCreateGraphicsPipelines(app->device, app->pipeline_cache, 1, &(VkGraphicsPipelineCreateInfo){
+                                       .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+                                       // dynamic rendering, the attachment formats take the place of a render pass
+                                       .pNext = &(VkPipelineRenderingCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+                                           .colorAttachmentCount = 1,
+                                           .pColorAttachmentFormats = &(VkFormat){VK_FORMAT_B8G8R8A8_SRGB},
+                                           .depthAttachmentFormat = app->depth_format,
+                                       },
+                                       .stageCount = 2,
+                                       .pStages = (VkPipelineShaderStageCreateInfo[]){
+                                           {
+                                               .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                               .stage = VK_SHADER_STAGE_VERTEX_BIT,
+                                               .module = app->shader_module,
+                                               .pName = "main",
+                                           },
+                                           {
+                                               .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                               .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+                                               .module = app->shader_module,
+                                               .pName = "main",
+                                           },
+                                       },
+                                       // no vertex attributes, shader.vert reads the vertices itself
+                                       .pVertexInputState = &(VkPipelineVertexInputStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+                                       },
+                                       .pInputAssemblyState = &(VkPipelineInputAssemblyStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+                                           .topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+                                       },
+                                       .pRasterizationState = &(VkPipelineRasterizationStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+                                           .lineWidth = 1.0f,
+                                           // the mesher winds faces counter clockwise seen from outside, the
+                                           // projection flips y without flipping that
+                                           .cullMode = VK_CULL_MODE_BACK_BIT,
+                                           .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+                                       },
+                                       .pDepthStencilState = &(VkPipelineDepthStencilStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+                                           .depthTestEnable = true,
+                                           .depthWriteEnable = true,
+                                           .depthCompareOp = VK_COMPARE_OP_LESS,
+                                       },
+                                       .pMultisampleState = &(VkPipelineMultisampleStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+                                           .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+                                       },
+                                       .pColorBlendState = &(VkPipelineColorBlendStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+                                           .attachmentCount = 1,
+                                           .pAttachments = &(VkPipelineColorBlendAttachmentState){
+                                               .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                               VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+                                           },
+                                       },
+                                       .layout = app->pipeline_layout,
+                                       .pDynamicState = &(VkPipelineDynamicStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+                                           .dynamicStateCount = 2,
+                                           .pDynamicStates = (VkDynamicState[]){
+                                               VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR
+                                           },
+                                       },
+                                       .pViewportState = &(VkPipelineViewportStateCreateInfo){
+                                           .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+                                           .viewportCount = 1,
+                                           .scissorCount = 1,
+                                           .pViewports = &(VkViewport){},
+                                           .pScissors = &(VkRect2D){},
+                                       }
+                                   },
+                                   nullptr, &app->pipeline);
+}
+
+// cull.comp is linked into the same module as the graphics stages
+void create_cull_pipeline(App *const app) {
+    app->vkCreateComputePipelines(app->device, app->pipeline_cache, 1, &(VkComputePipelineCreateInfo){
+                                      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+                                      .stage = {
+                                          .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+                                          .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+                                          .module = app->shader_module,
+                                          .pName = "main",
+                                      },
+                                      .layout = app->cull_pipeline_layout,
+                                  },
+                                  nullptr, &app->cull_pipeline);
 }
 
 void create_command_pool(App *app) {
-    auto const vkCreateCommandPool = (PFN_vkCreateCommandPool)app->vkGetDeviceProcAddr(
-        app->device, "vkCreateCommandPool");
-    vkCreateCommandPool(app->device, &(VkCommandPoolCreateInfo){
-                            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-                            .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
-                        },
-                        nullptr, &app->command_pool);
+    app->vkCreateCommandPool(app->device, &(VkCommandPoolCreateInfo){
+                                 .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                 .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                                 .queueFamilyIndex = app->graphics_queue_family,
+                             },
+                             nullptr, &app->command_pool);
 }
 
 void allocate_command_buffers(App *app) {
-    auto const vkAllocateCommandBuffers = (PFN_vkAllocateCommandBuffers)app->vkGetDeviceProcAddr(
-        app->device, "vkAllocateCommandBuffers");
-    vkAllocateCommandBuffers(app->device, &(VkCommandBufferAllocateInfo){
-                                 .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                 .commandPool = app->command_pool,
-                                 .commandBufferCount = IN_FLIGHT_FRAMES,
-                             },
-                             app->command_buffers);
+    app->vkAllocateCommandBuffers(app->device, &(VkCommandBufferAllocateInfo){
+                                      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                      .commandPool = app->command_pool,
+                                      .commandBufferCount = app->in_flight_frame_count,
+                                  },
+                                  app->command_buffers);
 }
 
+// the render finished semaphores belong to the swapchain images and are created with them
 void create_synchronization_objects(App *app) {
-    auto const vkCreateSemaphore = (PFN_vkCreateSemaphore)app->vkGetDeviceProcAddr(app->device, "vkCreateSemaphore");
-    auto const vkCreateFence = (PFN_vkCreateFence)app->vkGetDeviceProcAddr(app->device, "vkCreateFence");
-
-    for (uint32_t i = 0; i < IN_FLIGHT_FRAMES; ++i) {
-        vkCreateSemaphore(app->device, &(VkSemaphoreCreateInfo){.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO},
-                          nullptr,
-                          &app->image_available_semaphores[i]);
-        vkCreateSemaphore(app->device, &(VkSemaphoreCreateInfo){.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO},
-                          nullptr,
-                          &app->render_finished_semaphores[i]);
-        vkCreateFence(app->device, &(VkFenceCreateInfo){
-                          .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                          .flags = VK_FENCE_CREATE_SIGNALED_BIT
-                      }, nullptr,
-                      &app->in_flight_fences[i]);
-    }
-}
-
-PFN_vkVoidFunction load_device_proc(App const *const app, char const *const name) {
-    return app->vkGetDeviceProcAddr(app->device, name);
-}
-
-void load_vulkan_functions(App *app) {
-    app->vkAcquireNextImageKHR = (PFN_vkAcquireNextImageKHR)load_device_proc(app, "vkAcquireNextImageKHR");
-    app->vkQueuePresentKHR = (PFN_vkQueuePresentKHR)load_device_proc(app, "vkQueuePresentKHR");
-    app->vkWaitForFences = (PFN_vkWaitForFences)load_device_proc(app, "vkWaitForFences");
-    app->vkResetFences = (PFN_vkResetFences)load_device_proc(app, "vkResetFences");
-    app->vkResetCommandBuffer = (PFN_vkResetCommandBuffer)load_device_proc(app, "vkResetCommandBuffer");
-    app->vkBeginCommandBuffer = (PFN_vkBeginCommandBuffer)load_device_proc(app, "vkBeginCommandBuffer");
-    app->vkEndCommandBuffer = (PFN_vkEndCommandBuffer)load_device_proc(app, "vkEndCommandBuffer");
-    app->vkCmdBeginRenderPass = (PFN_vkCmdBeginRenderPass)load_device_proc(app, "vkCmdBeginRenderPass");
-    app->vkCmdEndRenderPass = (PFN_vkCmdEndRenderPass)load_device_proc(app, "vkCmdEndRenderPass");
-    app->vkCmdBindPipeline = (PFN_vkCmdBindPipeline)load_device_proc(app, "vkCmdBindPipeline");
-    app->vkCmdSetViewport = (PFN_vkCmdSetViewport)load_device_proc(app, "vkCmdSetViewport");
-    app->vkCmdSetScissor = (PFN_vkCmdSetScissor)load_device_proc(app, "vkCmdSetScissor");
-    app->vkCmdDrawIndexed = (PFN_vkCmdDrawIndexed)load_device_proc(app, "vkCmdDrawIndexed");
-    app->vkQueueSubmit = (PFN_vkQueueSubmit)load_device_proc(app, "vkQueueSubmit");
-    app->vkCmdBindVertexBuffers = (PFN_vkCmdBindVertexBuffers)load_device_proc(app, "vkCmdBindVertexBuffers");
-    app->vkCmdBindIndexBuffer = (PFN_vkCmdBindIndexBuffer)load_device_proc(app, "vkCmdBindIndexBuffer");
-    app->vkCmdBindDescriptorSets = (PFN_vkCmdBindDescriptorSets)load_device_proc(app, "vkCmdBindDescriptorSets");
+    for (uint32_t i = 0; i < app->in_flight_frame_count; ++i) {
+        app->vkCreateSemaphore(app->device, &(VkSemaphoreCreateInfo){.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO},
+                               nullptr,
+                               &app->image_available_semaphores[i]);
+        app->vkCreateFence(app->device, &(VkFenceCreateInfo){
+                               .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+                               .flags = VK_FENCE_CREATE_SIGNALED_BIT
+                           }, nullptr,
+                           &app->in_flight_fences[i]);
+    }
 }
 
-uint32_t find_memory_type(const VkPhysicalDeviceMemoryProperties *pMemoryProperties,
-                          uint32_t const memoryTypeBitsRequirement,
-                          VkMemoryPropertyFlags const requiredProperties) {
-    const uint32_t memoryCount = pMemoryProperties->memoryTypeCount;
-    for (uint32_t memoryIndex = 0; memoryIndex < memoryCount; ++memoryIndex) {
-        const uint32_t memoryTypeBits = (1 << memoryIndex);
-        const bool isRequiredMemoryType = memoryTypeBitsRequirement & memoryTypeBits;
+void create_timestamp_pools(App *const app) {
+    if (!app->timestamp_valid_bits) return;
+    for (uint32_t i = 0; i < app->in_flight_frame_count; ++i)
+        app->vkCreateQueryPool(app->device, &(VkQueryPoolCreateInfo){
+                                   .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+                                   .queryType = VK_QUERY_TYPE_TIMESTAMP,
+                                   .queryCount = MAX_GPU_ZONES * 2,
+                               },
+                               nullptr, &app->timestamp_pools[i]);
+}
 
-        const VkMemoryPropertyFlags properties =
-            pMemoryProperties->memoryTypes[memoryIndex].propertyFlags;
-        const bool hasRequiredProperties =
-            (properties & requiredProperties) == requiredProperties;
+// stands in for the swapchain when there is no window, frames are rendered into plain device local images
+void configure_offscreen_images(App *const app) {
+    app->surface_capabilities.currentExtent = app->headless_extent;
+    app->swapchain_image_count = app->in_flight_frame_count;
+    for (uint32_t i = 0; i < app->swapchain_image_count; ++i) {
+        app->vkCreateImage(app->device, &(VkImageCreateInfo){
+                               .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                               .imageType = VK_IMAGE_TYPE_2D,
+                               .format = VK_FORMAT_B8G8R8A8_SRGB,
+                               .extent = {
+                                   .width = app->headless_extent.width,
+                                   .height = app->headless_extent.height,
+                                   .depth = 1,
+                               },
+                               .mipLevels = 1,
+                               .arrayLayers = 1,
+                               .samples = VK_SAMPLE_COUNT_1_BIT,
+                               .tiling = VK_IMAGE_TILING_OPTIMAL,
+                               .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                               .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                           },
+                           nullptr, &app->swapchain_images[i]);
+        app->offscreen_image_allocations[i] = bind_image_memory(app, app->swapchain_images[i],
+                                                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-        if (isRequiredMemoryType && hasRequiredProperties)
-            return memoryIndex;
+        app->vkCreateImageView(app->device, &(VkImageViewCreateInfo){
+                                   .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                                   .image = app->swapchain_images[i],
+                                   .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                                   .format = VK_FORMAT_B8G8R8A8_SRGB,
+                                   .subresourceRange = {
+                                       .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                       .levelCount = 1,
+                                       .layerCount = 1,
+                                   },
+                               },
+                               nullptr, &app->swapchain_image_views[i]);
     }
-    return UINT32_MAX;
+    configure_depth_image(app);
 }
 
-VkBuffer create_buffer(App const *const app, VkDeviceSize const size,
-                       VkDeviceMemory *memory, VkBufferUsageFlags const usage,
-                       VkMemoryPropertyFlags const required_properties) {
-    auto const vkCreateBuffer = (PFN_vkCreateBuffer)app->vkGetDeviceProcAddr(app->device, "vkCreateBuffer");
-    auto const vkGetBufferMemoryRequirements = (PFN_vkGetBufferMemoryRequirements)app->vkGetDeviceProcAddr(
-        app->device, "vkGetBufferMemoryRequirements");
-    auto const vkAllocateMemory = (PFN_vkAllocateMemory)app->vkGetDeviceProcAddr(app->device, "vkAllocateMemory");
-    auto const vkBindBufferMemory = (PFN_vkBindBufferMemory)app->vkGetDeviceProcAddr(app->device, "vkBindBufferMemory");
+// the draw infos of every section can change in one frame, when a world is loaded or an edit burst remeshes it
+void create_frame_memory(App *const app) {
+    app->frame_memory_size = FRAME_MEMORY_SIZE + app->chunk_draw_capacity * (sizeof(ChunkDrawInfo) + sizeof(uint32_t));
+    app->frame_memory_buffer = create_buffer(app, app->frame_memory_size * app->in_flight_frame_count,
+                                             &app->frame_memory,
+                                             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                             VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                             VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    app->frame_memory_data = memory_allocation_data(app, &app->frame_memory);
+    app->frame_memory_device_address = get_buffer_device_address(app, app->frame_memory_buffer);
+}
 
-    VkBuffer buffer;
-    vkCreateBuffer(app->device, &(VkBufferCreateInfo){
-                       .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
-                       .size = size,
-                       .usage = usage,
-                   },
-                   nullptr, &buffer);
+void create_upload_ring(App *const app) {
+    app->upload_buffer = create_buffer(app, UPLOAD_RING_SIZE, &app->upload_memory, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                                       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    app->upload_data = memory_allocation_data(app, &app->upload_memory);
 
-    VkMemoryRequirements memory_requirements;
-    vkGetBufferMemoryRequirements(app->device, buffer, &memory_requirements);
+    app->vkCreateCommandPool(app->device, &(VkCommandPoolCreateInfo){
+                                 .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+                                 .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+                                 .queueFamilyIndex = app->transfer_queue_family,
+                             },
+                             nullptr, &app->upload_command_pool);
+    VkCommandBuffer command_buffers[MAX_UPLOAD_BATCHES];
+    app->vkAllocateCommandBuffers(app->device, &(VkCommandBufferAllocateInfo){
+                                      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+                                      .commandPool = app->upload_command_pool,
+                                      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+                                      .commandBufferCount = MAX_UPLOAD_BATCHES,
+                                  },
+                                  command_buffers);
+    for (uint32_t i = 0; i < MAX_UPLOAD_BATCHES; ++i)
+        app->upload_batches[i].command_buffer = command_buffers[i];
 
-    auto const vkGetPhysicalDeviceMemoryProperties = (PFN_vkGetPhysicalDeviceMemoryProperties)app->
-        vkGetInstanceProcAddr(app->instance, "vkGetPhysicalDeviceMemoryProperties");
+    app->vkCreateSemaphore(app->device, &(VkSemaphoreCreateInfo){
+                               .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+                               .pNext = &(VkSemaphoreTypeCreateInfo){
+                                   .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+                                   .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+                               },
+                           },
+                           nullptr, &app->upload_semaphore);
+}
 
-    VkPhysicalDeviceMemoryProperties memory_properties;
-    vkGetPhysicalDeviceMemoryProperties(app->physical_device, &memory_properties);
-    uint32_t const memory_type_index = find_memory_type(&memory_properties, memory_requirements.memoryTypeBits,
-                                                        required_properties);
+// png files are decoded by the built in decoder on every platform
+// a generated checkerboard stands in when the file is missing or unreadable
+typedef struct {
+    void *file_data;
+    size_t file_size;
+    uint32_t width, height;
+} ImageDecoder;
 
-    vkAllocateMemory(app->device, &(VkMemoryAllocateInfo){
-                         .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-                         .allocationSize = memory_requirements.size,
-                         .memoryTypeIndex = memory_type_index,
-                     },
-                     nullptr, memory);
+bool load_image(NativeChar const *filename, ImageDecoder *decoder) {
+    PngInfo info;
+    if (load_file(filename, &decoder->file_data, &decoder->file_size) &&
+        png_read_info(decoder->file_data, decoder->file_size, &info) && !info.interlace_method) {
+        decoder->width = info.width;
+        decoder->height = info.height;
+        return true;
+    }
+    if (decoder->file_data) free_file(decoder->file_data);
+    *decoder = (ImageDecoder){.width = 256, .height = 256};
+    return false;
+}
 
-    vkBindBufferMemory(app->device, buffer, *memory, 0);
-    return buffer;
+void unload_image(ImageDecoder const *decoder) {
+    if (decoder->file_data) free_file(decoder->file_data);
 }
 
-typedef struct {
-    IWICBitmapDecoder *bitmap_decoder;
-    IWICBitmapFrameDecode *bitmap_frame;
-    IWICFormatConverter *format_converter;
-    UINT width, height;
-} ImageDecoder;
+void decode_image(ImageDecoder const *decoder, void *data) {
+    if (decoder->file_data && png_decode_bgra(decoder->file_data, decoder->file_size, data)) return;
 
-HRESULT load_image(App const *app, wchar_t const *filename, ImageDecoder *decoder) {
-    HRESULT hr = app->imaging_factory->lpVtbl->CreateDecoderFromFilename(app->imaging_factory, filename,
-                                                                         nullptr, GENERIC_READ,
-                                                                         WICDecodeMetadataCacheOnLoad,
-                                                                         &decoder->bitmap_decoder);
-    if (FAILED(hr)) return hr;
+    auto const pixels = (uint32_t*)data;
+    for (uint32_t y = 0; y < decoder->height; ++y)
+        for (uint32_t x = 0; x < decoder->width; ++x)
+            pixels[y * decoder->width + x] = (x / 32 + y / 32) % 2 ? 0xFFFFFFFF : 0xFF202020;
+}
 
-    // load first frame
-    hr = decoder->bitmap_decoder->lpVtbl->GetFrame(decoder->bitmap_decoder, 0, &decoder->bitmap_frame);
-    if (FAILED(hr)) return hr;
+uint32_t get_mip_level_count(uint32_t const width, uint32_t const height) {
+    return 32 - (uint32_t)__builtin_clz(width > height ? width : height);
+}
 
-    // convert to format32bppPBGRA
-    hr = app->imaging_factory->lpVtbl->CreateFormatConverter(app->imaging_factory, &decoder->format_converter);
-    if (FAILED(hr)) return hr;
+bool has_format_features(App const *const app, VkFormat const format, VkFormatFeatureFlags const features) {
+    VkFormatProperties properties;
+    app->vkGetPhysicalDeviceFormatProperties(app->physical_device, format, &properties);
+    return (properties.optimalTilingFeatures & features) == features;
+}
 
-    // initialize format converter
-    hr = decoder->format_converter->lpVtbl->Initialize(decoder->format_converter,
-                                                       (IWICBitmapSource*)decoder->bitmap_frame, &
-                                                       GUID_WICPixelFormat32bppPBGRA,
-                                                       WICBitmapDitherTypeNone, nullptr, 0.0,
-                                                       WICBitmapPaletteTypeCustom);
-    if (FAILED(hr)) return hr;
+// block compressed formats can never be blit destinations, so they only get the mips stored in the file
+bool can_generate_mipmaps(App const *const app, VkFormat const format) {
+    return has_format_features(app, format, VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                            VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+}
 
-    return decoder->bitmap_frame->lpVtbl->GetSize(decoder->bitmap_frame, &decoder->width, &decoder->height);
+// d32 is the common case, the spec guarantees one of the other two
+VkFormat pick_depth_format(App const *const app) {
+    VkFormat const candidates[] = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_X8_D24_UNORM_PACK32, VK_FORMAT_D16_UNORM};
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i)
+        if (has_format_features(app, candidates[i], VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT))
+            return candidates[i];
+    return VK_FORMAT_D16_UNORM;
 }
 
-void unload_image(ImageDecoder const *decoder) {
-    if (decoder->bitmap_decoder) decoder->bitmap_decoder->lpVtbl->Release(decoder->bitmap_decoder);
-    if (decoder->bitmap_frame) decoder->bitmap_frame->lpVtbl->Release(decoder->bitmap_frame);
-    if (decoder->format_converter) decoder->format_converter->lpVtbl->Release(decoder->format_converter);
+VkImage create_texture_image(App *const app, VkFormat const format, uint32_t const width, uint32_t const height,
+                             uint32_t const mip_levels, bool const generates_mipmaps,
+                             MemoryAllocation *const allocation) {
+    VkImage image;
+    app->vkCreateImage(app->device, &(VkImageCreateInfo){
+                           .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+                           .imageType = VK_IMAGE_TYPE_2D,
+                           .format = format,
+                           .extent = {
+                               .width = width,
+                               .height = height,
+                               .depth = 1,
+                           },
+                           .mipLevels = mip_levels,
+                           .arrayLayers = 1,
+                           .samples = VK_SAMPLE_COUNT_1_BIT,
+                           .tiling = VK_IMAGE_TILING_OPTIMAL,
+                           .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT |
+                                    (generates_mipmaps ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : 0),
+                           .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                       },
+                       nullptr, &image);
+    *allocation = bind_image_memory(app, image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    return image;
 }
 
-HRESULT decode_image(ImageDecoder const *decoder, void *data) {
-    UINT const stride = decoder->width * 4;
-    return decoder->format_converter->lpVtbl->CopyPixels(decoder->format_converter, nullptr, stride,
-                                                         decoder->height * stride, (BYTE*)data);
+bool is_texture_format_supported(App const *const app, VkFormat const format) {
+    return (!ktx2_is_block_compressed(format) || app->physical_device_features.textureCompressionBC) &&
+           has_format_features(app, format, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT);
 }
 
-void create_buffers(App *app) {
-    auto const vkMapMemory = (PFN_vkMapMemory)app->vkGetDeviceProcAddr(app->device, "vkMapMemory");
-    auto const vkUnmapMemory = (PFN_vkUnmapMemory)app->vkGetDeviceProcAddr(app->device, "vkUnmapMemory");
-
-    // quad
-    Vec2 const vertex_data[] = {
-        {-1.0f, -1.0f},
-        {1.0f, -1.0f},
-        {-1.0f, 1.0f},
-        {1.0f, 1.0f},
+// pack textures already are in the staging layout, the levels point into the mapped pack
+bool read_pack_texture(App const *const app, char const *const name, TextureSource *const source) {
+    auto const entry = pack_find(&app->asset_pack, PACK_ENTRY_TEXTURE, name);
+    if (!entry || !is_texture_format_supported(app, (VkFormat)entry->format)) return false;
+    *source = (TextureSource){
+        .format = (VkFormat)entry->format,
+        .width = entry->width,
+        .height = entry->height,
+        .level_count = entry->level_count,
+        .data = pack_entry_data(&app->asset_pack, entry),
     };
-    constexpr uint32_t index_data[] = {0, 1, 2, 1, 2, 3};
+    memcpy(source->levels, entry->levels, entry->level_count * sizeof(Ktx2Level));
+    return true;
+}
 
-    ImageDecoder image_decoder = {};
-    load_image(app, RESOURCES_PATH L"images/Sample_3D.png", &image_decoder);
+// ktx2 files are prepared offline by codoxel_texture_encoder, the levels are used where they are in the file
+bool read_ktx2_texture(App const *const app, NativeChar const *filename, TextureSource *const source) {
+    void *data;
+    size_t size;
+    if (!load_file(filename, &data, &size)) return false;
 
-    VkDeviceMemory staging_buffer_memory, vertex_buffer_memory, index_buffer_memory;
+    Ktx2Info info;
+    if (!ktx2_read_info(data, size, &info) || !is_texture_format_supported(app, info.format)) {
+        free_file(data);
+        return false;
+    }
+    *source = (TextureSource){
+        .format = info.format,
+        .width = info.width,
+        .height = info.height,
+        .level_count = info.level_count,
+        .data = data,
+        .file_data = data,
+    };
+    memcpy(source->levels, info.levels, info.level_count * sizeof(Ktx2Level));
+    return true;
+}
 
+// decoded into the heap rather than the staging ring, which does not exist yet while this runs
+void read_png_texture(NativeChar const *filename, TextureSource *const source) {
+    ImageDecoder image_decoder = {};
+    load_image(filename, &image_decoder);
     size_t const image_size = image_decoder.width * image_decoder.height * 4;
+    auto const pixels = malloc(image_size);
+    decode_image(&image_decoder, pixels);
+    unload_image(&image_decoder);
+    *source = (TextureSource){
+        .format = VK_FORMAT_B8G8R8A8_SRGB,
+        .width = image_decoder.width,
+        .height = image_decoder.height,
+        .level_count = 1,
+        .levels = {{.size = image_size}},
+        .data = pixels,
+        .pixels = pixels,
+    };
+}
 
-    app->staging_buffer = create_buffer(
-        app, sizeof(vertex_data) + sizeof(index_data) + image_size,
-        &staging_buffer_memory,
-        VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-        VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    app->vertex_buffer = create_buffer(app, sizeof(vertex_data), &vertex_buffer_memory,
-                                       VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    app->index_buffer = create_buffer(app, sizeof(index_data), &index_buffer_memory,
-                                      VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    // create image
-    auto const vkCreateImage = (PFN_vkCreateImage)app->vkGetDeviceProcAddr(app->device, "vkCreateImage");
-    auto const vkGetImageMemoryRequirements = (PFN_vkGetImageMemoryRequirements)app->vkGetDeviceProcAddr(
-        app->device, "vkGetImageMemoryRequirements");
-    auto const vkCreateImageView = (PFN_vkCreateImageView)app->vkGetDeviceProcAddr(app->device, "vkCreateImageView");
-    auto const vkCreateSampler = (PFN_vkCreateSampler)app->vkGetDeviceProcAddr(app->device, "vkCreateSampler");
+// only reads and decodes, so it runs on a worker while the device is created
+void read_block_texture(App *const app) {
+    auto const source = &app->block_texture_source;
+    if (!read_pack_texture(app, "Sample_3D", source) &&
+        !read_ktx2_texture(app, RESOURCES_PATH NATIVE_TEXT("images/Sample_3D.ktx2"), source))
+        read_png_texture(RESOURCES_PATH NATIVE_TEXT("images/Sample_3D.png"), source);
+}
 
-    VkImage image;
-    vkCreateImage(app->device, &(VkImageCreateInfo){
-                      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-                      .imageType = VK_IMAGE_TYPE_2D,
-                      .format = VK_FORMAT_B8G8R8A8_SRGB,
-                      .extent = {
-                          .width = image_decoder.width,
-                          .height = image_decoder.height,
-                          .depth = 1,
-                      },
-                      .mipLevels = 1,
-                      .arrayLayers = 1,
-                      .samples = VK_SAMPLE_COUNT_1_BIT,
-                      .tiling = VK_IMAGE_TILING_OPTIMAL,
-                      .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-                      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-                  },
-                  nullptr, &image);
-
-    // allocate memory for image
-    auto const vkGetPhysicalDeviceMemoryProperties = (PFN_vkGetPhysicalDeviceMemoryProperties)app->
-        vkGetInstanceProcAddr(app->instance, "vkGetPhysicalDeviceMemoryProperties");
+// copies every level of the source into the staging ring with its own region and frees the source, the mips past
+// the stored ones are generated on the gpu once the levels are written, when the format allows it
+void upload_texture(App *const app, TextureSource *const source, Texture *const texture) {
+    bool const generates_mipmaps = source->level_count == 1 && can_generate_mipmaps(app, source->format);
+    *texture = (Texture){
+        .format = source->format,
+        .mip_levels = generates_mipmaps ? get_mip_level_count(source->width, source->height) : source->level_count,
+    };
+    texture->image = create_texture_image(app, source->format, source->width, source->height, texture->mip_levels,
+                                          generates_mipmaps, &texture->allocation);
 
-    VkPhysicalDeviceMemoryProperties memory_properties;
-    vkGetPhysicalDeviceMemoryProperties(app->physical_device, &memory_properties);
+    // region offsets stay multiples of the block size, 16 covers every format ktx2.h knows
+    VkBufferImageCopy regions[KTX2_MAX_LEVELS];
+    VkDeviceSize upload_size = 0;
+    for (uint32_t i = 0; i < source->level_count; ++i) {
+        upload_size = (upload_size + 15) & ~(VkDeviceSize)15;
+        regions[i] = (VkBufferImageCopy){
+            .bufferOffset = upload_size,
+            .imageSubresource = {
+                .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                .mipLevel = i,
+                .layerCount = 1,
+            },
+            .imageExtent = {
+                .width = source->width >> i ? source->width >> i : 1,
+                .height = source->height >> i ? source->height >> i : 1,
+                .depth = 1,
+            },
+        };
+        upload_size += source->levels[i].size;
+    }
+    auto const staging = (char*)upload_image(app, texture->image, texture->mip_levels, source->level_count, regions,
+                                             upload_size);
+    for (uint32_t i = 0; i < source->level_count; ++i)
+        memcpy(staging + regions[i].bufferOffset, (char const*)source->data + source->levels[i].offset,
+               source->levels[i].size);
+    if (generates_mipmaps)
+        request_mipmaps(app, texture->image, (VkExtent2D){source->width, source->height}, texture->mip_levels);
 
-    VkDeviceMemory image_memory;
-    VkMemoryRequirements memory_requirements;
-    vkGetImageMemoryRequirements(app->device, image, &memory_requirements);
-    uint32_t const memory_type_index = find_memory_type(&memory_properties, memory_requirements.memoryTypeBits,
-                                                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    auto const vkAllocateMemory = (PFN_vkAllocateMemory)app->vkGetDeviceProcAddr(app->device, "vkAllocateMemory");
-    auto const vkBindImageMemory = (PFN_vkBindImageMemory)app->vkGetDeviceProcAddr(app->device, "vkBindImageMemory");
-
-    vkAllocateMemory(app->device, &(VkMemoryAllocateInfo){
-                         .sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO,
-                         .allocationSize = memory_requirements.size,
-                         .memoryTypeIndex = memory_type_index,
-                     },
-                     nullptr, &image_memory);
-
-    vkBindImageMemory(app->device, image, image_memory, 0);
-
-    VkImageView image_view;
-    vkCreateImageView(app->device, &(VkImageViewCreateInfo){
-                          .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-                          .image = image,
-                          .viewType = VK_IMAGE_VIEW_TYPE_2D,
-                          .format = VK_FORMAT_B8G8R8A8_SRGB,
-                          .subresourceRange = {
-                              .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                              .levelCount = 1,
-                              .layerCount = 1,
-                          },
-                      },
-                      nullptr, &image_view);
-
-    VkSampler sampler;
-    vkCreateSampler(app->device, &(VkSamplerCreateInfo){
-                        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
-                        .magFilter = VK_FILTER_LINEAR,
-                        .minFilter = VK_FILTER_LINEAR,
-                        .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                        .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                        .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
-                    },
-                    nullptr, &sampler);
-
-    auto const vkUpdateDescriptorSets = (PFN_vkUpdateDescriptorSets)app->vkGetDeviceProcAddr(app->device,
-        "vkUpdateDescriptorSets");
-    vkUpdateDescriptorSets(app->device, 1, &(VkWriteDescriptorSet){
-                               .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-                               .dstSet = app->descriptor_set,
-                               .dstBinding = 0,
-                               .descriptorCount = 1,
-                               .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                               .pImageInfo = &(VkDescriptorImageInfo){
-                                   .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                                   .imageView = image_view,
-                                   .sampler = sampler,
-                               },
-                           },
-                           0, nullptr);
-
-    void *buffer_staging_data;
-    vkMapMemory(app->device, staging_buffer_memory, 0, VK_WHOLE_SIZE, 0, &buffer_staging_data);
-    size_t cursor = 0;
-    memcpy((char*)buffer_staging_data + cursor, vertex_data, sizeof(vertex_data));
-    cursor += sizeof(vertex_data);
-    memcpy((char*)buffer_staging_data + cursor, index_data, sizeof(index_data));
-    cursor += sizeof(index_data);
-    decode_image(&image_decoder, (char*)buffer_staging_data + cursor);
-    vkUnmapMemory(app->device, staging_buffer_memory);
-
-    auto const vkAllocateCommandBuffers = (PFN_vkAllocateCommandBuffers)app->vkGetDeviceProcAddr(
-        app->device, "vkAllocateCommandBuffers");
-    auto const vkBeginCommandBuffer = (PFN_vkBeginCommandBuffer)app->vkGetDeviceProcAddr(
-        app->device, "vkBeginCommandBuffer");
-    auto const vkEndCommandBuffer = (PFN_vkEndCommandBuffer)app->vkGetDeviceProcAddr(app->device, "vkEndCommandBuffer");
-    auto const vkCmdCopyBuffer = (PFN_vkCmdCopyBuffer)app->vkGetDeviceProcAddr(app->device, "vkCmdCopyBuffer");
-    auto const vkQueueSubmit = (PFN_vkQueueSubmit)app->vkGetDeviceProcAddr(app->device, "vkQueueSubmit");
-    auto const vkCreateFence = (PFN_vkCreateFence)app->vkGetDeviceProcAddr(app->device, "vkCreateFence");
-    auto const vkWaitForFences = (PFN_vkWaitForFences)app->vkGetDeviceProcAddr(app->device, "vkWaitForFences");
-    auto const vkDestroyFence = (PFN_vkDestroyFence)app->vkGetDeviceProcAddr(app->device, "vkDestroyFence");
-    auto const vkCmdCopyBufferToImage = (PFN_vkCmdCopyBufferToImage)app->vkGetDeviceProcAddr(app->device,
-        "vkCmdCopyBufferToImage");
-    auto const vkCmdPipelineBarrier = (PFN_vkCmdPipelineBarrier)app->vkGetDeviceProcAddr(app->device,
-        "vkCmdPipelineBarrier");
+    if (source->file_data) free_file(source->file_data);
+    free(source->pixels);
+    *source = (TextureSource){};
+}
 
-    VkCommandBuffer command_buffer;
-    vkAllocateCommandBuffers(app->device, &(VkCommandBufferAllocateInfo){
-                                 .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-                                 .commandPool = app->command_pool,
-                                 .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-                                 .commandBufferCount = 1,
-                             },
-                             &command_buffer);
+// returns the index shaders sample the texture with, can be called while frames are in flight since they never
+// sample a slot that was free when they were recorded
+uint32_t add_texture(App *const app, Texture texture) {
+    uint32_t index;
+    if (app->free_texture_index_count) index = app->free_texture_indices[--app->free_texture_index_count];
+    else if (app->texture_count < MAX_TEXTURES) index = app->texture_count++;
+    else fatal_error(app, L"Too many textures!");
 
-    vkBeginCommandBuffer(command_buffer, &(VkCommandBufferBeginInfo){
-                             .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
-                             .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
-                         });
-    cursor = 0;
-    vkCmdCopyBuffer(command_buffer, app->staging_buffer, app->vertex_buffer, 1, &(VkBufferCopy){
-                        .size = sizeof(vertex_data),
-                        .srcOffset = cursor,
-                    });
-    cursor += sizeof(vertex_data);
-    vkCmdCopyBuffer(command_buffer, app->staging_buffer, app->index_buffer, 1, &(VkBufferCopy){
-                        .size = sizeof(index_data),
-                        .srcOffset = cursor,
-                    });
-    cursor += sizeof(index_data);
-    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
-                         0,
-                         nullptr, 1, &(VkImageMemoryBarrier){
-                             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                             .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                             .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                             .image = image,
-                             .subresourceRange = {
-                                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                 .levelCount = 1,
-                                 .layerCount = 1,
-                             },
-                         });
-    vkCmdCopyBufferToImage(command_buffer, app->staging_buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-                           &(VkBufferImageCopy){
-                               .imageSubresource = {
+    app->vkCreateImageView(app->device, &(VkImageViewCreateInfo){
+                               .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+                               .image = texture.image,
+                               .viewType = VK_IMAGE_VIEW_TYPE_2D,
+                               .format = texture.format,
+                               .subresourceRange = {
                                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                                   .levelCount = texture.mip_levels,
                                    .layerCount = 1,
                                },
-                               .imageExtent = {
-                                   .width = image_decoder.width,
-                                   .height = image_decoder.height,
-                                   .depth = 1,
-                               },
-                           });
-    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
-                         nullptr, 0, nullptr, 1, &(VkImageMemoryBarrier){
-                             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-                             .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                             .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
-                             .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                             .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                             .image = image,
-                             .subresourceRange = {
-                                 .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
-                                 .levelCount = 1,
-                                 .layerCount = 1,
-                             },
-                         });
-    vkEndCommandBuffer(command_buffer);
-    VkFence fence;
-    vkCreateFence(app->device, &(VkFenceCreateInfo){
-                      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
-                  }, nullptr, &fence);
-    vkQueueSubmit(app->queue, 1, &(VkSubmitInfo){
-                      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-                      .commandBufferCount = 1,
-                      .pCommandBuffers = &command_buffer,
-                  }, fence);
-    vkWaitForFences(app->device, 1, &fence, true, UINT64_MAX);
-    vkDestroyFence(app->device, fence, nullptr);
+                           },
+                           nullptr, &texture.view);
+    app->textures[index] = texture;
+    app->vkUpdateDescriptorSets(app->device, 1, &(VkWriteDescriptorSet){
+                                    .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+                                    .dstSet = app->descriptor_set,
+                                    .dstBinding = 1,
+                                    .dstArrayElement = index,
+                                    .descriptorCount = 1,
+                                    .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                                    .pImageInfo = &(VkDescriptorImageInfo){
+                                        .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                        .imageView = texture.view,
+                                    },
+                                },
+                                0, nullptr);
+    return index;
 }
 
-void create_descriptor_pool(App *app) {
-    auto const vkCreateDescriptorPool = (PFN_vkCreateDescriptorPool)app->vkGetDeviceProcAddr(app->device,
-        "vkCreateDescriptorPool");
-    vkCreateDescriptorPool(app->device, &(VkDescriptorPoolCreateInfo){
-                               .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-                               .maxSets = 1,
-                               .poolSizeCount = 1,
-                               .pPoolSizes = &(VkDescriptorPoolSize){
-                                   .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                   .descriptorCount = 1,
-                               },
-                           },
-                           nullptr, &app->descriptor_pool);
+// blocks still pointing at the texture have to be moved to another one first, the slot keeps its stale descriptor
+// until it is handed out again, which partially bound descriptors allow
+void remove_texture(App *const app, uint32_t const index) {
+    auto const texture = &app->textures[index];
+    defer_deletion(app, (DeferredDeletion){.type = DEFERRED_IMAGE_VIEW, .image_view = texture->view});
+    defer_deletion(app, (DeferredDeletion){.type = DEFERRED_IMAGE, .image = texture->image});
+    defer_deletion(app, (DeferredDeletion){.type = DEFERRED_MEMORY, .allocation = texture->allocation});
+    defer_deletion(app, (DeferredDeletion){.type = DEFERRED_TEXTURE_INDEX, .texture_index = index});
+    *texture = (Texture){};
 }
 
-void create_descriptor_set_layout(App *app) {
-    auto const vkCreateDescriptorSetLayout = (PFN_vkCreateDescriptorSetLayout)app->vkGetDeviceProcAddr(app->device,
-        "vkCreateDescriptorSetLayout");
-    vkCreateDescriptorSetLayout(app->device, &(VkDescriptorSetLayoutCreateInfo){
-                                    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-                                    .bindingCount = 1,
-                                    .pBindings = &(VkDescriptorSetLayoutBinding){
-                                        .binding = 0,
-                                        .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-                                        .descriptorCount = 1,
-                                        .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+void mark_block_texture_dirty(App *const app, uint32_t const layer) {
+    if (app->dirty_block_texture_begin == app->dirty_block_texture_end) {
+        app->dirty_block_texture_begin = layer;
+        app->dirty_block_texture_end = layer + 1;
+    } else {
+        if (layer < app->dirty_block_texture_begin) app->dirty_block_texture_begin = layer;
+        if (layer >= app->dirty_block_texture_end) app->dirty_block_texture_end = layer + 1;
+    }
+}
+
+// textures are texture indices indexed by CHUNK_FACE_*, the next frame copies the change into the table before it
+// draws, the frames before it keep the old textures, meshes are not rebuilt
+void set_block_textures(App *const app, BlockId const block, uint32_t const textures[CHUNK_FACE_COUNT]) {
+    auto const layer = block % MESH_VERTEX_MAX_LAYERS;
+    memcpy(app->block_textures[layer].textures, textures, sizeof(app->block_textures[layer].textures));
+    mark_block_texture_dirty(app, layer);
+}
+
+void set_block_tint(App *const app, BlockId const block, uint32_t const tint) {
+    auto const layer = block % MESH_VERTEX_MAX_LAYERS;
+    app->block_textures[layer].tint = tint;
+    mark_block_texture_dirty(app, layer);
+}
+
+// fills one chunk of a world, all of its chunks are generated before any of them is meshed
+typedef void (*ChunkGenerator)(Chunk *chunk, int32_t chunk_x, int32_t chunk_z);
+
+// rolling hills of stone under dirt under grass with a few pillars topped by lamps, until chunks come from a generator
+void generate_demo_chunk(Chunk *const chunk, int32_t const chunk_x, int32_t const chunk_z) {
+    chunk_init(chunk, chunk_x, 0, chunk_z, BLOCK_AIR);
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+            int32_t const world_x = chunk_x * (int32_t)CHUNK_SIZE + (int32_t)x;
+            int32_t const world_z = chunk_z * (int32_t)CHUNK_SIZE + (int32_t)z;
+            auto const height = (uint32_t)(10.0f + 3.0f * sinf((float)world_x * 0.3f) +
+                                           3.0f * cosf((float)world_z * 0.25f));
+            chunk_fill(chunk, (uint32_t[]){x, 0, z}, (uint32_t[]){x + 1, height - 3, z + 1}, 1);
+            chunk_fill(chunk, (uint32_t[]){x, height - 3, z}, (uint32_t[]){x + 1, height, z + 1}, 2);
+            chunk_set_block(chunk, x, height, z, 3);
+            if ((uint32_t)(world_x * 7 + world_z * 13) % 97 == 0) {
+                chunk_fill(chunk, (uint32_t[]){x, height + 1, z}, (uint32_t[]){x + 1, height + 8, z + 1}, 1);
+                chunk_set_block(chunk, x, height + 8, z, BLOCK_LAMP);
+            }
+        }
+}
+
+// the section draw infos and the draw commands of every frame in flight for draw_count sections
+void create_chunk_draw_buffers(App *const app, uint32_t const draw_count) {
+    app->chunk_draw_capacity = draw_count;
+    app->chunk_info_buffer = create_buffer(app, draw_count * sizeof(ChunkDrawInfo), &app->chunk_info_allocation,
+                                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                           VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                           VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    app->chunk_info_buffer_device_address = get_buffer_device_address(app, app->chunk_info_buffer);
+    app->draw_command_buffer = create_buffer(app, app->in_flight_frame_count * draw_count *
+                                                  sizeof(VkDrawIndexedIndirectCommand), &app->draw_command_allocation,
+                                             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                             VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                             VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    app->draw_command_buffer_device_address = get_buffer_device_address(app, app->draw_command_buffer);
+    free(app->chunk_draw_infos);
+    free(app->loaded_chunks);
+    app->chunk_draw_infos = calloc(draw_count, sizeof(ChunkDrawInfo));
+    app->loaded_chunks = calloc(draw_count / CHUNK_SECTION_COUNT, sizeof(LoadedChunk));
+}
+
+void create_chunk_buffers(App *const app) {
+    create_chunk_arenas(app, INITIAL_CHUNK_ARENA_QUADS);
+    create_chunk_draw_buffers(app, INITIAL_CHUNK_DRAWS);
+    MemoryAllocation draw_count_allocation;
+    app->draw_count_buffer = create_buffer(app, app->in_flight_frame_count * sizeof(DrawCounts),
+                                           &draw_count_allocation,
+                                           VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                           VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                           VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                           VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    app->draw_count_buffer_device_address = get_buffer_device_address(app, app->draw_count_buffer);
+    reset_mesh_ranges(app);
+}
+
+typedef struct WorldBuild WorldBuild;
+
+// one chunk on its way through the jobs, generated, lit and meshed on workers and uploaded on the render thread
+typedef struct {
+    WorldBuild *world;
+    // owned by app->world
+    Chunk *chunk;
+    ChunkMesh meshes[CHUNK_SECTION_COUNT];
+    ChunkConnectivity connectivity;
+    // false when the chunk was loaded from its region file
+    bool is_generated;
+} ChunkBuild;
+
+// chunks are lit once every chunk is generated and meshed once all of them are lit, so each mesh sees its neighbors,
+// skips the faces between them and takes the light that crosses into it
+struct WorldBuild {
+    App *app;
+    // the world is size by size chunks
+    int32_t size;
+    ChunkGenerator generate;
+    JobCounter generated;
+    LightBatch *light;
+    JobCounter lit;
+    uint32_t pending_upload_count;
+    uint32_t triangle_count;
+    uint32_t generated_count;
+    uint64_t start;
+    ChunkBuild chunks[];
+};
+
+void generate_chunk_job(void *const data) {
+    ChunkBuild *const build = data;
+    auto const world = build->world;
+    auto const index = (int32_t)(build - world->chunks);
+    int32_t const x = index % world->size, z = index / world->size;
+    // the world created it filled with air, reading or generating initializes it again
+    chunk_free(build->chunk);
+    auto const app = world->app;
+    if (app->world_regions) {
+        auto const scratch = &app->region_scratches[job_system_worker_index(app->jobs)];
+        if (region_read_chunk(chunk_region(app, x, z), scratch, x, 0, z, build->chunk)) return;
+    }
+    world->generate(build->chunk, x, z);
+    build->is_generated = true;
+}
+
+void upload_chunk_mesh(void *const data) {
+    ChunkBuild *const build = data;
+    auto const world = build->world;
+    auto const app = world->app;
+    auto const chunk = build->chunk;
+    auto const cell = visibility_grid_cell(&app->visibility, chunk->x, chunk->y, chunk->z);
+    if (cell != UINT32_MAX) {
+        app->visibility.connectivity[cell] = build->connectivity;
+        app->cell_chunk_indices[cell] = app->chunk_count;
+    }
+    add_loaded_chunk(app, chunk, build->meshes);
+    for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+        world->triangle_count += build->meshes[section].index_count / 3;
+        chunk_mesh_free(&build->meshes[section]);
+    }
+    if (build->is_generated) {
+        ++world->generated_count;
+        // every generate job is done once a mesh arrives, so nothing reads the region while it grows
+        if (app->world_regions) save_chunk(app, chunk);
+    }
+    if (--world->pending_upload_count) return;
+
+    // the chunks stay in app->world for the edits
+    auto const chunk_count = (uint32_t)(world->size * world->size);
+    printf("loaded %u, generated %u and meshed %u chunks into %u triangles in %.3f ms\n",
+           chunk_count - world->generated_count, world->generated_count, chunk_count, world->triangle_count,
+           (double)(get_time_ns() - world->start) / 1e6);
+    light_batch_destroy(world->light);
+    free(world);
+    app->is_world_ready = true;
+}
+
+void mesh_chunk_job(void *const data) {
+    ChunkBuild *const build = data;
+    auto const world = build->world;
+    auto const app = world->app;
+    auto const chunk = build->chunk;
+    Chunk const *neighbors[CHUNK_NEIGHBOR_COUNT];
+    world_get_neighbors(&app->world, chunk->x, chunk->y, chunk->z, neighbors);
+    auto const worker_index = job_system_worker_index(app->jobs);
+    mesh_chunk_sections(&app->mesher_scratches[worker_index], chunk, neighbors, CHUNK_ALL_SECTIONS,
+                        build->meshes);
+    build->connectivity = chunk_connectivity(&app->connectivity_scratches[worker_index], chunk);
+    job_system_defer_to_main(app->jobs, upload_chunk_mesh, build);
+}
+
+void start_world_build(App *const app, int32_t const size, ChunkGenerator const generate) {
+    auto const chunk_count = size * size;
+    WorldBuild *const world = calloc(1, sizeof(WorldBuild) + (size_t)chunk_count * sizeof(ChunkBuild));
+    world->app = app;
+    world->size = size;
+    world->generate = generate;
+    world->pending_upload_count = (uint32_t)chunk_count;
+    world->start = get_time_ns();
+    if (app->world_path) open_world_regions(app, size);
+
+    Job generate_jobs[chunk_count], mesh_jobs[chunk_count];
+    // the jobs only fill the chunks, the table of the world is not touched until the build is done
+    world->light = light_batch_create(&app->world, app->light_scratches);
+    for (int32_t i = 0; i < chunk_count; ++i) {
+        world->chunks[i].world = world;
+        world->chunks[i].chunk = world_create_chunk(&app->world, i % size, 0, i / size);
+        light_batch_add_chunk(world->light, world->chunks[i].chunk);
+        generate_jobs[i] = (Job){.function = generate_chunk_job, .data = &world->chunks[i]};
+        mesh_jobs[i] = (Job){.function = mesh_chunk_job, .data = &world->chunks[i]};
+    }
+    job_system_submit(app->jobs, generate_jobs, (uint32_t)chunk_count, &world->generated);
+    light_batch_submit(world->light, app->jobs, &world->generated, &world->lit);
+    job_system_submit_after(app->jobs, &world->lit, mesh_jobs, (uint32_t)chunk_count, nullptr);
+}
+
+// one layer of air cells above the terrain, so the camera starts its walk inside the grid
+void create_visibility_grid(App *const app, int32_t const size) {
+    visibility_grid_init(&app->visibility, (int32_t[]){0, 0, 0}, (uint32_t[]){(uint32_t)size, 2, (uint32_t)size});
+    app->visible_cells = malloc(app->visibility.cell_count * sizeof(uint32_t));
+    app->cell_chunk_indices = malloc(app->visibility.cell_count * sizeof(uint32_t));
+    memset(app->cell_chunk_indices, 0xFF, app->visibility.cell_count * sizeof(uint32_t));
+}
+
+void destroy_visibility_grid(App *const app) {
+    visibility_grid_free(&app->visibility);
+    free(app->visible_cells);
+    free(app->cell_chunk_indices);
+    app->visible_cells = nullptr;
+    app->cell_chunk_indices = nullptr;
+}
+
+// replaces every chunk with a size by size world, the chunks show up over the next frames as their meshes arrive
+// the arenas are reused from the start, so the device must be idle and the previous world fully uploaded
+void load_world(App *const app, int32_t const size, ChunkGenerator const generate) {
+    finish_remesh_batch(app);
+    // nothing in flight draws the old ranges anymore, they are returned before the arenas start over
+    app->completed_frame_count = app->frame_count;
+    run_deferred_deletions(app);
+    // the device is idle, the draw buffers and frame slots too small for the new world are replaced right away
+    auto const draw_count = (uint32_t)(size * size) * CHUNK_SECTION_COUNT;
+    if (draw_count > app->chunk_draw_capacity) {
+        destroy_buffer(app, app->chunk_info_buffer, &app->chunk_info_allocation);
+        destroy_buffer(app, app->draw_command_buffer, &app->draw_command_allocation);
+        destroy_buffer(app, app->frame_memory_buffer, &app->frame_memory);
+        create_chunk_draw_buffers(app, draw_count);
+        create_frame_memory(app);
+    }
+    release_empty_memory_blocks(app);
+    reset_mesh_ranges(app);
+    app->dirty_draw_info_begin = 0;
+    app->dirty_draw_info_end = 0;
+    app->block_edit_count = 0;
+    if (app->visible_cells) destroy_visibility_grid(app);
+    world_free(&app->world);
+    close_world_regions(app);
+    world_init(&app->world);
+    app->chunk_count = 0;
+    app->is_world_ready = false;
+    create_visibility_grid(app, size);
+    app->camera_target = (Vec3){(float)size * CHUNK_SIZE / 2.0f, CHUNK_SIZE / 3.0f, (float)size * CHUNK_SIZE / 2.0f};
+    start_world_build(app, size, generate);
+}
+
+void create_buffers(App *app) {
+    app->mesher_scratches = malloc(job_system_thread_count(app->jobs) * sizeof(MesherScratch));
+    app->connectivity_scratches = malloc(job_system_thread_count(app->jobs) * sizeof(ConnectivityScratch));
+    app->light_scratches = calloc(job_system_thread_count(app->jobs), sizeof(LightScratch));
+    if (app->world_path) app->region_scratches = malloc(job_system_thread_count(app->jobs) * sizeof(RegionScratch));
+    create_chunk_buffers(app);
+
+    MemoryAllocation block_texture_allocation;
+    app->block_texture_buffer = create_buffer(app, sizeof(app->block_textures), &block_texture_allocation,
+                                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                              VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT |
+                                              VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    app->block_texture_buffer_device_address = get_buffer_device_address(app, app->block_texture_buffer);
+
+    // one texture for every face of every block until blocks come with their own, the demo blocks are told apart by
+    // their tint, stone, dirt, grass and the lamp
+    Texture texture;
+    upload_texture(app, &app->block_texture_source, &texture);
+    auto const texture_index = add_texture(app, texture);
+    uint32_t const demo_tints[] = {[1] = 0xFFA69999, [2] = 0xFF40668C, [3] = 0xFF4DB359, [BLOCK_LAMP] = 0xFF99E6FF};
+    uint32_t textures[CHUNK_FACE_COUNT];
+    for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) textures[face] = texture_index;
+    for (uint32_t i = 0; i < MESH_VERTEX_MAX_LAYERS; ++i) {
+        auto const has_tint = i && i < sizeof(demo_tints) / sizeof(demo_tints[0]);
+        set_block_textures(app, (BlockId)i, textures);
+        set_block_tint(app, (BlockId)i, has_tint ? demo_tints[i] : 0xFFFFFFFF);
+    }
+    flush_uploads(app);
+}
+
+// immutable in the descriptor set layout, every texture is sampled the same way
+void create_texture_sampler(App *const app) {
+    app->vkCreateSampler(app->device, &(VkSamplerCreateInfo){
+                             .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+                             .magFilter = VK_FILTER_LINEAR,
+                             .minFilter = VK_FILTER_LINEAR,
+                             .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+                             .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                             .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                             .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+                             .maxLod = VK_LOD_CLAMP_NONE,
+                         },
+                         nullptr, &app->texture_sampler);
+}
+
+void create_descriptor_pool(App *app) {
+    app->vkCreateDescriptorPool(app->device, &(VkDescriptorPoolCreateInfo){
+                                    .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+                                    .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+                                    .maxSets = 1,
+                                    .poolSizeCount = 2,
+                                    .pPoolSizes = (VkDescriptorPoolSize[]){
+                                        {
+                                            .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+                                            .descriptorCount = 1,
+                                        },
+                                        {
+                                            .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                                            .descriptorCount = MAX_TEXTURES,
+                                        },
                                     },
                                 },
-                                nullptr, &app->descriptor_set_layout);
+                                nullptr, &app->descriptor_pool);
+}
+
+// the texture array is written while the set is bound and frames are in flight, only slots that no recorded frame
+// can sample are ever written
+void create_descriptor_set_layout(App *app) {
+    app->vkCreateDescriptorSetLayout(app->device, &(VkDescriptorSetLayoutCreateInfo){
+                                         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+                                         .pNext = &(VkDescriptorSetLayoutBindingFlagsCreateInfo){
+                                             .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+                                             .bindingCount = 2,
+                                             .pBindingFlags = (VkDescriptorBindingFlags[]){
+                                                 0,
+                                                 VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                                 VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                 VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+                                             },
+                                         },
+                                         .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+                                         .bindingCount = 2,
+                                         .pBindings = (VkDescriptorSetLayoutBinding[]){
+                                             {
+                                                 .binding = 0,
+                                                 .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+                                                 .descriptorCount = 1,
+                                                 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                                                 .pImmutableSamplers = &app->texture_sampler,
+                                             },
+                                             {
+                                                 .binding = 1,
+                                                 .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+                                                 .descriptorCount = MAX_TEXTURES,
+                                                 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT,
+                                             },
+                                         },
+                                     },
+                                     nullptr, &app->descriptor_set_layout);
 }
 
 void create_descriptor_set(App *app) {
-    auto const vkAllocateDescriptorSets = (PFN_vkAllocateDescriptorSets)app->vkGetDeviceProcAddr(app->device,
-        "vkAllocateDescriptorSets");
-    vkAllocateDescriptorSets(app->device, &(VkDescriptorSetAllocateInfo){
-                                 .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-                                 .descriptorPool = app->descriptor_pool,
-                                 .descriptorSetCount = 1,
-                                 .pSetLayouts = &app->descriptor_set_layout,
-                             },
-                             &app->descriptor_set);
+    app->vkAllocateDescriptorSets(app->device, &(VkDescriptorSetAllocateInfo){
+                                      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+                                      .descriptorPool = app->descriptor_pool,
+                                      .descriptorSetCount = 1,
+                                      .pSetLayouts = &app->descriptor_set_layout,
+                                  },
+                                  &app->descriptor_set);
+}
+
+VkPresentModeKHR parse_present_mode(NativeChar const *const name) {
+    if (!native_compare(name, NATIVE_TEXT("immediate"))) return VK_PRESENT_MODE_IMMEDIATE_KHR;
+    if (!native_compare(name, NATIVE_TEXT("mailbox"))) return VK_PRESENT_MODE_MAILBOX_KHR;
+    return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+void parse_arguments(App *const app, int const argc, NativeChar **const argv) {
+    for (int i = 1; i < argc; ++i) {
+        if (!native_compare(argv[i], NATIVE_TEXT("--headless")))
+            app->headless = true;
+        else if (!native_compare(argv[i], NATIVE_TEXT("--frames")) && i + 1 < argc)
+            app->headless_frame_count = (uint32_t)native_to_ulong(argv[++i], nullptr, 10);
+        else if (!native_compare(argv[i], NATIVE_TEXT("--trace")) && i + 1 < argc)
+            // the windows argv is freed right after parsing
+            app->trace_path = native_duplicate(argv[++i]);
+        else if (!native_compare(argv[i], NATIVE_TEXT("--world")) && i + 1 < argc)
+            app->world_path = native_duplicate(argv[++i]);
+        else if (!native_compare(argv[i], NATIVE_TEXT("--cold-pipeline-cache")))
+            app->cold_pipeline_cache = true;
+        else if (!native_compare(argv[i], NATIVE_TEXT("--present-mode")) && i + 1 < argc)
+            app->requested_present_mode = parse_present_mode(argv[++i]);
+        else if (!native_compare(argv[i], NATIVE_TEXT("--fps-limit")) && i + 1 < argc)
+            app->frame_rate_limit = (uint32_t)native_to_ulong(argv[++i], nullptr, 10);
+        else if (!native_compare(argv[i], NATIVE_TEXT("--frames-in-flight")) && i + 1 < argc)
+            app->in_flight_frame_count = (uint32_t)native_to_ulong(argv[++i], nullptr, 10);
+        else if (!native_compare(argv[i], NATIVE_TEXT("--width")) && i + 1 < argc)
+            app->headless_extent.width = (uint32_t)native_to_ulong(argv[++i], nullptr, 10);
+        else if (!native_compare(argv[i], NATIVE_TEXT("--height")) && i + 1 < argc)
+            app->headless_extent.height = (uint32_t)native_to_ulong(argv[++i], nullptr, 10);
+    }
+    if (app->in_flight_frame_count < 1) app->in_flight_frame_count = 1;
+    if (app->in_flight_frame_count > MAX_IN_FLIGHT_FRAMES) app->in_flight_frame_count = MAX_IN_FLIGHT_FRAMES;
+}
+
+// a startup step run as a job, so independent steps overlap with what the render thread does meanwhile
+typedef struct {
+    App *app;
+    char const *name;
+    void (*step)(App *app);
+    uint64_t start_ns, end_ns;
+} StartupTask;
+
+void run_startup_task(void *const data) {
+    auto const task = (StartupTask*)data;
+    task->start_ns = get_time_ns();
+    task->step(task->app);
+    task->end_ns = get_time_ns();
+    record_startup_step(task->app, task->name, task->start_ns, task->end_ns);
+}
+
+void submit_startup_tasks(App *const app, StartupTask *const tasks, uint32_t const count, JobCounter *const counter) {
+    Job jobs[count];
+    for (uint32_t i = 0; i < count; ++i) jobs[i] = (Job){.function = run_startup_task, .data = &tasks[i]};
+    job_system_submit(app->jobs, jobs, count, counter);
+}
+
+void create_descriptors(App *const app) {
+    create_texture_sampler(app);
+    create_descriptor_pool(app);
+    create_descriptor_set_layout(app);
+    create_descriptor_set(app);
+}
+
+void create_pipeline_layouts(App *const app) {
+    app->depth_format = pick_depth_format(app);
+    create_pipeline_layout(app);
+}
+
+void create_upload_resources(App *const app) {
+    create_command_pool(app);
+    create_upload_ring(app);
+}
+
+void create_frame_resources(App *const app) {
+    allocate_command_buffers(app);
+    create_synchronization_objects(app);
+    create_timestamp_pools(app);
+}
+
+// the shaders and the block texture were read while the device was created, the pipelines compile on workers while
+// the render thread records the first uploads
+void create_renderer(App *const app) {
+    run_startup_step(app, "descriptors", create_descriptors);
+    run_startup_step(app, "pipeline layouts", create_pipeline_layouts);
+    run_startup_step(app, "shader module", create_shader_module);
+    run_startup_step(app, "pipeline cache", create_pipeline_cache);
+    StartupTask pipeline_tasks[] = {
+        {.app = app, .name = "graphics pipeline", .step = create_pipeline},
+        {.app = app, .name = "cull pipeline", .step = create_cull_pipeline},
+    };
+    JobCounter pipelines = {};
+    submit_startup_tasks(app, pipeline_tasks, 2, &pipelines);
+
+    run_startup_step(app, "upload ring", create_upload_resources);
+    run_startup_step(app, "buffers and textures", create_buffers);
+    run_startup_step(app, "frame memory", create_frame_memory);
+    job_system_wait(app->jobs, &pipelines);
+    // from the first pipeline starting to the last one finishing
+    uint64_t pipeline_start = pipeline_tasks[0].start_ns, pipeline_end = pipeline_tasks[0].end_ns;
+    if (pipeline_tasks[1].start_ns < pipeline_start) pipeline_start = pipeline_tasks[1].start_ns;
+    if (pipeline_tasks[1].end_ns > pipeline_end) pipeline_end = pipeline_tasks[1].end_ns;
+    printf("pipeline creation took %.3f ms with a %s cache\n", (double)(pipeline_end - pipeline_start) / 1e6,
+           app->is_pipeline_cache_warm ? "warm" : "cold");
+    unload_shaders(app);
+    pack_close(&app->asset_pack);
+
+    run_startup_step(app, "command buffers and sync", create_frame_resources);
+}
+
+// the window has to belong to the render thread, which pumps its messages, so it is created there while a worker
+// creates the instance, the assets are read on workers while the render thread creates the device
+void start_renderer(App *const app) {
+    app->startup_start_ns = get_time_ns();
+    run_startup_step(app, "vulkan library", load_vulkan_library);
+    StartupTask instance_task = {.app = app, .name = "instance", .step = create_instance};
+    JobCounter instance = {};
+    submit_startup_tasks(app, &instance_task, 1, &instance);
+#ifdef _WIN32
+    if (!app->headless) run_startup_step(app, "window", create_window);
+#endif
+    job_system_wait(app->jobs, &instance);
+#ifdef _WIN32
+    if (!app->headless) run_startup_step(app, "surface", create_surface);
+#endif
+    run_startup_step(app, "physical device", pick_physical_device);
+    run_startup_step(app, "asset pack", open_asset_pack);
+
+    StartupTask asset_tasks[] = {
+        {.app = app, .name = "shaders", .step = read_shaders},
+        {.app = app, .name = "block texture", .step = read_block_texture},
+    };
+    JobCounter assets = {};
+    submit_startup_tasks(app, asset_tasks, 2, &assets);
+    run_startup_step(app, "device", create_device);
+    job_system_wait(app->jobs, &assets);
+    create_renderer(app);
+}
+
+// frames still in flight are resolved first, so call it once the device is idle
+void report_profile(App *const app) {
+    resolve_in_flight_frames(app);
+    auto const stats = profiler_frame_time_stats(&app->profiler);
+    printf("frame times over the last %u frames: average %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, "
+           "max %.3f ms\n", stats.frame_count, stats.average_ms, stats.p50_ms, stats.p95_ms, stats.p99_ms,
+           stats.max_ms);
+    auto const latency = profiler_latency_stats(&app->profiler);
+    if (latency.frame_count)
+        printf("input to present latency over the last %u frames: average %.3f ms, p50 %.3f ms, p95 %.3f ms, "
+               "p99 %.3f ms, max %.3f ms\n", latency.frame_count, latency.average_ms, latency.p50_ms, latency.p95_ms,
+               latency.p99_ms, latency.max_ms);
+    if (!app->trace_path) return;
+
+    size_t size;
+    char *const trace = profiler_chrome_trace(&app->profiler, &size);
+    if (!save_file(app->trace_path, trace, size))
+        fprintf(stderr, "Cannot write trace\n");
+    free(trace);
+}
+
+int run_headless(App *const app) {
+    configure_offscreen_images(app);
+
+    uint64_t const start = get_time_ns();
+    for (uint32_t i = 0; i < app->headless_frame_count; ++i) {
+        wait_for_frame(app);
+        pace_frame(app);
+        sample_input(app);
+        render(app);
+    }
+    app->vkDeviceWaitIdle(app->device);
+    uint64_t const elapsed = get_time_ns() - start;
+
+    double const milliseconds = (double)elapsed / 1e6;
+    printf("%u frames at %ux%u in %.3f ms, %.3f ms/frame, %.1f fps\n", app->headless_frame_count,
+           app->headless_extent.width, app->headless_extent.height, milliseconds,
+           milliseconds / app->headless_frame_count, app->headless_frame_count * 1e3 / milliseconds);
+    report_profile(app);
+    return 0;
+}
+
+#ifdef CODOXEL_BENCH
+constexpr uint32_t DEFAULT_BENCH_FRAME_COUNT = 300;
+// rendered between the upload of a scene and its measurement, so no upload or first use lands in the numbers
+constexpr uint32_t BENCH_WARMUP_FRAME_COUNT = 16;
+constexpr uint32_t DEFAULT_BENCH_TOLERANCE_PERCENT = 10;
+
+// the flat slab that replaced the textured quad, about the least the renderer can draw
+void generate_quad_chunk(Chunk *const chunk, int32_t const chunk_x, int32_t const chunk_z) {
+    chunk_init(chunk, chunk_x, 0, chunk_z, BLOCK_AIR);
+    chunk_fill(chunk, (uint32_t[]){0, 0, 0}, (uint32_t[]){CHUNK_SIZE, 1, CHUNK_SIZE}, 3);
+}
+
+// every other voxel is solid, so no face is hidden or merged and each block keeps all six, the worst case for the
+// mesher, the arenas and the rasterizer
+void generate_checkerboard_chunk(Chunk *const chunk, int32_t const chunk_x, int32_t const chunk_z) {
+    chunk_init(chunk, chunk_x, 0, chunk_z, BLOCK_AIR);
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+        for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+            for (uint32_t x = (y + z) & 1; x < CHUNK_SIZE; x += 2)
+                chunk_set_block(chunk, x, y, z, (BlockId)(1 + y % 3));
+}
+
+// a crater of radius 3 every frame, walking across the demo world so it keeps hitting new sections and chunks
+void carve_bench_crater(App *const app, uint32_t const frame) {
+    constexpr int32_t RADIUS = 3;
+    int32_t const extent = DEMO_WORLD_SIZE * (int32_t)CHUNK_SIZE - 2 * RADIUS;
+    int32_t const center_x = RADIUS + (int32_t)(frame * 7 % (uint32_t)extent);
+    int32_t const center_z = RADIUS + (int32_t)(frame * 11 % (uint32_t)extent);
+    int32_t const center_y = 10;
+    for (int32_t y = -RADIUS; y <= RADIUS; ++y)
+        for (int32_t z = -RADIUS; z <= RADIUS; ++z)
+            for (int32_t x = -RADIUS; x <= RADIUS; ++x)
+                if (x * x + y * y + z * z <= RADIUS * RADIUS)
+                    edit_block(app, center_x + x, center_y + y, center_z + z, BLOCK_AIR);
+}
+
+// a new texture for the grass every frame, hot added while the frames before it still sample the one it replaces,
+// which is removed right away, so the texture slots, images and block texture table keep cycling
+void retexture_bench_grass(App *const app, uint32_t const frame) {
+    constexpr BlockId GRASS = 3;
+    constexpr uint32_t SIZE = 16;
+    uint32_t *const pixels = malloc(SIZE * SIZE * sizeof(uint32_t));
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i) pixels[i] = 0xFF000000 | (frame * 0x030507 + i) % 0x1000000;
+    TextureSource source = {
+        .format = VK_FORMAT_B8G8R8A8_SRGB,
+        .width = SIZE,
+        .height = SIZE,
+        .level_count = 1,
+        .levels = {{.size = SIZE * SIZE * sizeof(uint32_t)}},
+        .data = pixels,
+        .pixels = pixels,
+    };
+    Texture texture;
+    upload_texture(app, &source, &texture);
+    auto const index = add_texture(app, texture);
+    auto const replaced = app->block_textures[GRASS].textures[0];
+    uint32_t textures[CHUNK_FACE_COUNT];
+    for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) textures[face] = index;
+    set_block_textures(app, GRASS, textures);
+    set_block_tint(app, GRASS, frame & 1 ? 0xFF4DB359 : 0xFF59B34D);
+    // the other demo blocks keep sharing the first texture
+    if (replaced != app->block_textures[GRASS - 1].textures[0]) remove_texture(app, replaced);
+}
+
+typedef struct {
+    char const *name;
+    int32_t size;
+    ChunkGenerator generate;
+    // called before every measured frame when set
+    void (*edit)(App *app, uint32_t frame);
+} BenchScene;
+
+// generators are deterministic, so a scene draws the same triangles on every run and device
+static BenchScene const bench_scenes[] = {
+    {"quad", 1, generate_quad_chunk},
+    {"chunk", 1, generate_demo_chunk},
+    {"grid", DEMO_WORLD_SIZE, generate_demo_chunk},
+    {"checkerboard", 4, generate_checkerboard_chunk},
+    {"edits", DEMO_WORLD_SIZE, generate_demo_chunk, carve_bench_crater},
+    {"retexture", DEMO_WORLD_SIZE, generate_demo_chunk, retexture_bench_grass},
+};
+constexpr uint32_t BENCH_SCENE_COUNT = sizeof(bench_scenes) / sizeof(bench_scenes[0]);
+
+typedef enum {
+    BENCH_METRIC_CPU_MS,
+    BENCH_METRIC_CPU_P95_MS,
+    BENCH_METRIC_GPU_MS,
+    BENCH_METRIC_DRAWS,
+    BENCH_METRIC_TRIANGLES,
+    BENCH_METRIC_MEMORY_MB,
+    BENCH_METRIC_MESH_MB,
+    BENCH_METRIC_COUNT,
+} BenchMetric;
+
+// every metric is better when lower, differences below noise never count as a regression
+static struct {
+    char const *name;
+    double noise;
+} const bench_metrics[BENCH_METRIC_COUNT] = {
+    [BENCH_METRIC_CPU_MS] = {"cpu_ms", 0.05},
+    [BENCH_METRIC_CPU_P95_MS] = {"cpu_p95_ms", 0.1},
+    [BENCH_METRIC_GPU_MS] = {"gpu_ms", 0.05},
+    [BENCH_METRIC_DRAWS] = {"draws", 0.0},
+    [BENCH_METRIC_TRIANGLES] = {"triangles", 0.0},
+    [BENCH_METRIC_MEMORY_MB] = {"memory_mb", 0.0},
+    [BENCH_METRIC_MESH_MB] = {"mesh_mb", 0.0},
+};
+
+typedef struct {
+    NativeChar const *baseline_path;
+    NativeChar const *write_baseline_path;
+    uint32_t tolerance_percent;
+    // per scene, gpu times are NAN when the queue has no timestamps
+    double results[BENCH_SCENE_COUNT][BENCH_METRIC_COUNT];
+} Benchmark;
+
+void parse_benchmark_arguments(Benchmark *const bench, int const argc, NativeChar **const argv) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (!native_compare(argv[i], NATIVE_TEXT("--baseline")))
+            bench->baseline_path = argv[++i];
+        else if (!native_compare(argv[i], NATIVE_TEXT("--write-baseline")))
+            bench->write_baseline_path = argv[++i];
+        else if (!native_compare(argv[i], NATIVE_TEXT("--tolerance")))
+            bench->tolerance_percent = (uint32_t)native_to_ulong(argv[++i], nullptr, 10);
+    }
+}
+
+// uploads the scene and renders until it is settled, then measures headless_frame_count frames
+void measure_scene(App *const app, BenchScene const *const scene, double metrics[BENCH_METRIC_COUNT]) {
+    app->vkDeviceWaitIdle(app->device);
+    resolve_in_flight_frames(app);
+    load_world(app, scene->size, scene->generate);
+    while (!app->is_world_ready) render(app);
+    for (uint32_t i = 0; i < BENCH_WARMUP_FRAME_COUNT; ++i) render(app);
+
+    app->vkDeviceWaitIdle(app->device);
+    resolve_in_flight_frames(app);
+    app->frame_totals = (FrameTotals){};
+    profiler_free(&app->profiler);
+    profiler_init(&app->profiler);
+    for (uint32_t i = 0; i < app->headless_frame_count; ++i) {
+        if (scene->edit) scene->edit(app, i);
+        render(app);
+    }
+    app->vkDeviceWaitIdle(app->device);
+    resolve_in_flight_frames(app);
+
+    auto const stats = profiler_frame_time_stats(&app->profiler);
+    auto const totals = &app->frame_totals;
+    VkDeviceSize memory_used = 0;
+    for (uint32_t i = 0; i < app->memory_block_count; ++i) memory_used += app->memory_blocks[i].used;
+    auto const mesh_size = app->chunk_quad_count * (4 * sizeof(MeshVertex) + 6 * sizeof(uint32_t)) +
+                           app->chunk_count * CHUNK_SECTION_COUNT * sizeof(ChunkDrawInfo);
+    metrics[BENCH_METRIC_CPU_MS] = stats.p50_ms;
+    metrics[BENCH_METRIC_CPU_P95_MS] = stats.p95_ms;
+    metrics[BENCH_METRIC_GPU_MS] = totals->gpu_frame_count
+                                       ? (double)totals->gpu_time_ns / (double)totals->gpu_frame_count / 1e6
+                                       : NAN;
+    metrics[BENCH_METRIC_DRAWS] = (double)totals->draw_count / app->headless_frame_count;
+    metrics[BENCH_METRIC_TRIANGLES] = (double)totals->triangle_count / app->headless_frame_count;
+    metrics[BENCH_METRIC_MEMORY_MB] = (double)memory_used / (1024.0 * 1024.0);
+    metrics[BENCH_METRIC_MESH_MB] = (double)mesh_size / (1024.0 * 1024.0);
 }
 
+// the baseline is the json --write-baseline produces, only as much of json is understood as that needs
+// returns what follows the colon of the first "key" at or after json, nullptr when there is none
+char const *find_json_value(char const *const json, char const *const key) {
+    auto const key_length = strlen(key);
+    for (auto at = strstr(json, key); at; at = strstr(at + key_length, key)) {
+        if (at == json || at[-1] != '"' || at[key_length] != '"') continue;
+        auto value = at + key_length + 1;
+        while (*value == ' ' || *value == '\t' || *value == '\r' || *value == '\n') ++value;
+        if (*value++ != ':') continue;
+        while (*value == ' ' || *value == '\t' || *value == '\r' || *value == '\n') ++value;
+        return value;
+    }
+    return nullptr;
+}
+
+bool is_json_string(char const *const value, char const *const string) {
+    auto const length = strlen(string);
+    return value && *value == '"' && !strncmp(value + 1, string, length) && value[length + 1] == '"';
+}
+
+// NAN when the baseline has no such scene or metric
+double find_baseline_metric(char const *const json, char const *const scene, char const *const metric) {
+    for (auto name = find_json_value(json, "name"); name; name = find_json_value(name, "name")) {
+        if (!is_json_string(name, scene)) continue;
+        auto const value = find_json_value(name, metric);
+        char const *const end = strchr(name, '}');
+        if (!value || (end && value > end) || !strncmp(value, "null", 4)) return NAN;
+        return strtod(value, nullptr);
+    }
+    return NAN;
+}
+
+void write_baseline(App const *const app, Benchmark const *const bench) {
+    size_t const capacity = 1024 + BENCH_SCENE_COUNT * 512;
+    char *const json = malloc(capacity);
+    auto length = (size_t)snprintf(json, capacity, "{\n  \"device\": \"%s\",\n  \"width\": %u,\n  \"height\": %u,\n"
+                                   "  \"frames\": %u,\n  \"scenes\": [", app->physical_device_properties.deviceName,
+                                   app->headless_extent.width, app->headless_extent.height,
+                                   app->headless_frame_count);
+    for (uint32_t scene = 0; scene < BENCH_SCENE_COUNT; ++scene) {
+        length += (size_t)snprintf(json + length, capacity - length, "%s\n    {\"name\": \"%s\"", scene ? "," : "",
+                                   bench_scenes[scene].name);
+        for (uint32_t metric = 0; metric < BENCH_METRIC_COUNT; ++metric) {
+            auto const value = bench->results[scene][metric];
+            length += isnan(value)
+                          ? (size_t)snprintf(json + length, capacity - length, ", \"%s\": null",
+                                             bench_metrics[metric].name)
+                          : (size_t)snprintf(json + length, capacity - length, ", \"%s\": %.3f",
+                                             bench_metrics[metric].name, value);
+        }
+        length += (size_t)snprintf(json + length, capacity - length, "}");
+    }
+    length += (size_t)snprintf(json + length, capacity - length, "\n  ]\n}\n");
+    if (!save_file(bench->write_baseline_path, json, length))
+        fprintf(stderr, "Cannot write baseline\n");
+    free(json);
+}
+
+// returns the number of regressions, a metric regresses when it grew by more than the tolerance and the noise
+uint32_t compare_with_baseline(App const *const app, Benchmark const *const bench) {
+    void *data;
+    size_t size;
+    if (!load_file(bench->baseline_path, &data, &size)) fatal_error(app, L"Cannot read the baseline!");
+    char *const json = malloc(size + 1);
+    memcpy(json, data, size);
+    json[size] = '\0';
+    free_file(data);
+
+    if (!is_json_string(find_json_value(json, "device"), app->physical_device_properties.deviceName))
+        printf("the baseline was measured on another device, times are not comparable\n");
+    uint32_t regression_count = 0;
+    for (uint32_t scene = 0; scene < BENCH_SCENE_COUNT; ++scene)
+        for (uint32_t metric = 0; metric < BENCH_METRIC_COUNT; ++metric) {
+            auto const baseline = find_baseline_metric(json, bench_scenes[scene].name, bench_metrics[metric].name);
+            auto const value = bench->results[scene][metric];
+            if (isnan(baseline) || isnan(value)) continue;
+            auto const limit = baseline * (1.0 + bench->tolerance_percent / 100.0) + bench_metrics[metric].noise;
+            auto const change = baseline ? (value - baseline) / baseline * 100.0 : 0.0;
+            if (value > limit) {
+                printf("REGRESSION %s %s: %.3f against %.3f (%+.1f%%)\n", bench_scenes[scene].name,
+                       bench_metrics[metric].name, value, baseline, change);
+                ++regression_count;
+            } else if (value < baseline * (1.0 - bench->tolerance_percent / 100.0) - bench_metrics[metric].noise) {
+                printf("improved %s %s: %.3f against %.3f (%+.1f%%), consider updating the baseline\n",
+                       bench_scenes[scene].name, bench_metrics[metric].name, value, baseline, change);
+            }
+        }
+    free(json);
+    printf("%u regressions beyond %u%%\n", regression_count, bench->tolerance_percent);
+    return regression_count;
+}
+
+int run_benchmark(App *const app, Benchmark *const bench) {
+    configure_offscreen_images(app);
+    printf("%s, %ux%u, %u frames per scene\n", app->physical_device_properties.deviceName,
+           app->headless_extent.width, app->headless_extent.height, app->headless_frame_count);
+    for (uint32_t scene = 0; scene < BENCH_SCENE_COUNT; ++scene) {
+        auto const metrics = bench->results[scene];
+        measure_scene(app, &bench_scenes[scene], metrics);
+        printf("%-12s cpu p50 %.3f ms p95 %.3f ms, gpu %.3f ms, %.0f draws, %.0f triangles, %.1f MiB device memory, "
+               "%.1f MiB meshes\n", bench_scenes[scene].name, metrics[BENCH_METRIC_CPU_MS],
+               metrics[BENCH_METRIC_CPU_P95_MS], metrics[BENCH_METRIC_GPU_MS], metrics[BENCH_METRIC_DRAWS],
+               metrics[BENCH_METRIC_TRIANGLES], metrics[BENCH_METRIC_MEMORY_MB], metrics[BENCH_METRIC_MESH_MB]);
+    }
+
+    if (bench->write_baseline_path) write_baseline(app, bench);
+    return bench->baseline_path && compare_with_baseline(app, bench) ? 1 : 0;
+}
+
+#ifdef _WIN32
+int wmain(int const argc, wchar_t **const argv) {
+#else
+int main(int const argc, char **const argv) {
+#endif
+    App app = {
+        .window_title = L"Minimal Window",
+        .headless = true,
+        .headless_frame_count = DEFAULT_BENCH_FRAME_COUNT,
+        .headless_extent = DEFAULT_HEADLESS_EXTENT,
+        .in_flight_frame_count = DEFAULT_IN_FLIGHT_FRAMES,
+        .requested_present_mode = DEFAULT_PRESENT_MODE,
+#ifdef _WIN32
+        .process_heap = GetProcessHeap(),
+        .hinstance = GetModuleHandleW(nullptr),
+#endif
+    };
+    parse_arguments(&app, argc, argv);
+    // the profiler window holds the frames the percentiles come from
+    if (app.headless_frame_count < 1) app.headless_frame_count = 1;
+    if (app.headless_frame_count > PROFILER_FRAME_WINDOW) app.headless_frame_count = PROFILER_FRAME_WINDOW;
+    Benchmark bench = {.tolerance_percent = DEFAULT_BENCH_TOLERANCE_PERCENT};
+    parse_benchmark_arguments(&bench, argc, argv);
+
+    app.jobs = job_system_create(0);
+    profiler_init(&app.profiler);
+    start_renderer(&app);
+    int const result = run_benchmark(&app, &bench);
+    save_pipeline_cache(&app);
+    job_system_destroy(app.jobs);
+    close_world_regions(&app);
+    return result;
+}
+#elif defined(_WIN32)
 int WINAPI wWinMain(HINSTANCE const hInstance, HINSTANCE const, PWSTR const, int const nShowCmd) {
     App app = {
         .window_title = L"Minimal Window",
+        .headless_frame_count = DEFAULT_HEADLESS_FRAME_COUNT,
+        .headless_extent = DEFAULT_HEADLESS_EXTENT,
+        .in_flight_frame_count = DEFAULT_IN_FLIGHT_FRAMES,
+        .requested_present_mode = DEFAULT_PRESENT_MODE,
 
         .process_heap = GetProcessHeap(),
         .hinstance = hInstance,
     };
 
-    HRESULT const hr = CoInitialize(nullptr);
-    if (FAILED(hr)) return 1;
-
-    // load imaging component
-    if (FAILED(CoCreateInstance(&CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, &IID_IWICImagingFactory,
-        (void**)&app.imaging_factory)))
-        DebugBreak();
-
-    load_vulkan_library(&app);
-    create_instance(&app);
-    create_window(&app);
-    create_surface(&app);
-    pick_physical_device(&app);
-    create_device(&app);
-
-    create_descriptor_pool(&app);
-    create_descriptor_set_layout(&app);
-    create_descriptor_set(&app);
-    create_command_pool(&app);
-    create_buffers(&app);
-    create_renderpass(&app);
-    create_pipeline_layout(&app);
-    load_shaders(&app);
-    create_pipeline(&app);
-    unload_shaders(&app);
-
-    allocate_command_buffers(&app);
-    create_synchronization_objects(&app);
-
-    show_window(&app, nShowCmd);
-    load_vulkan_functions(&app);
-    return main_loop();
+    int argc;
+    wchar_t **const argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    parse_arguments(&app, argc, argv);
+    LocalFree(argv);
+    create_frame_timer(&app);
+
+    app.jobs = job_system_create(0);
+    profiler_init(&app.profiler);
+    start_renderer(&app);
+    load_world(&app, DEMO_WORLD_SIZE, generate_demo_chunk);
+
+    int result;
+    if (app.headless) {
+        result = run_headless(&app);
+    } else {
+        show_window(&app, nShowCmd);
+        result = (int)main_loop(&app);
+        app.vkDeviceWaitIdle(app.device);
+        report_profile(&app);
+    }
+    save_pipeline_cache(&app);
+    job_system_destroy(app.jobs);
+    close_world_regions(&app);
+    return result;
+}
+#else
+int main(int const argc, char **const argv) {
+    App app = {
+        .window_title = L"Minimal Window",
+        .headless = true,
+        .headless_frame_count = DEFAULT_HEADLESS_FRAME_COUNT,
+        .headless_extent = DEFAULT_HEADLESS_EXTENT,
+        .in_flight_frame_count = DEFAULT_IN_FLIGHT_FRAMES,
+        .requested_present_mode = DEFAULT_PRESENT_MODE,
+    };
+    parse_arguments(&app, argc, argv);
+
+    app.jobs = job_system_create(0);
+    profiler_init(&app.profiler);
+    start_renderer(&app);
+    load_world(&app, DEMO_WORLD_SIZE, generate_demo_chunk);
+    int const result = run_headless(&app);
+    save_pipeline_cache(&app);
+    job_system_destroy(app.jobs);
+    close_world_regions(&app);
+    return result;
 }
+#endif
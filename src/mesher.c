@@ -0,0 +1,401 @@
+#include "mesher.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "light.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MESHER_X86
+#include <immintrin.h>
+#endif
+
+constexpr uint32_t INITIAL_MESH_QUADS = 256;
+// occlusion in the low 2 bits, then sky and block light, for each corner of a face
+constexpr uint32_t CORNER_KEY_BITS = 10;
+constexpr uint8_t OPEN_SKY_LIGHT = LIGHT_MAX << LIGHT_SKY_SHIFT;
+
+void chunk_mesh_free(ChunkMesh *const mesh) {
+    free(mesh->vertices);
+    free(mesh->indices);
+    *mesh = (ChunkMesh){};
+}
+
+// voxel index steps along x, y and z in the padded arrays
+static int32_t const padded_strides[3] = {1, MESHER_PADDED_SIZE * MESHER_PADDED_SIZE, MESHER_PADDED_SIZE};
+
+static int32_t padded_voxel_index(int32_t const x, int32_t const y, int32_t const z) {
+    return x + 1 + (z + 1) * (int32_t)MESHER_PADDED_SIZE + (y + 1) * (int32_t)(MESHER_PADDED_SIZE * MESHER_PADDED_SIZE);
+}
+
+// the padded voxel at position p along axis, u and v run along the next two axes in cyclic order so u x v points along
+// +axis, each of them may be -1 or CHUNK_SIZE
+static int32_t axis_padded_index(uint32_t const axis, int32_t const p, int32_t const u, int32_t const v) {
+    int32_t coordinates[3];
+    coordinates[axis] = p;
+    coordinates[(axis + 1) % 3] = u;
+    coordinates[(axis + 2) % 3] = v;
+    return padded_voxel_index(coordinates[0], coordinates[1], coordinates[2]);
+}
+
+// narrow indices expand a byte at a time through a table of the blocks every byte value encodes,
+// indices are packed from the low bits up so on little endian targets byte order is voxel order
+static void unpack_narrow_indices(Chunk const *const chunk, BlockId *const blocks, uint32_t const bits) {
+    uint32_t const per_byte = 8 / bits;
+    BlockId table[256][8];
+    for (uint32_t byte = 0; byte < 256; ++byte)
+        for (uint32_t i = 0; i < per_byte; ++i) {
+            uint32_t const index = byte >> i * bits & ((1u << bits) - 1);
+            table[byte][i] = index < chunk->palette_count ? chunk->palette[index] : BLOCK_AIR;
+        }
+    auto const bytes = (uint8_t const*)chunk->indices;
+    for (uint32_t i = 0; i < CHUNK_VOLUME / per_byte; ++i)
+        memcpy(&blocks[i * per_byte], table[bytes[i]], per_byte * sizeof(BlockId));
+}
+
+static void unpack_blocks(Chunk const *const chunk, BlockId *const blocks) {
+    switch (chunk->bits_per_index) {
+        case 0:
+            for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) blocks[i] = chunk->palette[0];
+            break;
+        case 8:
+            for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) blocks[i] = chunk->palette[((uint8_t const*)chunk->indices)[i]];
+            break;
+        case 16:
+            for (uint32_t i = 0; i < CHUNK_VOLUME; ++i)
+                blocks[i] = chunk->palette[((uint16_t const*)chunk->indices)[i]];
+            break;
+        default: unpack_narrow_indices(chunk, blocks, chunk->bits_per_index); break;
+    }
+}
+
+// -1, 0 or 1 for a coordinate before, in or after the chunk
+static int32_t neighbor_offset(int32_t const coordinate) {
+    return coordinate < 0 ? -1 : coordinate >= (int32_t)CHUNK_SIZE ? 1 : 0;
+}
+
+static void load_shell_voxel(MesherScratch *const scratch, Chunk const *const *const neighbors, int32_t const x,
+                             int32_t const y, int32_t const z) {
+    auto const padded = padded_voxel_index(x, y, z);
+    auto const neighbor =
+        neighbors ? neighbors[chunk_neighbor_index(neighbor_offset(x), neighbor_offset(y), neighbor_offset(z))]
+                  : nullptr;
+    if (!neighbor) {
+        scratch->solid[padded] = false;
+        scratch->light[padded] = OPEN_SKY_LIGHT;
+        return;
+    }
+    auto const voxel = chunk_voxel_index((uint32_t)x & (CHUNK_SIZE - 1), (uint32_t)y & (CHUNK_SIZE - 1),
+                                         (uint32_t)z & (CHUNK_SIZE - 1));
+    scratch->solid[padded] = neighbor->palette[chunk_get_palette_index(neighbor, voxel)] != BLOCK_AIR;
+    scratch->light[padded] = neighbor->light ? neighbor->light[voxel] : OPEN_SKY_LIGHT;
+}
+
+// the unpacked blocks, their light and the voxels of the neighbors that touch the chunk, edges and corners included
+static void load_padded_voxels(MesherScratch *const scratch, Chunk const *const chunk,
+                               Chunk const *const *const neighbors) {
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+        for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+            auto const padded = padded_voxel_index(0, (int32_t)y, (int32_t)z);
+            auto const voxel = chunk_voxel_index(0, y, z);
+            for (uint32_t x = 0; x < CHUNK_SIZE; ++x)
+                scratch->solid[padded + (int32_t)x] = scratch->blocks[voxel + x] != BLOCK_AIR;
+            if (chunk->light) memcpy(&scratch->light[padded], &chunk->light[voxel], CHUNK_SIZE);
+            else memset(&scratch->light[padded], OPEN_SKY_LIGHT, CHUNK_SIZE);
+        }
+    for (int32_t y = -1; y <= (int32_t)CHUNK_SIZE; ++y)
+        for (int32_t z = -1; z <= (int32_t)CHUNK_SIZE; ++z) {
+            // rows through the chunk only have their two ends outside of it
+            bool const is_inner_row = (uint32_t)y < CHUNK_SIZE && (uint32_t)z < CHUNK_SIZE;
+            for (int32_t x = -1; x <= (int32_t)CHUNK_SIZE; x += is_inner_row && x < 0 ? (int32_t)CHUNK_SIZE + 1 : 1)
+                load_shell_voxel(scratch, neighbors, x, y, z);
+        }
+}
+
+// bit x is set when blocks[x] is not air
+static uint32_t solid_row_mask(BlockId const *const blocks) {
+#ifdef MESHER_X86
+    auto const air = _mm_set1_epi16((short)BLOCK_AIR);
+    uint32_t air_mask = 0;
+    for (uint32_t x = 0; x < CHUNK_SIZE; x += 16) {
+        auto const low = _mm_cmpeq_epi16(_mm_loadu_si128((__m128i const*)(blocks + x)), air);
+        auto const high = _mm_cmpeq_epi16(_mm_loadu_si128((__m128i const*)(blocks + x + 8)), air);
+        air_mask |= (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(low, high)) << x;
+    }
+    return ~air_mask;
+#else
+    uint32_t row = 0;
+    for (uint32_t x = 0; x < CHUNK_SIZE; ++x) row |= (uint32_t)(blocks[x] != BLOCK_AIR) << x;
+    return row;
+#endif
+}
+
+// bit j of word i moves to bit i of word j, by swapping ever smaller off diagonal blocks
+static void transpose_bits(uint32_t matrix[CHUNK_SIZE]) {
+    uint32_t mask = 0x0000FFFF;
+    for (uint32_t width = 16; width; width >>= 1, mask ^= mask << width)
+        for (uint32_t k = 0; k < CHUNK_SIZE; k = (k + width + 1) & ~width) {
+            uint32_t const swapped = ((matrix[k] >> width) ^ matrix[k + width]) & mask;
+            matrix[k] ^= swapped << width;
+            matrix[k + width] ^= swapped;
+        }
+}
+
+static void build_columns(MesherScratch *const scratch) {
+    // x rows are already x columns, the y and z columns are the same bits transposed one plane at a time
+    uint32_t rows[CHUNK_SIZE][CHUNK_SIZE];
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+        for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+            uint32_t const row = solid_row_mask(&scratch->blocks[chunk_voxel_index(0, y, z)]);
+            rows[y][z] = row;
+            scratch->columns[0][z][y] = (uint64_t)row << 1;
+        }
+
+    uint32_t plane[CHUNK_SIZE];
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y) {
+        memcpy(plane, rows[y], sizeof(plane));
+        transpose_bits(plane);
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x) scratch->columns[2][y][x] = (uint64_t)plane[x] << 1;
+    }
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z) {
+        for (uint32_t y = 0; y < CHUNK_SIZE; ++y) plane[y] = rows[y][z];
+        transpose_bits(plane);
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x) scratch->columns[1][x][z] = (uint64_t)plane[x] << 1;
+    }
+
+    // the end bits come from the padding
+    for (uint32_t axis = 0; axis < 3; ++axis)
+        for (int32_t v = 0; v < (int32_t)CHUNK_SIZE; ++v)
+            for (int32_t u = 0; u < (int32_t)CHUNK_SIZE; ++u)
+                scratch->columns[axis][v][u] |=
+                    (uint64_t)scratch->solid[axis_padded_index(axis, -1, u, v)] |
+                    (uint64_t)scratch->solid[axis_padded_index(axis, CHUNK_SIZE, u, v)] << (CHUNK_SIZE + 1);
+}
+
+// the corners of a face, corner i lies on the +u side when bit 0 of i is set and on the +v side when bit 1 is
+// each takes its occlusion from the two voxels beside it and the one diagonal to it in the layer in front of the face,
+// and the average light of the ones of those and the voxel in front that light can reach
+static uint64_t compute_face_key(MesherScratch const *const scratch, uint32_t const face, int32_t const front) {
+    uint32_t const axis = face / 2;
+    int32_t const u_stride = padded_strides[(axis + 1) % 3], v_stride = padded_strides[(axis + 2) % 3];
+    uint64_t key = 0;
+    for (uint32_t corner = 0; corner < 4; ++corner) {
+        auto const u_side = front + (corner & 1 ? u_stride : -u_stride);
+        auto const v_side = front + (corner & 2 ? v_stride : -v_stride);
+        int32_t const samples[3] = {u_side, v_side, u_side + v_side - front};
+        bool const solid[3] = {scratch->solid[samples[0]], scratch->solid[samples[1]], scratch->solid[samples[2]]};
+        // the diagonal voxel is hidden behind two solid sides
+        bool const is_closed = solid[0] && solid[1];
+        uint32_t const occlusion = is_closed ? 3 : solid[0] + solid[1] + solid[2];
+
+        uint32_t sky = scratch->light[front] >> LIGHT_SKY_SHIFT, block = scratch->light[front] & LIGHT_BLOCK_MASK;
+        uint32_t count = 1;
+        for (uint32_t i = 0; i < (is_closed ? 2u : 3u); ++i) {
+            if (solid[i]) continue;
+            sky += scratch->light[samples[i]] >> LIGHT_SKY_SHIFT;
+            block += scratch->light[samples[i]] & LIGHT_BLOCK_MASK;
+            ++count;
+        }
+        uint64_t const corner_key = occlusion | (sky + count / 2) / count << 2 | (block + count / 2) / count << 6;
+        key |= corner_key << corner * CORNER_KEY_BITS;
+    }
+    return key;
+}
+
+static void emit_quad(ChunkMesh *const mesh, uint32_t const face, uint32_t const p, uint32_t const u, uint32_t const v,
+                      uint32_t const width, uint32_t const height, BlockId const block, uint64_t const key) {
+    if (mesh->vertex_count + 4 > mesh->vertex_capacity) {
+        mesh->vertex_capacity = mesh->vertex_capacity ? mesh->vertex_capacity * 2 : INITIAL_MESH_QUADS * 4;
+        mesh->index_capacity = mesh->vertex_capacity / 4 * 6;
+        mesh->vertices = realloc(mesh->vertices, mesh->vertex_capacity * sizeof(MeshVertex));
+        mesh->indices = realloc(mesh->indices, mesh->index_capacity * sizeof(uint32_t));
+    }
+
+    uint32_t const axis = face / 2, u_axis = (axis + 1) % 3, v_axis = (axis + 2) % 3;
+    // corners 1 and 2 trade places on negative faces so both sides wind counter clockwise seen from outside
+    bool const is_positive = face & 1;
+    uint32_t corners[4][3];
+    for (uint32_t i = 0; i < 4; ++i) {
+        corners[i][axis] = p + is_positive;
+        corners[i][u_axis] = u;
+        corners[i][v_axis] = v;
+    }
+    corners[is_positive ? 1 : 2][u_axis] += width;
+    corners[is_positive ? 2 : 1][v_axis] += height;
+    corners[3][u_axis] += width;
+    corners[3][v_axis] += height;
+
+    // blocks map straight to texture layers until there is a block registry
+    uint32_t const layer = block % MESH_VERTEX_MAX_LAYERS;
+    auto const vertices = &mesh->vertices[mesh->vertex_count];
+    uint32_t occlusion[4];
+    for (uint32_t i = 0; i < 4; ++i) {
+        // vertex i sits at face corner i, or the other middle corner once 1 and 2 traded places
+        uint32_t const corner = is_positive || i == 0 || i == 3 ? i : 3 - i;
+        auto const corner_key = (uint32_t)(key >> corner * CORNER_KEY_BITS);
+        occlusion[i] = corner_key & 3;
+        vertices[i] = pack_mesh_vertex(corners[i][0], corners[i][1], corners[i][2], face, occlusion[i], layer,
+                                       corner_key >> 2 & LIGHT_BLOCK_MASK, corner_key >> 6 & LIGHT_BLOCK_MASK);
+    }
+
+    // the diagonal runs between the two darker corners, so occlusion fades evenly instead of along one triangle
+    uint32_t const base = mesh->vertex_count;
+    bool const is_flipped = occlusion[0] + occlusion[3] < occlusion[1] + occlusion[2];
+    uint32_t const order[2][6] = {{0, 1, 2, 2, 1, 3}, {0, 1, 3, 0, 3, 2}};
+    auto const indices = &mesh->indices[mesh->index_count];
+    for (uint32_t i = 0; i < 6; ++i) indices[i] = base + order[is_flipped][i];
+    mesh->vertex_count += 4;
+    mesh->index_count += 6;
+}
+
+// voxel index steps along x, y and z
+static uint32_t const axis_strides[3] = {1, CHUNK_SIZE * CHUNK_SIZE, CHUNK_SIZE};
+
+// takes the lowest face left in a row, widens it along u over the run of set bits while the block and the corners
+// match, then grows it along v while the next row holds the same run of the same block with the same corners
+// only the faces in u_mask and in the rows from v_begin to v_end are merged, so quads stay inside those bounds
+static void merge_slice(MesherScratch *const scratch, uint32_t const face, uint32_t const p, bool const is_single_block,
+                        uint32_t const u_mask, uint32_t const v_begin, uint32_t const v_end, ChunkMesh *const mesh) {
+    uint32_t const axis = face / 2;
+    uint32_t const u_stride = axis_strides[(axis + 1) % 3], v_stride = axis_strides[(axis + 2) % 3];
+    auto const rows = scratch->face_rows[p];
+    auto const slice = &scratch->blocks[p * axis_strides[axis]];
+    auto const keys = scratch->face_keys;
+    int32_t const front_step = face & 1 ? padded_strides[axis] : -padded_strides[axis];
+    for (uint32_t v = v_begin; v < v_end; ++v)
+        for (auto remaining = rows[v] & u_mask; remaining; remaining &= remaining - 1) {
+            auto const u = (uint32_t)__builtin_ctz(remaining);
+            keys[v][u] = compute_face_key(
+                scratch, face, axis_padded_index(axis, (int32_t)p, (int32_t)u, (int32_t)v) + front_step);
+        }
+
+    for (uint32_t v = v_begin; v < v_end; ++v)
+        while (rows[v] & u_mask) {
+            uint32_t const u = (uint32_t)__builtin_ctz(rows[v] & u_mask);
+            auto const first = &slice[u * u_stride + v * v_stride];
+            BlockId const block = *first;
+            uint64_t const key = keys[v][u];
+
+            uint32_t const run = (rows[v] & u_mask) >> u;
+            uint32_t width = run == UINT32_MAX ? CHUNK_SIZE : (uint32_t)__builtin_ctz(~run);
+            for (uint32_t i = 1; i < width; ++i)
+                if (keys[v][u + i] != key || (!is_single_block && first[i * u_stride] != block)) {
+                    width = i;
+                    break;
+                }
+            uint32_t const mask = (width == CHUNK_SIZE ? UINT32_MAX : (1u << width) - 1) << u;
+
+            uint32_t height = 1;
+            for (; v + height < v_end && (rows[v + height] & mask) == mask; ++height) {
+                auto const row = &first[height * v_stride];
+                auto const row_keys = &keys[v + height][u];
+                uint32_t i = 0;
+                while (i < width && row_keys[i] == key && (is_single_block || row[i * u_stride] == block)) ++i;
+                if (i < width) break;
+            }
+            for (uint32_t i = 0; i < height; ++i) rows[v + i] &= ~mask;
+            emit_quad(mesh, face, p, u, v, width, height, block, key);
+        }
+}
+
+static bool has_single_solid_block(Chunk const *const chunk) {
+    uint32_t solid_count = 0;
+    for (uint32_t i = 0; i < chunk->palette_count; ++i) solid_count += chunk->palette[i] != BLOCK_AIR;
+    return solid_count <= 1;
+}
+
+// fills the face rows of every slice with the visible faces in the face direction, returns the slices that have any
+static uint32_t find_visible_faces(MesherScratch *const scratch, uint32_t const face) {
+    uint32_t const axis = face / 2;
+    memset(scratch->face_rows, 0, sizeof(scratch->face_rows));
+    uint32_t occupied_slices = 0;
+    for (uint32_t v = 0; v < CHUNK_SIZE; ++v)
+        for (uint32_t u = 0; u < CHUNK_SIZE; ++u) {
+            // a solid voxel shows a face where the next voxel in the face direction is not solid
+            uint64_t const column = scratch->columns[axis][v][u];
+            uint64_t const visible = face & 1 ? column & ~(column >> 1) : column & ~(column << 1);
+            auto const faces = (uint32_t)(visible >> 1);
+            occupied_slices |= faces;
+            for (uint32_t remaining = faces; remaining; remaining &= remaining - 1)
+                scratch->face_rows[__builtin_ctz(remaining)][v] |= 1u << u;
+        }
+    return occupied_slices;
+}
+
+static bool is_empty_chunk(Chunk const *const chunk) {
+    return !chunk->bits_per_index && chunk->palette[0] == BLOCK_AIR;
+}
+
+void mesh_chunk(MesherScratch *const scratch, Chunk const *const chunk,
+                Chunk const *const neighbors[CHUNK_NEIGHBOR_COUNT], ChunkMesh *const mesh) {
+    mesh->vertex_count = 0;
+    mesh->index_count = 0;
+    if (is_empty_chunk(chunk)) return;
+
+    unpack_blocks(chunk, scratch->blocks);
+    load_padded_voxels(scratch, chunk, neighbors);
+    build_columns(scratch);
+    bool const is_single_block = has_single_solid_block(chunk);
+
+    for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face)
+        for (auto occupied_slices = find_visible_faces(scratch, face); occupied_slices;
+             occupied_slices &= occupied_slices - 1)
+            merge_slice(scratch, face, (uint32_t)__builtin_ctz(occupied_slices), is_single_block, UINT32_MAX, 0,
+                        CHUNK_SIZE, mesh);
+}
+
+// y is the u axis of x faces, the slice of y faces and the v axis of z faces, so a section is a band of u bits, a run
+// of slices or a run of rows depending on the face
+void mesh_chunk_sections(MesherScratch *const scratch, Chunk const *const chunk,
+                         Chunk const *const neighbors[CHUNK_NEIGHBOR_COUNT], uint32_t const sections,
+                         ChunkMesh meshes[CHUNK_SECTION_COUNT]) {
+    for (uint32_t remaining = sections; remaining; remaining &= remaining - 1) {
+        auto const mesh = &meshes[__builtin_ctz(remaining)];
+        mesh->vertex_count = 0;
+        mesh->index_count = 0;
+    }
+    if (!sections || is_empty_chunk(chunk)) return;
+
+    unpack_blocks(chunk, scratch->blocks);
+    load_padded_voxels(scratch, chunk, neighbors);
+    build_columns(scratch);
+    bool const is_single_block = has_single_solid_block(chunk);
+
+    for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+        uint32_t const axis = face / 2;
+        auto const occupied_slices = find_visible_faces(scratch, face);
+        for (uint32_t remaining = sections; remaining; remaining &= remaining - 1) {
+            auto const section = (uint32_t)__builtin_ctz(remaining);
+            uint32_t const first_y = section * CHUNK_SECTION_SIZE;
+            uint32_t const section_bits = ((1u << CHUNK_SECTION_SIZE) - 1) << first_y;
+            for (auto slices = axis == 1 ? occupied_slices & section_bits : occupied_slices; slices;
+                 slices &= slices - 1)
+                merge_slice(scratch, face, (uint32_t)__builtin_ctz(slices), is_single_block,
+                            axis == 0 ? section_bits : UINT32_MAX, axis == 2 ? first_y : 0,
+                            axis == 2 ? first_y + CHUNK_SECTION_SIZE : CHUNK_SIZE, &meshes[section]);
+        }
+    }
+}
+
+void mesh_chunk_naive(MesherScratch *const scratch, Chunk const *const chunk,
+                      Chunk const *const neighbors[CHUNK_NEIGHBOR_COUNT], ChunkMesh *const mesh) {
+    mesh->vertex_count = 0;
+    mesh->index_count = 0;
+    unpack_blocks(chunk, scratch->blocks);
+    load_padded_voxels(scratch, chunk, neighbors);
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+        for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+            for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+                BlockId const block = scratch->blocks[chunk_voxel_index(x, y, z)];
+                if (block == BLOCK_AIR) continue;
+                uint32_t const coordinates[3] = {x, y, z};
+                for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+                    uint32_t const axis = face / 2;
+                    auto const front = padded_voxel_index((int32_t)x, (int32_t)y, (int32_t)z) +
+                                       (face & 1 ? padded_strides[axis] : -padded_strides[axis]);
+                    if (scratch->solid[front]) continue;
+                    emit_quad(mesh, face, coordinates[axis], coordinates[(axis + 1) % 3], coordinates[(axis + 2) % 3],
+                              1, 1, block, compute_face_key(scratch, face, front));
+                }
+            }
+}
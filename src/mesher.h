@@ -0,0 +1,92 @@
+#pragma once
+
+#include "chunk.h"
+
+// chunk meshing, every visible voxel face becomes part of a quad
+// visibility comes from 64 bit occupancy columns along each axis, one bit per voxel plus the neighbor voxel on
+// either end, so a whole column of faces is found with a shift, a not and an and
+// coplanar faces of the same block are then merged into rectangles row by row with bit scans
+// every face also gets the ambient occlusion and the smooth light of its 4 corners from the voxels in front of it, and
+// only faces whose corners match merge, so the corners of a merged quad carry exactly what its faces would
+
+enum {
+    CHUNK_FACE_NEGATIVE_X,
+    CHUNK_FACE_POSITIVE_X,
+    CHUNK_FACE_NEGATIVE_Y,
+    CHUNK_FACE_POSITIVE_Y,
+    CHUNK_FACE_NEGATIVE_Z,
+    CHUNK_FACE_POSITIVE_Z,
+    CHUNK_FACE_COUNT,
+};
+
+// a quad corner packed into 64 bits that the vertex shader pulls through the buffer address
+// bits 0 to 17 hold the chunk local corner, 6 bits per axis since corners run from 0 to CHUNK_SIZE inclusive,
+// then 3 bits of face direction, 2 bits of ambient occlusion and 9 bits of texture layer
+// the high word holds the sky and the block light of the corner, 4 bits each
+// the chunk origin comes with the draw
+typedef uint64_t MeshVertex;
+
+constexpr uint32_t MESH_VERTEX_POSITION_BITS = 6;
+constexpr uint32_t MESH_VERTEX_FACE_SHIFT = 18;
+constexpr uint32_t MESH_VERTEX_OCCLUSION_SHIFT = 21;
+constexpr uint32_t MESH_VERTEX_LAYER_SHIFT = 23;
+constexpr uint32_t MESH_VERTEX_MAX_LAYERS = 512;
+constexpr uint32_t MESH_VERTEX_SKY_LIGHT_SHIFT = 32;
+constexpr uint32_t MESH_VERTEX_BLOCK_LIGHT_SHIFT = 36;
+
+// occlusion is 0 for an open corner up to 3 for a corner between three solid voxels, light runs from 0 to LIGHT_MAX
+static inline MeshVertex pack_mesh_vertex(uint32_t const x, uint32_t const y, uint32_t const z, uint32_t const face,
+                                          uint32_t const occlusion, uint32_t const layer, uint32_t const sky_light,
+                                          uint32_t const block_light) {
+    return (x | y << MESH_VERTEX_POSITION_BITS | z << MESH_VERTEX_POSITION_BITS * 2 | face << MESH_VERTEX_FACE_SHIFT |
+            occlusion << MESH_VERTEX_OCCLUSION_SHIFT | layer << MESH_VERTEX_LAYER_SHIFT) |
+           (uint64_t)sky_light << MESH_VERTEX_SKY_LIGHT_SHIFT | (uint64_t)block_light << MESH_VERTEX_BLOCK_LIGHT_SHIFT;
+}
+
+// chunks are also meshed in CHUNK_SECTION_COUNT sections stacked along y, a section mesh only holds the faces of its
+// own voxels and its quads never reach into another section, so an edit only remeshes the sections it touches
+constexpr uint32_t CHUNK_SECTION_SIZE_LOG2 = 3;
+constexpr uint32_t CHUNK_SECTION_SIZE = 1u << CHUNK_SECTION_SIZE_LOG2;
+constexpr uint32_t CHUNK_SECTION_COUNT = CHUNK_SIZE / CHUNK_SECTION_SIZE;
+// bit s stands for section s
+constexpr uint32_t CHUNK_ALL_SECTIONS = (1u << CHUNK_SECTION_COUNT) - 1;
+
+// every quad is 4 vertices and 6 indices relative to the first vertex of the mesh
+typedef struct {
+    uint32_t vertex_count;
+    uint32_t vertex_capacity;
+    uint32_t index_count;
+    uint32_t index_capacity;
+    MeshVertex *vertices;
+    uint32_t *indices;
+} ChunkMesh;
+
+// the chunk with one voxel of its neighbors all around
+constexpr uint32_t MESHER_PADDED_SIZE = CHUNK_SIZE + 2;
+constexpr uint32_t MESHER_PADDED_VOLUME = MESHER_PADDED_SIZE * MESHER_PADDED_SIZE * MESHER_PADDED_SIZE;
+
+// per thread working memory, large enough that it should not live on the stack
+typedef struct {
+    BlockId blocks[CHUNK_VOLUME];
+    // padded like MESHER_PADDED_SIZE in voxel order, whether a voxel is solid and its light as Chunk.light holds it
+    uint8_t solid[MESHER_PADDED_VOLUME];
+    uint8_t light[MESHER_PADDED_VOLUME];
+    // [axis][v][u], bit p + 1 is the voxel at position p along the axis, bits 0 and 33 come from the neighbors
+    uint64_t columns[3][CHUNK_SIZE][CHUNK_SIZE];
+    // [slice][v], bit u is a visible face
+    uint32_t face_rows[CHUNK_SIZE][CHUNK_SIZE];
+    // [v][u], the corner occlusion and light of the visible faces of the slice being merged
+    uint64_t face_keys[CHUNK_SIZE][CHUNK_SIZE];
+} MesherScratch;
+
+// neighbors come from world_get_neighbors and may be null, a missing neighbor counts as air under open sky
+// both replace the contents of mesh, the naive mesher emits one quad per visible face and serves as a reference
+void mesh_chunk(MesherScratch *scratch, Chunk const *chunk, Chunk const *const neighbors[CHUNK_NEIGHBOR_COUNT],
+                ChunkMesh *mesh);
+void mesh_chunk_naive(MesherScratch *scratch, Chunk const *chunk, Chunk const *const neighbors[CHUNK_NEIGHBOR_COUNT],
+                      ChunkMesh *mesh);
+// replaces the meshes of the sections set in the sections mask and leaves the others alone
+void mesh_chunk_sections(MesherScratch *scratch, Chunk const *chunk,
+                         Chunk const *const neighbors[CHUNK_NEIGHBOR_COUNT], uint32_t sections,
+                         ChunkMesh meshes[CHUNK_SECTION_COUNT]);
+void chunk_mesh_free(ChunkMesh *mesh);
@@ -0,0 +1,108 @@
+#include "pack.h"
+
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static bool map_pack(Pack *const pack, PackPathChar const *const path) {
+    pack->file = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+    if (pack->file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(pack->file, &size) || !size.QuadPart) return false;
+    pack->size = (size_t)size.QuadPart;
+    pack->mapping = CreateFileMappingW(pack->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!pack->mapping) return false;
+    pack->data = MapViewOfFile(pack->mapping, FILE_MAP_READ, 0, 0, 0);
+    return pack->data;
+}
+
+static void unmap_pack(Pack const *const pack) {
+    if (pack->data) UnmapViewOfFile(pack->data);
+    if (pack->mapping) CloseHandle(pack->mapping);
+    if (pack->file && pack->file != INVALID_HANDLE_VALUE) CloseHandle(pack->file);
+}
+#else
+static bool map_pack(Pack *const pack, PackPathChar const *const path) {
+    pack->file = open(path, O_RDONLY);
+    if (pack->file < 0) return false;
+    struct stat status;
+    if (fstat(pack->file, &status) || !status.st_size) return false;
+    pack->size = (size_t)status.st_size;
+    void *const data = mmap(nullptr, pack->size, PROT_READ, MAP_SHARED, pack->file, 0);
+    pack->data = data == MAP_FAILED ? nullptr : data;
+    return pack->data;
+}
+
+static void unmap_pack(Pack const *const pack) {
+    if (pack->data) munmap((void *)pack->data, pack->size);
+    if (pack->file >= 0) close(pack->file);
+}
+#endif
+
+static bool is_entry_valid(Pack const *const pack, PackEntry const *const entry) {
+    if (!memchr(entry->name, 0, PACK_NAME_LENGTH) || entry->type > PACK_ENTRY_BLOB ||
+        entry->offset % PACK_ALIGNMENT || entry->offset > pack->size || entry->size > pack->size - entry->offset)
+        return false;
+    if (entry->type != PACK_ENTRY_TEXTURE) return entry->type != PACK_ENTRY_SHADER || entry->size % 4 == 0;
+
+    if (!entry->level_count || entry->level_count > KTX2_MAX_LEVELS || !entry->width || !entry->height) return false;
+    for (uint32_t i = 0; i < entry->level_count; ++i) {
+        auto const level = &entry->levels[i];
+        if (level->offset % PACK_LEVEL_ALIGNMENT || level->offset > entry->size ||
+            level->size > entry->size - level->offset ||
+            level->size != ktx2_level_size((VkFormat)entry->format, entry->width, entry->height, i))
+            return false;
+    }
+    return true;
+}
+
+static void reset_pack(Pack *const pack) {
+#ifdef _WIN32
+    *pack = (Pack){};
+#else
+    *pack = (Pack){.file = -1};
+#endif
+}
+
+bool pack_open(Pack *const pack, PackPathChar const *const path) {
+    reset_pack(pack);
+    PackHeader header;
+    if (!map_pack(pack, path) || pack->size < sizeof(header)) {
+        pack_close(pack);
+        return false;
+    }
+    memcpy(&header, pack->data, sizeof(header));
+    if (header.magic != PACK_MAGIC || header.version != PACK_VERSION ||
+        header.entry_count > (pack->size - sizeof(header)) / sizeof(PackEntry)) {
+        pack_close(pack);
+        return false;
+    }
+    pack->entry_count = header.entry_count;
+    pack->entries = (PackEntry const *)(pack->data + sizeof(header));
+    for (uint32_t i = 0; i < pack->entry_count; ++i)
+        if (!is_entry_valid(pack, &pack->entries[i])) {
+            pack_close(pack);
+            return false;
+        }
+    return true;
+}
+
+void pack_close(Pack *const pack) {
+    unmap_pack(pack);
+    reset_pack(pack);
+}
+
+PackEntry const *pack_find(Pack const *const pack, PackEntryType const type, char const *const name) {
+    for (uint32_t i = 0; i < pack->entry_count; ++i)
+        if (pack->entries[i].type == type && !strcmp(pack->entries[i].name, name)) return &pack->entries[i];
+    return nullptr;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <wchar.h>
+#endif
+
+#include "ktx2.h"
+
+// asset packs, every startup asset in one file that is mapped read only and used in place
+// a header with the entry count is followed by the entry table, then by the data of every entry at PACK_ALIGNMENT
+// spir-v is stored as the words vkCreateShaderModule takes, textures as their levels in the final gpu format, each
+// level at a multiple of 16 from the start of the entry, the layout of the staging copy, so the levels are copied
+// out of the mapping as they are
+// written by codoxel_asset_packer
+
+constexpr uint32_t PACK_MAGIC = 0x50584443; // "CDXP"
+constexpr uint32_t PACK_VERSION = 1;
+constexpr uint32_t PACK_NAME_LENGTH = 32;
+constexpr uint32_t PACK_ALIGNMENT = 64;
+constexpr uint32_t PACK_LEVEL_ALIGNMENT = 16;
+
+typedef enum {
+    PACK_ENTRY_SHADER,
+    PACK_ENTRY_TEXTURE,
+    // anything else the engine reads whole, like json
+    PACK_ENTRY_BLOB,
+} PackEntryType;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t reserved;
+} PackHeader;
+
+typedef struct {
+    // the file name without directory and extension, zero terminated
+    char name[PACK_NAME_LENGTH];
+    // a PackEntryType
+    uint32_t type;
+    // textures only, a VkFormat
+    uint32_t format;
+    uint32_t width, height;
+    // the levels stored, 1 leaves the mips to the loader
+    uint32_t level_count;
+    uint32_t reserved;
+    // from the start of the file
+    uint64_t offset, size;
+    // offsets from the start of the entry
+    Ktx2Level levels[KTX2_MAX_LEVELS];
+} PackEntry;
+
+#ifdef _WIN32
+typedef wchar_t PackPathChar;
+#else
+typedef char PackPathChar;
+#endif
+
+typedef struct {
+#ifdef _WIN32
+    void *file;
+    void *mapping;
+#else
+    int file;
+#endif
+    uint8_t const *data;
+    size_t size;
+    uint32_t entry_count;
+    PackEntry const *entries;
+} Pack;
+
+// maps the pack and checks the table, every entry lies in the file and every level in its entry afterwards
+bool pack_open(Pack *pack, PackPathChar const *path);
+void pack_close(Pack *pack);
+// nullptr when the pack has no entry of that type and name
+PackEntry const *pack_find(Pack const *pack, PackEntryType type, char const *name);
+
+static inline void const *pack_entry_data(Pack const *const pack, PackEntry const *const entry) {
+    return pack->data + entry->offset;
+}
@@ -0,0 +1,679 @@
+#include "png.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PNG_X86
+#include <immintrin.h>
+#endif
+
+// one decode = one IDAT concatenation + one inflate into the filtered rows + unfilter in place + convert
+
+constexpr uint32_t FAST_BITS = 10;
+constexpr uint32_t FAST_MASK = (1u << FAST_BITS) - 1;
+constexpr uint32_t MAX_IMAGE_DIMENSION = 1u << 24;
+
+enum {
+    COLOR_TYPE_GRAY = 0,
+    COLOR_TYPE_RGB = 2,
+    COLOR_TYPE_PALETTE = 3,
+    COLOR_TYPE_GRAY_ALPHA = 4,
+    COLOR_TYPE_RGBA = 6,
+};
+
+enum {
+    FILTER_NONE = 0,
+    FILTER_SUB = 1,
+    FILTER_UP = 2,
+    FILTER_AVERAGE = 3,
+    FILTER_PAETH = 4,
+};
+
+static uint32_t read_be32(uint8_t const *bytes) {
+    return (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
+}
+
+static uint32_t channel_count(uint8_t const color_type) {
+    switch (color_type) {
+        case COLOR_TYPE_GRAY: return 1;
+        case COLOR_TYPE_RGB: return 3;
+        case COLOR_TYPE_PALETTE: return 1;
+        case COLOR_TYPE_GRAY_ALPHA: return 2;
+        case COLOR_TYPE_RGBA: return 4;
+        default: return 0;
+    }
+}
+
+static bool is_valid_bit_depth(uint8_t const color_type, uint8_t const bit_depth) {
+    switch (color_type) {
+        case COLOR_TYPE_GRAY:
+            return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8 || bit_depth == 16;
+        case COLOR_TYPE_PALETTE: return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8;
+        case COLOR_TYPE_RGB:
+        case COLOR_TYPE_GRAY_ALPHA:
+        case COLOR_TYPE_RGBA: return bit_depth == 8 || bit_depth == 16;
+        default: return false;
+    }
+}
+
+bool png_read_info(void const *const data, size_t const size, PngInfo *const info) {
+    static uint8_t const signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    auto const bytes = (uint8_t const*)data;
+    if (size < 33 || memcmp(bytes, signature, sizeof(signature)) || memcmp(bytes + 12, "IHDR", 4)) return false;
+
+    *info = (PngInfo){
+        .width = read_be32(bytes + 16),
+        .height = read_be32(bytes + 20),
+        .bit_depth = bytes[24],
+        .color_type = bytes[25],
+        .interlace_method = bytes[28],
+    };
+    return info->width && info->height && info->width <= MAX_IMAGE_DIMENSION &&
+           info->height <= MAX_IMAGE_DIMENSION && is_valid_bit_depth(info->color_type, info->bit_depth) &&
+           bytes[26] == 0 && bytes[27] == 0 && info->interlace_method <= 1;
+}
+
+// inflate
+
+typedef struct {
+    uint8_t const *data;
+    size_t size;
+    size_t position;
+    uint64_t bits;
+    uint32_t bit_count;
+    // zero bytes shifted in past the end, a stream that consumes them is truncated
+    uint32_t overrun;
+} BitReader;
+
+static void refill(BitReader *const reader) {
+    while (reader->bit_count <= 56) {
+        if (reader->position < reader->size) {
+            reader->bits |= (uint64_t)reader->data[reader->position++] << reader->bit_count;
+        } else {
+            ++reader->overrun;
+        }
+        reader->bit_count += 8;
+    }
+}
+
+static uint32_t get_bits(BitReader *const reader, uint32_t const count) {
+    if (reader->bit_count < count) refill(reader);
+    auto const value = (uint32_t)(reader->bits & ((1ull << count) - 1));
+    reader->bits >>= count;
+    reader->bit_count -= count;
+    return value;
+}
+
+static bool is_overrun(BitReader const *const reader) { return reader->overrun * 8 > reader->bit_count; }
+
+typedef struct {
+    // symbol << 4 | length for codes up to FAST_BITS long, 0 means take the slow path
+    uint16_t fast[1 << FAST_BITS];
+    uint16_t first_code[16];
+    uint16_t first_symbol[16];
+    // left aligned to 16 bits, exclusive
+    uint32_t max_code[17];
+    uint16_t symbols[288];
+} Huffman;
+
+static uint32_t reverse_bits(uint32_t value, uint32_t const count) {
+    value = (value & 0xAAAA) >> 1 | (value & 0x5555) << 1;
+    value = (value & 0xCCCC) >> 2 | (value & 0x3333) << 2;
+    value = (value & 0xF0F0) >> 4 | (value & 0x0F0F) << 4;
+    value = (value & 0xFF00) >> 8 | (value & 0x00FF) << 8;
+    return value >> (16 - count);
+}
+
+static bool build_huffman(Huffman *const huffman, uint8_t const *lengths, uint32_t const count) {
+    uint32_t length_counts[16] = {};
+    for (uint32_t i = 0; i < count; ++i) ++length_counts[lengths[i]];
+    length_counts[0] = 0;
+    memset(huffman->fast, 0, sizeof(huffman->fast));
+
+    uint32_t next_code[16];
+    uint32_t code = 0, symbol = 0;
+    for (uint32_t length = 1; length < 16; ++length) {
+        next_code[length] = code;
+        huffman->first_code[length] = (uint16_t)code;
+        huffman->first_symbol[length] = (uint16_t)symbol;
+        code += length_counts[length];
+        if (length_counts[length] && code > 1u << length) return false;
+        huffman->max_code[length] = code << (16 - length);
+        code <<= 1;
+        symbol += length_counts[length];
+    }
+    huffman->max_code[16] = 0x10000;
+
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t const length = lengths[i];
+        if (!length) continue;
+        uint32_t const index = next_code[length] - huffman->first_code[length] + huffman->first_symbol[length];
+        huffman->symbols[index] = (uint16_t)i;
+        if (length <= FAST_BITS)
+            for (uint32_t j = reverse_bits(next_code[length], length); j < 1u << FAST_BITS; j += 1u << length)
+                huffman->fast[j] = (uint16_t)(i << 4 | length);
+        ++next_code[length];
+    }
+    return true;
+}
+
+static int decode_symbol(BitReader *const reader, Huffman const *const huffman) {
+    if (reader->bit_count < 16) refill(reader);
+    uint32_t const entry = huffman->fast[reader->bits & FAST_MASK];
+    if (entry) {
+        reader->bits >>= entry & 15;
+        reader->bit_count -= entry & 15;
+        return (int)(entry >> 4);
+    }
+
+    uint32_t const code = reverse_bits((uint32_t)(reader->bits & 0xFFFF), 16);
+    uint32_t length = FAST_BITS + 1;
+    while (length < 16 && code >= huffman->max_code[length]) ++length;
+    if (length == 16) return -1;
+    uint32_t const index = (code >> (16 - length)) - huffman->first_code[length] + huffman->first_symbol[length];
+    if (index >= 288) return -1;
+    reader->bits >>= length;
+    reader->bit_count -= length;
+    return huffman->symbols[index];
+}
+
+static uint16_t const length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static uint8_t const length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static uint16_t const distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097,
+    6145, 8193, 12289, 16385, 24577
+};
+static uint8_t const distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+typedef struct {
+    Huffman literals;
+    Huffman distances;
+} HuffmanTables;
+
+static void build_fixed_tables(HuffmanTables *const tables) {
+    uint8_t lengths[288];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    build_huffman(&tables->literals, lengths, 288);
+    memset(lengths, 5, 30);
+    build_huffman(&tables->distances, lengths, 30);
+}
+
+static bool read_dynamic_tables(BitReader *const reader, HuffmanTables *const tables) {
+    static uint8_t const code_length_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    uint32_t const literal_count = get_bits(reader, 5) + 257;
+    uint32_t const distance_count = get_bits(reader, 5) + 1;
+    uint32_t const code_length_count = get_bits(reader, 4) + 4;
+    if (literal_count > 286) return false;
+
+    uint8_t code_lengths[19] = {};
+    for (uint32_t i = 0; i < code_length_count; ++i) code_lengths[code_length_order[i]] = (uint8_t)get_bits(reader, 3);
+    Huffman code_length_huffman;
+    if (!build_huffman(&code_length_huffman, code_lengths, 19)) return false;
+
+    uint8_t lengths[286 + 30];
+    uint32_t count = 0;
+    while (count < literal_count + distance_count) {
+        int const symbol = decode_symbol(reader, &code_length_huffman);
+        if (symbol < 0 || is_overrun(reader)) return false;
+        if (symbol < 16) {
+            lengths[count++] = (uint8_t)symbol;
+            continue;
+        }
+        uint8_t fill = 0;
+        uint32_t repeat;
+        if (symbol == 16) {
+            if (!count) return false;
+            fill = lengths[count - 1];
+            repeat = get_bits(reader, 2) + 3;
+        } else if (symbol == 17) {
+            repeat = get_bits(reader, 3) + 3;
+        } else {
+            repeat = get_bits(reader, 7) + 11;
+        }
+        if (count + repeat > literal_count + distance_count) return false;
+        memset(lengths + count, fill, repeat);
+        count += repeat;
+    }
+    if (!lengths[256]) return false;
+    return build_huffman(&tables->literals, lengths, literal_count) &&
+           build_huffman(&tables->distances, lengths + literal_count, distance_count);
+}
+
+static bool inflate_block(BitReader *const reader, HuffmanTables const *const tables, uint8_t *const output,
+                          size_t const output_size, size_t *const cursor) {
+    size_t position = *cursor;
+    for (;;) {
+        int const symbol = decode_symbol(reader, &tables->literals);
+        if (symbol < 256) {
+            if (symbol < 0 || position >= output_size) return false;
+            output[position++] = (uint8_t)symbol;
+            continue;
+        }
+        if (symbol == 256) break;
+        if (symbol > 285) return false;
+
+        size_t const length = length_base[symbol - 257] + get_bits(reader, length_extra[symbol - 257]);
+        int const distance_symbol = decode_symbol(reader, &tables->distances);
+        if (distance_symbol < 0 || distance_symbol > 29) return false;
+        size_t const distance = distance_base[distance_symbol] + get_bits(reader, distance_extra[distance_symbol]);
+        if (distance > position || length > output_size - position) return false;
+
+        uint8_t *const destination = output + position;
+        uint8_t const *const source = destination - distance;
+        if (distance >= length) {
+            memcpy(destination, source, length);
+        } else if (distance == 1) {
+            memset(destination, *source, length);
+        } else {
+            for (size_t i = 0; i < length; ++i) destination[i] = source[i];
+        }
+        position += length;
+    }
+    *cursor = position;
+    return !is_overrun(reader);
+}
+
+// zlib stream into a buffer of exactly the expected size
+static bool inflate_zlib(uint8_t const *const data, size_t const size, uint8_t *const output, size_t const output_size) {
+    if (size < 2 || (data[0] & 0x0F) != 8 || ((data[0] << 8) | data[1]) % 31 || data[1] & 0x20) return false;
+
+    BitReader reader = {.data = data + 2, .size = size - 2};
+    size_t cursor = 0;
+    HuffmanTables tables;
+    bool last;
+    do {
+        last = get_bits(&reader, 1);
+        uint32_t const type = get_bits(&reader, 2);
+        if (type == 0) {
+            get_bits(&reader, reader.bit_count % 8);
+            uint32_t const length = get_bits(&reader, 16);
+            uint32_t const inverse = get_bits(&reader, 16);
+            if ((length ^ 0xFFFF) != inverse || length > output_size - cursor) return false;
+            for (uint32_t i = 0; i < length; ++i) output[cursor++] = (uint8_t)get_bits(&reader, 8);
+            if (is_overrun(&reader)) return false;
+        } else if (type == 1) {
+            build_fixed_tables(&tables);
+            if (!inflate_block(&reader, &tables, output, output_size, &cursor)) return false;
+        } else if (type == 2) {
+            if (!read_dynamic_tables(&reader, &tables)) return false;
+            if (!inflate_block(&reader, &tables, output, output_size, &cursor)) return false;
+        } else {
+            return false;
+        }
+    } while (!last);
+    return cursor == output_size;
+}
+
+// unfiltering
+
+static uint8_t paeth(uint8_t const a, uint8_t const b, uint8_t const c) {
+    int const p = a + b - c;
+    int const pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    return pb <= pc ? b : c;
+}
+
+static void unfilter_up_scalar(uint8_t *const row, uint8_t const *const previous, size_t const start,
+                               size_t const size) {
+    for (size_t i = start; i < size; ++i) row[i] += previous[i];
+}
+
+#ifdef PNG_X86
+__attribute__((target("avx2")))
+static void unfilter_up_avx2(uint8_t *const row, uint8_t const *const previous, size_t const size) {
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        auto const x = _mm256_loadu_si256((__m256i const*)(row + i));
+        auto const b = _mm256_loadu_si256((__m256i const*)(previous + i));
+        _mm256_storeu_si256((__m256i*)(row + i), _mm256_add_epi8(x, b));
+    }
+    unfilter_up_scalar(row, previous, i, size);
+}
+
+static void unfilter_up_sse2(uint8_t *const row, uint8_t const *const previous, size_t const size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        auto const x = _mm_loadu_si128((__m128i const*)(row + i));
+        auto const b = _mm_loadu_si128((__m128i const*)(previous + i));
+        _mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(x, b));
+    }
+    unfilter_up_scalar(row, previous, i, size);
+}
+
+static __m128i load_pixel(uint8_t const *const bytes, uint32_t const bpp) {
+    uint32_t value = 0;
+    memcpy(&value, bytes, bpp);
+    return _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)value), _mm_setzero_si128());
+}
+
+static void store_pixel(uint8_t *const bytes, __m128i const pixel, uint32_t const bpp) {
+    auto const value = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(pixel, pixel));
+    memcpy(bytes, &value, bpp);
+}
+
+// four pixels per iteration, the running prefix sum is carried in the top lane
+static void unfilter_sub4_sse2(uint8_t *const row, size_t const size) {
+    auto carry = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        auto x = _mm_loadu_si128((__m128i const*)(row + i));
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi8(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi8(x, carry);
+        _mm_storeu_si128((__m128i*)(row + i), x);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    for (; i < size; ++i) row[i] += i >= 4 ? row[i - 4] : 0;
+}
+
+// avg and paeth depend on the pixel to the left, so they run one pixel at a time in 16 bit lanes
+static void unfilter_average_sse2(uint8_t *const row, uint8_t const *const previous, size_t const size,
+                                  uint32_t const bpp) {
+    auto const mask = _mm_set1_epi16(0xFF);
+    auto a = _mm_setzero_si128();
+    for (size_t i = 0; i < size; i += bpp) {
+        auto const b = load_pixel(previous + i, bpp);
+        auto x = load_pixel(row + i, bpp);
+        x = _mm_and_si128(_mm_add_epi16(x, _mm_srli_epi16(_mm_add_epi16(a, b), 1)), mask);
+        store_pixel(row + i, x, bpp);
+        a = x;
+    }
+}
+
+static __m128i select_si128(__m128i const condition, __m128i const then, __m128i const otherwise) {
+    return _mm_or_si128(_mm_and_si128(condition, then), _mm_andnot_si128(condition, otherwise));
+}
+
+static __m128i abs_epi16(__m128i const value) { return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value)); }
+
+static void unfilter_paeth_sse2(uint8_t *const row, uint8_t const *const previous, size_t const size,
+                                uint32_t const bpp) {
+    auto const mask = _mm_set1_epi16(0xFF);
+    auto a = _mm_setzero_si128();
+    auto c = _mm_setzero_si128();
+    for (size_t i = 0; i < size; i += bpp) {
+        auto const b = load_pixel(previous + i, bpp);
+        auto x = load_pixel(row + i, bpp);
+
+        // pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|
+        auto pa = _mm_sub_epi16(b, c);
+        auto pb = _mm_sub_epi16(a, c);
+        auto pc = _mm_add_epi16(pa, pb);
+        pa = abs_epi16(pa);
+        pb = abs_epi16(pb);
+        pc = abs_epi16(pc);
+        auto const smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+        auto const predictor = select_si128(_mm_cmpeq_epi16(smallest, pa), a,
+                                            select_si128(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+        x = _mm_and_si128(_mm_add_epi16(x, predictor), mask);
+        store_pixel(row + i, x, bpp);
+        a = x;
+        c = b;
+    }
+}
+
+static bool has_avx2() { return __builtin_cpu_supports("avx2"); }
+#endif
+
+static bool unfilter_row(uint8_t const filter, uint8_t *const row, uint8_t const *const previous, size_t const size,
+                         uint32_t const bpp) {
+    switch (filter) {
+        case FILTER_NONE:
+            return true;
+        case FILTER_SUB:
+#ifdef PNG_X86
+            if (bpp == 4) {
+                unfilter_sub4_sse2(row, size);
+                return true;
+            }
+#endif
+            for (size_t i = bpp; i < size; ++i) row[i] += row[i - bpp];
+            return true;
+        case FILTER_UP:
+#ifdef PNG_X86
+            if (has_avx2()) unfilter_up_avx2(row, previous, size);
+            else unfilter_up_sse2(row, previous, size);
+#else
+            unfilter_up_scalar(row, previous, 0, size);
+#endif
+            return true;
+        case FILTER_AVERAGE:
+#ifdef PNG_X86
+            if (bpp == 3 || bpp == 4) {
+                unfilter_average_sse2(row, previous, size, bpp);
+                return true;
+            }
+#endif
+            for (size_t i = 0; i < bpp; ++i) row[i] += previous[i] >> 1;
+            for (size_t i = bpp; i < size; ++i) row[i] += (uint8_t)((row[i - bpp] + previous[i]) >> 1);
+            return true;
+        case FILTER_PAETH:
+#ifdef PNG_X86
+            if (bpp == 3 || bpp == 4) {
+                unfilter_paeth_sse2(row, previous, size, bpp);
+                return true;
+            }
+#endif
+            for (size_t i = 0; i < bpp; ++i) row[i] += previous[i];
+            for (size_t i = bpp; i < size; ++i) row[i] += paeth(row[i - bpp], previous[i], previous[i - bpp]);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// conversion to premultiplied BGRA8
+
+static uint8_t premultiply(uint8_t const value, uint8_t const alpha) {
+    return (uint8_t)((value * alpha + 127) / 255);
+}
+
+static uint32_t pack_bgra(uint8_t const r, uint8_t const g, uint8_t const b, uint8_t const a) {
+    if (a != 255) return (uint32_t)premultiply(b, a) | (uint32_t)premultiply(g, a) << 8 |
+                         (uint32_t)premultiply(r, a) << 16 | (uint32_t)a << 24;
+    return (uint32_t)b | (uint32_t)g << 8 | (uint32_t)r << 16 | 0xFF000000u;
+}
+
+static void convert_rgba8(uint8_t const *const row, uint32_t *const output, uint32_t const width) {
+    uint32_t x = 0;
+#ifdef PNG_X86
+    auto const alpha_mask = _mm_set1_epi32((int)0xFF000000);
+    auto const green_mask = _mm_set1_epi32(0x0000FF00);
+    auto const low_mask = _mm_set1_epi32(0x000000FF);
+    for (; x + 4 <= width; x += 4) {
+        auto const pixels = _mm_loadu_si128((__m128i const*)(row + x * 4));
+        // opaque blocks only need the red and blue swap, anything else takes the premultiplying path
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(pixels, alpha_mask), alpha_mask)) != 0xFFFF) break;
+        auto const swapped = _mm_or_si128(_mm_and_si128(pixels, _mm_or_si128(alpha_mask, green_mask)),
+                                          _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 16), low_mask),
+                                                       _mm_slli_epi32(_mm_and_si128(pixels, low_mask), 16)));
+        _mm_storeu_si128((__m128i*)(output + x), swapped);
+    }
+#endif
+    for (; x < width; ++x) {
+        auto const pixel = row + x * 4;
+        output[x] = pack_bgra(pixel[0], pixel[1], pixel[2], pixel[3]);
+    }
+}
+
+static void convert_rgb8(uint8_t const *const row, uint32_t *const output, uint32_t const width) {
+    for (uint32_t x = 0; x < width; ++x) {
+        auto const pixel = row + x * 3;
+        output[x] = (uint32_t)pixel[2] | (uint32_t)pixel[1] << 8 | (uint32_t)pixel[0] << 16 | 0xFF000000u;
+    }
+}
+
+typedef struct {
+    uint32_t palette[256];
+    bool has_color_key;
+    uint16_t color_key[3];
+} ConversionState;
+
+static uint32_t read_sample(uint8_t const *const row, size_t const index, uint8_t const bit_depth) {
+    switch (bit_depth) {
+        case 16: return (uint32_t)row[index * 2] << 8 | row[index * 2 + 1];
+        case 8: return row[index];
+        default: {
+            size_t const bit = index * bit_depth;
+            return (uint32_t)(row[bit / 8] >> (8 - bit_depth - bit % 8)) & ((1u << bit_depth) - 1);
+        }
+    }
+}
+
+static uint8_t scale_sample(uint32_t const sample, uint8_t const bit_depth) {
+    switch (bit_depth) {
+        case 16: return (uint8_t)(sample >> 8);
+        case 8: return (uint8_t)sample;
+        default: return (uint8_t)(sample * 255 / ((1u << bit_depth) - 1));
+    }
+}
+
+// every other format, one sample at a time
+static void convert_generic(uint8_t const *const row, uint32_t *const output, PngInfo const *const info,
+                            ConversionState const *const state) {
+    uint32_t const channels = channel_count(info->color_type);
+    for (uint32_t x = 0; x < info->width; ++x) {
+        uint32_t samples[4];
+        for (uint32_t i = 0; i < channels; ++i) samples[i] = read_sample(row, (size_t)x * channels + i, info->bit_depth);
+
+        switch (info->color_type) {
+            case COLOR_TYPE_PALETTE:
+                output[x] = state->palette[samples[0]];
+                break;
+            case COLOR_TYPE_GRAY: {
+                auto const gray = scale_sample(samples[0], info->bit_depth);
+                bool const transparent = state->has_color_key && samples[0] == state->color_key[0];
+                output[x] = transparent ? 0 : pack_bgra(gray, gray, gray, 255);
+                break;
+            }
+            case COLOR_TYPE_GRAY_ALPHA: {
+                auto const gray = scale_sample(samples[0], info->bit_depth);
+                output[x] = pack_bgra(gray, gray, gray, scale_sample(samples[1], info->bit_depth));
+                break;
+            }
+            case COLOR_TYPE_RGB: {
+                bool const transparent = state->has_color_key && samples[0] == state->color_key[0] &&
+                                         samples[1] == state->color_key[1] && samples[2] == state->color_key[2];
+                output[x] = transparent
+                                ? 0
+                                : pack_bgra(scale_sample(samples[0], info->bit_depth),
+                                            scale_sample(samples[1], info->bit_depth),
+                                            scale_sample(samples[2], info->bit_depth), 255);
+                break;
+            }
+            default:
+                output[x] = pack_bgra(scale_sample(samples[0], info->bit_depth),
+                                      scale_sample(samples[1], info->bit_depth),
+                                      scale_sample(samples[2], info->bit_depth),
+                                      scale_sample(samples[3], info->bit_depth));
+                break;
+        }
+    }
+}
+
+bool png_decode_bgra(void const *const data, size_t const size, void *const pixels) {
+    PngInfo info;
+    if (!png_read_info(data, size, &info) || info.interlace_method) return false;
+
+    auto const bytes = (uint8_t const*)data;
+    uint32_t const channels = channel_count(info.color_type);
+    size_t const row_size = ((size_t)info.width * channels * info.bit_depth + 7) / 8;
+    uint32_t const bpp = channels * info.bit_depth >= 8 ? channels * info.bit_depth / 8 : 1;
+    size_t const filtered_size = (row_size + 1) * info.height;
+
+    ConversionState state = {};
+    for (uint32_t i = 0; i < 256; ++i) state.palette[i] = 0xFF000000u;
+
+    // gather the IDAT payloads, the zlib stream may be split across any number of them
+    size_t compressed_size = 0, compressed_capacity = 0;
+    uint8_t *compressed = nullptr, *filtered = nullptr;
+    bool result = false;
+    for (size_t offset = 8; offset + 12 <= size;) {
+        uint32_t const length = read_be32(bytes + offset);
+        auto const type = bytes + offset + 4;
+        auto const payload = bytes + offset + 8;
+        if (length > size - offset - 12) goto cleanup;
+
+        if (!memcmp(type, "IDAT", 4) && length) {
+            if (compressed_size + length > compressed_capacity) {
+                compressed_capacity = (compressed_size + length) * 2;
+                auto const grown = (uint8_t*)realloc(compressed, compressed_capacity);
+                if (!grown) goto cleanup;
+                compressed = grown;
+            }
+            memcpy(compressed + compressed_size, payload, length);
+            compressed_size += length;
+        } else if (!memcmp(type, "PLTE", 4)) {
+            for (uint32_t i = 0; i < length / 3 && i < 256; ++i)
+                state.palette[i] = pack_bgra(payload[i * 3], payload[i * 3 + 1], payload[i * 3 + 2], 255);
+        } else if (!memcmp(type, "tRNS", 4)) {
+            if (info.color_type == COLOR_TYPE_PALETTE) {
+                for (uint32_t i = 0; i < length && i < 256; ++i) {
+                    uint32_t const color = state.palette[i];
+                    state.palette[i] = pack_bgra((uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color,
+                                                 payload[i]);
+                }
+            } else if (info.color_type == COLOR_TYPE_GRAY && length >= 2) {
+                state.has_color_key = true;
+                state.color_key[0] = (uint16_t)(payload[0] << 8 | payload[1]);
+            } else if (info.color_type == COLOR_TYPE_RGB && length >= 6) {
+                state.has_color_key = true;
+                for (uint32_t i = 0; i < 3; ++i) state.color_key[i] = (uint16_t)(payload[i * 2] << 8 | payload[i * 2 + 1]);
+            }
+        } else if (!memcmp(type, "IEND", 4)) {
+            break;
+        }
+        offset += 12 + (size_t)length;
+    }
+
+    filtered = malloc(filtered_size);
+    if (!filtered) goto cleanup;
+    if (inflate_zlib(compressed, compressed_size, filtered, filtered_size)) {
+        // the row above the first one is all zeros, the filter byte slot in front of every row serves as scratch
+        uint8_t *const zero_row = calloc(row_size, 1);
+        result = zero_row != nullptr;
+        uint8_t const *previous = zero_row;
+        for (uint32_t y = 0; result && y < info.height; ++y) {
+            uint8_t *const row = filtered + y * (row_size + 1);
+            result = unfilter_row(row[0], row + 1, previous, row_size, bpp);
+            previous = row + 1;
+
+            auto const output = (uint32_t*)pixels + (size_t)y * info.width;
+            if (info.bit_depth == 8 && info.color_type == COLOR_TYPE_RGBA) convert_rgba8(row + 1, output, info.width);
+            else if (info.bit_depth == 8 && info.color_type == COLOR_TYPE_RGB && !state.has_color_key)
+                convert_rgb8(row + 1, output, info.width);
+            else convert_generic(row + 1, output, &info, &state);
+        }
+        free(zero_row);
+    }
+
+cleanup:
+    free(filtered);
+    free(compressed);
+    return result;
+}
+
+// parallel decoding, one job per image
+
+static void decode_job(void *const data) {
+    PngDecodeTask *const task = data;
+    task->result = png_decode_bgra(task->data, task->size, task->pixels);
+}
+
+void png_decode_parallel(JobSystem *const jobs, PngDecodeTask *const tasks, size_t const count) {
+    JobCounter counter = {};
+    for (size_t i = 0; i < count; ++i)
+        job_system_submit(jobs, &(Job){.function = decode_job, .data = &tasks[i]}, 1, &counter);
+    job_system_wait(jobs, &counter);
+}
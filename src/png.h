@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "jobs.h"
+
+// png decoding without any library
+// inflate and unfiltering are written for speed, sse2 and avx2 are used when the cpu has them
+// output is always premultiplied BGRA8, the layout the WIC path used to produce
+
+typedef struct {
+    uint32_t width, height;
+    uint8_t bit_depth;
+    uint8_t color_type;
+    uint8_t interlace_method;
+} PngInfo;
+
+// only reads the header, enough to size the destination before decoding
+bool png_read_info(void const *data, size_t size, PngInfo *info);
+
+// pixels must hold width * height * 4 bytes, rows are tightly packed
+bool png_decode_bgra(void const *data, size_t size, void *pixels);
+
+typedef struct {
+    void const *data;
+    size_t size;
+    void *pixels;
+    bool result;
+} PngDecodeTask;
+
+// decodes every task as a job and waits for all of them, the calling thread helps
+void png_decode_parallel(JobSystem *jobs, PngDecodeTask *tasks, size_t count);
@@ -0,0 +1,156 @@
+#include "profiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+// upper bound of one trace event, names are short literals
+constexpr size_t MAX_TRACE_EVENT_SIZE = 256;
+
+uint64_t profiler_time_ns() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart * 1000000000ull +
+                      counter.QuadPart % frequency.QuadPart * 1000000000ull / frequency.QuadPart);
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
+
+void profiler_init(Profiler *const profiler) {
+    *profiler = (Profiler){
+        .frame_start_ns = profiler_time_ns(),
+        .zones = malloc(PROFILER_MAX_ZONES * sizeof(ProfilerZone)),
+    };
+}
+
+void profiler_free(Profiler *const profiler) {
+    free(profiler->zones);
+    profiler->zones = nullptr;
+}
+
+void profiler_begin_zone(Profiler *const profiler, char const *const name) {
+    auto const index = profiler->zone_count++;
+    profiler->zones[index % PROFILER_MAX_ZONES] = (ProfilerZone){
+        .name = name,
+        .start_ns = profiler_time_ns(),
+        .frame = profiler->frame,
+        .track = PROFILER_TRACK_CPU,
+    };
+    // deeper zones are still timed by their parents
+    if (profiler->open_zone_count < PROFILER_MAX_DEPTH) profiler->open_zones[profiler->open_zone_count] = index;
+    ++profiler->open_zone_count;
+}
+
+void profiler_end_zone(Profiler *const profiler) {
+    auto const depth = --profiler->open_zone_count;
+    if (depth >= PROFILER_MAX_DEPTH) return;
+    auto const index = profiler->open_zones[depth];
+    // the ring wrapped around a zone that stayed open too long
+    if (profiler->zone_count - index > PROFILER_MAX_ZONES) return;
+    profiler->zones[index % PROFILER_MAX_ZONES].end_ns = profiler_time_ns();
+}
+
+void profiler_add_zone(Profiler *const profiler, ProfilerTrack const track, char const *const name,
+                       uint64_t const start_ns, uint64_t const end_ns, uint64_t const frame) {
+    profiler->zones[profiler->zone_count++ % PROFILER_MAX_ZONES] = (ProfilerZone){
+        .name = name,
+        .start_ns = start_ns,
+        .end_ns = end_ns,
+        .frame = frame,
+        .track = track,
+    };
+}
+
+void profiler_end_frame(Profiler *const profiler) {
+    auto const now = profiler_time_ns();
+    profiler->frame_times_ns[profiler->frame_time_count++ % PROFILER_FRAME_WINDOW] = now - profiler->frame_start_ns;
+    profiler->frame_start_ns = now;
+    ++profiler->frame;
+}
+
+static int compare_u64(void const *const a, void const *const b) {
+    auto const x = *(uint64_t const*)a;
+    auto const y = *(uint64_t const*)b;
+    return (x > y) - (x < y);
+}
+
+// nearest rank on the sorted window
+static double frame_time_percentile(uint64_t const *const sorted, uint32_t const count, uint32_t const percent) {
+    auto const rank = (count * percent + 99) / 100;
+    return (double)sorted[rank ? rank - 1 : 0] / 1e6;
+}
+
+// sample_count counts every sample ever added, the window holds the most recent ones
+static FrameTimeStats window_stats(uint64_t const *const window, uint64_t const sample_count) {
+    auto const count = (uint32_t)(sample_count < PROFILER_FRAME_WINDOW ? sample_count : PROFILER_FRAME_WINDOW);
+    if (!count) return (FrameTimeStats){};
+
+    uint64_t sorted[PROFILER_FRAME_WINDOW];
+    memcpy(sorted, window, count * sizeof(uint64_t));
+    qsort(sorted, count, sizeof(uint64_t), compare_u64);
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < count; ++i) total += sorted[i];
+    return (FrameTimeStats){
+        .frame_count = count,
+        .average_ms = (double)total / count / 1e6,
+        .p50_ms = frame_time_percentile(sorted, count, 50),
+        .p95_ms = frame_time_percentile(sorted, count, 95),
+        .p99_ms = frame_time_percentile(sorted, count, 99),
+        .max_ms = (double)sorted[count - 1] / 1e6,
+    };
+}
+
+FrameTimeStats profiler_frame_time_stats(Profiler const *const profiler) {
+    return window_stats(profiler->frame_times_ns, profiler->frame_time_count);
+}
+
+void profiler_add_latency(Profiler *const profiler, uint64_t const latency_ns) {
+    profiler->latencies_ns[profiler->latency_count++ % PROFILER_FRAME_WINDOW] = latency_ns;
+}
+
+FrameTimeStats profiler_latency_stats(Profiler const *const profiler) {
+    return window_stats(profiler->latencies_ns, profiler->latency_count);
+}
+
+char *profiler_chrome_trace(Profiler const *const profiler, size_t *const size) {
+    auto const first = profiler->zone_count > PROFILER_MAX_ZONES ? profiler->zone_count - PROFILER_MAX_ZONES : 0;
+    auto const capacity = (size_t)(profiler->zone_count - first + PROFILER_TRACK_COUNT + 1) * MAX_TRACE_EVENT_SIZE;
+    char *const json = malloc(capacity);
+
+    // timestamps start at the earliest zone so the numbers stay readable
+    uint64_t origin = UINT64_MAX;
+    for (auto i = first; i < profiler->zone_count; ++i) {
+        auto const zone = &profiler->zones[i % PROFILER_MAX_ZONES];
+        if (zone->start_ns < origin) origin = zone->start_ns;
+    }
+
+    static char const *const track_names[PROFILER_TRACK_COUNT] = {"cpu", "gpu"};
+    size_t length = (size_t)snprintf(json, capacity, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (uint32_t track = 0; track < PROFILER_TRACK_COUNT; ++track)
+        length += (size_t)snprintf(json + length, capacity - length,
+                                   "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,"
+                                   "\"args\":{\"name\":\"%s\"}}", track ? "," : "", track, track_names[track]);
+    for (auto i = first; i < profiler->zone_count; ++i) {
+        auto const zone = &profiler->zones[i % PROFILER_MAX_ZONES];
+        if (!zone->end_ns) continue;
+        length += (size_t)snprintf(json + length, capacity - length,
+                                   ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                                   "\"args\":{\"frame\":%llu}}", zone->name, (uint32_t)zone->track,
+                                   (double)(zone->start_ns - origin) / 1e3,
+                                   (double)(zone->end_ns - zone->start_ns) / 1e3, (unsigned long long)zone->frame);
+    }
+    length += (size_t)snprintf(json + length, capacity - length, "\n]}\n");
+    *size = length;
+    return json;
+}
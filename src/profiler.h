@@ -0,0 +1,83 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// frame profiler for the render thread
+// cpu zones are timed where they run, gpu zones come back from timestamp queries a few frames later already moved to
+// the cpu clock, both end up in a chrome trace that chrome://tracing and ui.perfetto.dev open
+// frame times go to a rolling window for percentiles, so hitches show up in any build without a debugger attached
+// input to present latencies are measured by the caller and kept the same way
+
+// zones are kept in a ring, the trace holds the most recent ones
+constexpr uint32_t PROFILER_MAX_ZONES = 65536;
+constexpr uint32_t PROFILER_FRAME_WINDOW = 1024;
+constexpr uint32_t PROFILER_MAX_DEPTH = 16;
+
+typedef enum {
+    PROFILER_TRACK_CPU,
+    PROFILER_TRACK_GPU,
+    PROFILER_TRACK_COUNT,
+} ProfilerTrack;
+
+// names are not copied, string literals are expected
+typedef struct {
+    char const *name;
+    uint64_t start_ns;
+    // 0 while the zone is open
+    uint64_t end_ns;
+    uint64_t frame;
+    ProfilerTrack track;
+} ProfilerZone;
+
+// also used for latencies, then frame_count is the number of latencies
+typedef struct {
+    uint32_t frame_count;
+    double average_ms;
+    double p50_ms;
+    double p95_ms;
+    double p99_ms;
+    double max_ms;
+} FrameTimeStats;
+
+typedef struct {
+    uint64_t frame;
+    uint64_t frame_start_ns;
+    // every zone ever recorded, zone i lives at i % PROFILER_MAX_ZONES
+    uint64_t zone_count;
+    ProfilerZone *zones;
+    uint32_t open_zone_count;
+    uint64_t open_zones[PROFILER_MAX_DEPTH];
+    // frame i lives at i % PROFILER_FRAME_WINDOW
+    uint64_t frame_time_count;
+    uint64_t frame_times_ns[PROFILER_FRAME_WINDOW];
+    // latency i lives at i % PROFILER_FRAME_WINDOW
+    uint64_t latency_count;
+    uint64_t latencies_ns[PROFILER_FRAME_WINDOW];
+} Profiler;
+
+uint64_t profiler_time_ns();
+void profiler_init(Profiler *profiler);
+void profiler_free(Profiler *profiler);
+// zones nest, end closes the innermost open one
+void profiler_begin_zone(Profiler *profiler, char const *name);
+void profiler_end_zone(Profiler *profiler);
+// for zones timed elsewhere, such as on the gpu
+void profiler_add_zone(Profiler *profiler, ProfilerTrack track, char const *name, uint64_t start_ns, uint64_t end_ns,
+                       uint64_t frame);
+// the frame time is the time since the previous call
+void profiler_end_frame(Profiler *profiler);
+FrameTimeStats profiler_frame_time_stats(Profiler const *profiler);
+void profiler_add_latency(Profiler *profiler, uint64_t latency_ns);
+FrameTimeStats profiler_latency_stats(Profiler const *profiler);
+// chrome trace event json, the caller frees it
+char *profiler_chrome_trace(Profiler const *profiler, size_t *size);
+
+static inline void profiler_end_scope(Profiler *const *const profiler) { profiler_end_zone(*profiler); }
+
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+// a zone that ends when the enclosing block exits
+#define PROFILE_ZONE(profiler, name)                                                                                   \
+    Profiler *const PROFILER_CONCAT(profile_zone_, __LINE__) __attribute__((cleanup(profiler_end_scope))) =           \
+        (profiler_begin_zone(profiler, name), profiler)
@@ -0,0 +1,258 @@
+#include "region.h"
+
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// "CDXR" read as a little endian word
+constexpr uint32_t REGION_MAGIC = 0x52584443;
+constexpr uint32_t REGION_VERSION = 1;
+// compressed and serialized size
+constexpr size_t RECORD_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+static uint32_t chunk_index(int32_t const x, int32_t const y, int32_t const z) {
+    uint32_t const mask = REGION_SIZE - 1;
+    return ((uint32_t)x & mask) | ((uint32_t)z & mask) << REGION_SIZE_LOG2 |
+           ((uint32_t)y & mask) << REGION_SIZE_LOG2 * 2;
+}
+
+static size_t entry_offset(uint32_t const index) { return REGION_SECTOR_SIZE + index * sizeof(uint32_t); }
+
+#ifdef _WIN32
+static bool open_file(RegionFile *const region, RegionPathChar const *const path, size_t *const size) {
+    region->file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (region->file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(region->file, &file_size);
+    *size = (size_t)file_size.QuadPart;
+    return true;
+}
+
+static void unmap_file(RegionFile *const region) {
+    if (region->data) UnmapViewOfFile(region->data);
+    if (region->mapping) CloseHandle(region->mapping);
+    region->data = nullptr;
+    region->mapping = nullptr;
+}
+
+static bool map_file(RegionFile *const region) {
+    region->mapping = CreateFileMappingW(region->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!region->mapping) return false;
+    region->data = MapViewOfFile(region->mapping, FILE_MAP_READ, 0, 0, 0);
+    return region->data;
+}
+
+static bool resize_file(RegionFile const *const region, size_t const size) {
+    return SetFilePointerEx(region->file, (LARGE_INTEGER){.QuadPart = (LONGLONG)size}, nullptr, FILE_BEGIN) &&
+           SetEndOfFile(region->file);
+}
+
+static bool write_file_at(RegionFile const *const region, size_t offset, void const *const data, size_t size) {
+    uint8_t const *bytes = data;
+    while (size) {
+        OVERLAPPED overlapped = {.Offset = (DWORD)offset, .OffsetHigh = (DWORD)((uint64_t)offset >> 32)};
+        DWORD written;
+        if (!WriteFile(region->file, bytes, (DWORD)size, &written, &overlapped) || !written) return false;
+        bytes += written;
+        offset += written;
+        size -= written;
+    }
+    return true;
+}
+
+static void close_file(RegionFile *const region) {
+    unmap_file(region);
+    CloseHandle(region->file);
+}
+#else
+static bool open_file(RegionFile *const region, RegionPathChar const *const path, size_t *const size) {
+    region->file = open(path, O_RDWR | O_CREAT, 0644);
+    if (region->file < 0) return false;
+    struct stat status;
+    fstat(region->file, &status);
+    *size = (size_t)status.st_size;
+    return true;
+}
+
+static void unmap_file(RegionFile *const region) {
+    if (region->data) munmap((void *)region->data, (size_t)region->sector_count * REGION_SECTOR_SIZE);
+    region->data = nullptr;
+}
+
+static bool map_file(RegionFile *const region) {
+    void *const data = mmap(nullptr, (size_t)region->sector_count * REGION_SECTOR_SIZE, PROT_READ, MAP_SHARED,
+                            region->file, 0);
+    region->data = data == MAP_FAILED ? nullptr : data;
+    return region->data;
+}
+
+static bool resize_file(RegionFile const *const region, size_t const size) {
+    return ftruncate(region->file, (off_t)size) == 0;
+}
+
+static bool write_file_at(RegionFile const *const region, size_t offset, void const *const data, size_t size) {
+    uint8_t const *bytes = data;
+    while (size) {
+        auto const written = pwrite(region->file, bytes, size, (off_t)offset);
+        if (written <= 0) return false;
+        bytes += written;
+        offset += (size_t)written;
+        size -= (size_t)written;
+    }
+    return true;
+}
+
+static void close_file(RegionFile *const region) {
+    unmap_file(region);
+    close(region->file);
+}
+#endif
+
+static bool is_sector_used(RegionFile const *const region, uint32_t const sector) {
+    return region->used_sectors[sector / 64] >> sector % 64 & 1;
+}
+
+static void mark_sectors(RegionFile *const region, uint32_t const first, uint32_t const count, bool const used) {
+    for (auto sector = first; sector < first + count; ++sector)
+        if (used) region->used_sectors[sector / 64] |= 1ull << sector % 64;
+        else region->used_sectors[sector / 64] &= ~(1ull << sector % 64);
+}
+
+// the mapping only covers the old size, so it is rebuilt, the new sectors are free
+static bool grow_file(RegionFile *const region, uint32_t const sector_count) {
+    unmap_file(region);
+    if (!resize_file(region, (size_t)sector_count * REGION_SECTOR_SIZE)) {
+        map_file(region);
+        return false;
+    }
+    uint32_t const old_words = (region->sector_count + 63) / 64, words = (sector_count + 63) / 64;
+    region->used_sectors = realloc(region->used_sectors, words * sizeof(uint64_t));
+    memset(region->used_sectors + old_words, 0, (words - old_words) * sizeof(uint64_t));
+    region->sector_count = sector_count;
+    return map_file(region);
+}
+
+// first fit, a run that reaches the end of the file is completed by growing it
+static uint32_t allocate_sectors(RegionFile *const region, uint32_t const count) {
+    uint32_t run_start = REGION_HEADER_SECTORS, run_length = 0;
+    for (auto sector = REGION_HEADER_SECTORS; sector < region->sector_count && run_length < count; ++sector) {
+        if (is_sector_used(region, sector)) {
+            run_start = sector + 1;
+            run_length = 0;
+        } else {
+            ++run_length;
+        }
+    }
+    if (run_length < count) {
+        auto const needed = run_start + count - region->sector_count;
+        auto const growth = needed > REGION_GROW_SECTORS ? needed : REGION_GROW_SECTORS;
+        if (!grow_file(region, region->sector_count + growth)) return UINT32_MAX;
+    }
+    mark_sectors(region, run_start, count, true);
+    return run_start;
+}
+
+bool region_open(RegionFile *const region, RegionPathChar const *const path, int32_t const x, int32_t const y,
+                 int32_t const z) {
+    *region = (RegionFile){.x = x, .y = y, .z = z};
+    size_t size;
+    if (!open_file(region, path, &size)) return false;
+
+    uint32_t const header[2] = {REGION_MAGIC, REGION_VERSION};
+    if (!size) {
+        // a new region, the zeroed table says no chunk was saved yet
+        size = (size_t)REGION_HEADER_SECTORS * REGION_SECTOR_SIZE;
+        if (!resize_file(region, size) || !write_file_at(region, 0, header, sizeof(header))) {
+            close_file(region);
+            return false;
+        }
+    }
+    region->sector_count = (uint32_t)(size / REGION_SECTOR_SIZE);
+    if (region->sector_count < REGION_HEADER_SECTORS || !map_file(region) ||
+        memcmp(region->data, header, sizeof(header))) {
+        close_file(region);
+        return false;
+    }
+
+    region->used_sectors = calloc((region->sector_count + 63) / 64, sizeof(uint64_t));
+    mark_sectors(region, 0, REGION_HEADER_SECTORS, true);
+    memcpy(region->entries, region->data + REGION_SECTOR_SIZE, sizeof(region->entries));
+    for (uint32_t i = 0; i < REGION_CHUNK_COUNT; ++i) {
+        auto const entry = region->entries[i];
+        if (!entry) continue;
+        uint32_t const first = entry >> 8, count = entry & 0xFF;
+        bool is_valid = first >= REGION_HEADER_SECTORS && count && first + count <= region->sector_count;
+        for (auto sector = first; is_valid && sector < first + count; ++sector)
+            is_valid = !is_sector_used(region, sector);
+        if (is_valid) mark_sectors(region, first, count, true);
+        else region->entries[i] = 0;
+    }
+    return true;
+}
+
+void region_close(RegionFile *const region) {
+    close_file(region);
+    free(region->used_sectors);
+    *region = (RegionFile){};
+}
+
+bool region_has_chunk(RegionFile const *const region, int32_t const x, int32_t const y, int32_t const z) {
+    return region->entries[chunk_index(x, y, z)];
+}
+
+bool region_read_chunk(RegionFile const *const region, RegionScratch *const scratch, int32_t const x,
+                       int32_t const y, int32_t const z, Chunk *const chunk) {
+    auto const entry = region->entries[chunk_index(x, y, z)];
+    if (!entry) return false;
+    uint8_t const *const record = region->data + (size_t)(entry >> 8) * REGION_SECTOR_SIZE;
+    uint32_t sizes[2];
+    memcpy(sizes, record, sizeof(sizes));
+    if (sizes[0] > (entry & 0xFF) * REGION_SECTOR_SIZE - RECORD_HEADER_SIZE || sizes[1] > CHUNK_MAX_SERIALIZED_SIZE ||
+        !lz_decompress(record + RECORD_HEADER_SIZE, sizes[0], scratch->serialized, sizes[1]))
+        return false;
+    return chunk_deserialize(chunk, x, y, z, scratch->serialized, sizes[1]);
+}
+
+bool region_write_chunk(RegionFile *const region, RegionScratch *const scratch, Chunk const *const chunk) {
+    auto const serialized_size = chunk_serialized_size(chunk);
+    chunk_serialize(chunk, scratch->serialized);
+    auto const compressed_size = lz_compress(scratch->serialized, serialized_size, scratch->record + RECORD_HEADER_SIZE,
+                                             sizeof(scratch->record) - RECORD_HEADER_SIZE);
+    if (!compressed_size) return false;
+    uint32_t const sizes[2] = {(uint32_t)compressed_size, (uint32_t)serialized_size};
+    memcpy(scratch->record, sizes, sizeof(sizes));
+
+    auto const record_size = RECORD_HEADER_SIZE + compressed_size;
+    auto const count = (uint32_t)((record_size + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE);
+    if (count > REGION_MAX_RECORD_SECTORS) return false;
+    auto const first = allocate_sectors(region, count);
+    if (first == UINT32_MAX) return false;
+    auto const index = chunk_index(chunk->x, chunk->y, chunk->z);
+    uint32_t const entry = first << 8 | count;
+    if (!write_file_at(region, (size_t)first * REGION_SECTOR_SIZE, scratch->record, record_size) ||
+        !write_file_at(region, entry_offset(index), &entry, sizeof(entry))) {
+        mark_sectors(region, first, count, false);
+        return false;
+    }
+    auto const old_entry = region->entries[index];
+    region->entries[index] = entry;
+    if (old_entry) mark_sectors(region, old_entry >> 8, old_entry & 0xFF, false);
+    return true;
+}
+
+void region_remove_chunk(RegionFile *const region, int32_t const x, int32_t const y, int32_t const z) {
+    auto const index = chunk_index(x, y, z);
+    auto const entry = region->entries[index];
+    if (!entry || !write_file_at(region, entry_offset(index), &(uint32_t){0}, sizeof(uint32_t))) return;
+    region->entries[index] = 0;
+    mark_sectors(region, entry >> 8, entry & 0xFF, false);
+}
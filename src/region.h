@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <wchar.h>
+#endif
+
+#include "chunk.h"
+#include "lz.h"
+
+// region files, a cube of REGION_SIZE chunks per axis in one file of 4 KiB sectors
+// sector 0 holds the magic and version, the next REGION_TABLE_SECTORS hold one entry per chunk with the first sector
+// of its record in the high 24 bits and the sector count in the low 8, 0 while the chunk was never saved
+// a record is the compressed and the serialized size followed by the lz compressed serialized chunk
+// reads decode straight out of a read only mapping of the file, nothing is copied into the heap first
+// writes go to free sectors, first fit or appended at the end, and only then is the table entry switched over, so
+// a live record is never overwritten and its old sectors are only reused afterwards
+// the file grows REGION_GROW_SECTORS at a time so most appends do not have to remap it
+
+constexpr uint32_t REGION_SIZE_LOG2 = 4;
+constexpr uint32_t REGION_SIZE = 1u << REGION_SIZE_LOG2;
+constexpr uint32_t REGION_CHUNK_COUNT = REGION_SIZE * REGION_SIZE * REGION_SIZE;
+constexpr uint32_t REGION_SECTOR_SIZE = 4096;
+constexpr uint32_t REGION_TABLE_SECTORS = REGION_CHUNK_COUNT * sizeof(uint32_t) / REGION_SECTOR_SIZE;
+constexpr uint32_t REGION_HEADER_SECTORS = 1 + REGION_TABLE_SECTORS;
+constexpr uint32_t REGION_GROW_SECTORS = 256;
+// the 8 bit sector count of an entry bounds a record, the largest chunk always fits
+constexpr uint32_t REGION_MAX_RECORD_SECTORS = 255;
+
+// paths are wide on windows like everywhere else in the engine
+#ifdef _WIN32
+typedef wchar_t RegionPathChar;
+#else
+typedef char RegionPathChar;
+#endif
+
+// per thread working memory for reads and writes
+typedef struct {
+    uint8_t serialized[CHUNK_MAX_SERIALIZED_SIZE];
+    uint8_t record[8 + LZ_COMPRESS_BOUND(CHUNK_MAX_SERIALIZED_SIZE)];
+} RegionScratch;
+
+typedef struct {
+    // in region coordinates, chunk coordinates shifted down by REGION_SIZE_LOG2
+    int32_t x, y, z;
+#ifdef _WIN32
+    void *file;
+    void *mapping;
+#else
+    int file;
+#endif
+    uint8_t const *data;
+    uint32_t sector_count;
+    uint32_t entries[REGION_CHUNK_COUNT];
+    // one bit per sector, set while a record or the header uses it
+    uint64_t *used_sectors;
+} RegionFile;
+
+static inline int32_t region_coordinate(int32_t const chunk_coordinate) {
+    return (chunk_coordinate - (chunk_coordinate < 0 ? (int32_t)REGION_SIZE - 1 : 0)) / (int32_t)REGION_SIZE;
+}
+
+// opens the file of the region at x, y, z or creates it, entries pointing outside of the file or into the header
+// or into another record are dropped
+bool region_open(RegionFile *region, RegionPathChar const *path, int32_t x, int32_t y, int32_t z);
+void region_close(RegionFile *region);
+// chunk coordinates, the chunk has to be in the region
+bool region_has_chunk(RegionFile const *region, int32_t x, int32_t y, int32_t z);
+// only reads the mapping, so any number of threads can read at once while nobody writes
+// false when the chunk was never saved or its record is damaged, the chunk is not initialized then
+bool region_read_chunk(RegionFile const *region, RegionScratch *scratch, int32_t x, int32_t y, int32_t z,
+                       Chunk *chunk);
+// saves the chunk at its coordinates, which have to be in the region
+bool region_write_chunk(RegionFile *region, RegionScratch *scratch, Chunk const *chunk);
+void region_remove_chunk(RegionFile *region, int32_t x, int32_t y, int32_t z);
@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ktx2.h"
+#include "pack.h"
+#include "png.h"
+
+// offline asset packer, every input becomes one entry of a pack the engine maps at startup
+// .spv files are shaders, .ktx2 files textures with their stored levels, .png files bgra8 textures decoded here so
+// the engine never decodes, anything else is a blob
+
+typedef struct {
+    PackEntry entry;
+    void *data;
+} Input;
+
+static void *read_file(char const *const filename, size_t *const size) {
+    FILE *const file = fopen(filename, "rb");
+    if (!file) return nullptr;
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void *const data = malloc(*size);
+    *size = fread(data, 1, *size, file);
+    fclose(file);
+    return data;
+}
+
+static int usage() {
+    fprintf(stderr, "usage: codoxel_asset_packer output.pack input.spv|input.ktx2|input.png|input...\n");
+    return 1;
+}
+
+static size_t align(size_t const value, size_t const alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+// the levels are copied to multiples of PACK_LEVEL_ALIGNMENT, the layout the staging copy uses
+static bool pack_ktx2(Input *const input, void const *const file, size_t const file_size) {
+    Ktx2Info info;
+    if (!ktx2_read_info(file, file_size, &info)) return false;
+    input->entry.format = (uint32_t)info.format;
+    input->entry.width = info.width;
+    input->entry.height = info.height;
+    input->entry.level_count = info.level_count;
+    size_t size = 0;
+    for (uint32_t i = 0; i < info.level_count; ++i) {
+        size = align(size, PACK_LEVEL_ALIGNMENT);
+        input->entry.levels[i] = (Ktx2Level){.offset = size, .size = info.levels[i].size};
+        size += info.levels[i].size;
+    }
+    input->data = calloc(1, size);
+    input->entry.size = size;
+    for (uint32_t i = 0; i < info.level_count; ++i)
+        memcpy((char *)input->data + input->entry.levels[i].offset, (char const *)file + info.levels[i].offset,
+               info.levels[i].size);
+    return true;
+}
+
+// the base level only, the engine blits the mips on the gpu
+static bool pack_png(Input *const input, void const *const file, size_t const file_size) {
+    PngInfo info;
+    if (!png_read_info(file, file_size, &info) || info.interlace_method) return false;
+    size_t const size = (size_t)info.width * info.height * 4;
+    input->data = malloc(size);
+    input->entry.format = VK_FORMAT_B8G8R8A8_SRGB;
+    input->entry.width = info.width;
+    input->entry.height = info.height;
+    input->entry.level_count = 1;
+    input->entry.levels[0] = (Ktx2Level){.size = size};
+    input->entry.size = size;
+    return png_decode_bgra(file, file_size, input->data);
+}
+
+static bool read_input(Input *const input, char const *const path) {
+    char const *name = path;
+    for (auto c = path; *c; ++c)
+        if (*c == '/' || *c == '\\') name = c + 1;
+    auto const extension = strrchr(name, '.');
+    size_t const name_length = extension ? (size_t)(extension - name) : strlen(name);
+    if (!name_length || name_length >= PACK_NAME_LENGTH) {
+        fprintf(stderr, "%s: the name has to be 1 to %u characters\n", path, PACK_NAME_LENGTH - 1);
+        return false;
+    }
+    memcpy(input->entry.name, name, name_length);
+
+    size_t file_size;
+    void *const file = read_file(path, &file_size);
+    if (!file) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return false;
+    }
+    bool const is_ktx2 = extension && !strcmp(extension, ".ktx2");
+    if (!is_ktx2 && !(extension && !strcmp(extension, ".png"))) {
+        input->entry.type = extension && !strcmp(extension, ".spv") ? PACK_ENTRY_SHADER : PACK_ENTRY_BLOB;
+        input->entry.size = file_size;
+        input->data = file;
+        if (input->entry.type == PACK_ENTRY_SHADER && file_size % 4) {
+            fprintf(stderr, "%s is not spir-v\n", path);
+            return false;
+        }
+        return true;
+    }
+
+    input->entry.type = PACK_ENTRY_TEXTURE;
+    bool const result = is_ktx2 ? pack_ktx2(input, file, file_size) : pack_png(input, file, file_size);
+    free(file);
+    if (!result) fprintf(stderr, "%s is not a texture the packer can read\n", path);
+    return result;
+}
+
+int main(int const argc, char **const argv) {
+    if (argc < 3) return usage();
+    uint32_t const input_count = (uint32_t)argc - 2;
+    Input *const inputs = calloc(input_count, sizeof(Input));
+    for (uint32_t i = 0; i < input_count; ++i) {
+        if (!read_input(&inputs[i], argv[i + 2])) return 1;
+        for (uint32_t j = 0; j < i; ++j)
+            if (inputs[j].entry.type == inputs[i].entry.type && !strcmp(inputs[j].entry.name, inputs[i].entry.name)) {
+                fprintf(stderr, "%s: there already is an entry named %s\n", argv[i + 2], inputs[i].entry.name);
+                return 1;
+            }
+    }
+
+    size_t size = align(sizeof(PackHeader) + input_count * sizeof(PackEntry), PACK_ALIGNMENT);
+    for (uint32_t i = 0; i < input_count; ++i) {
+        inputs[i].entry.offset = size;
+        size = align(size + inputs[i].entry.size, PACK_ALIGNMENT);
+    }
+    uint8_t *const pack = calloc(1, size);
+    memcpy(pack, &(PackHeader){.magic = PACK_MAGIC, .version = PACK_VERSION, .entry_count = input_count},
+           sizeof(PackHeader));
+    for (uint32_t i = 0; i < input_count; ++i) {
+        memcpy(pack + sizeof(PackHeader) + i * sizeof(PackEntry), &inputs[i].entry, sizeof(PackEntry));
+        memcpy(pack + inputs[i].entry.offset, inputs[i].data, inputs[i].entry.size);
+    }
+
+    char const *const output = argv[1];
+    FILE *const file = fopen(output, "wb");
+    if (!file || fwrite(pack, 1, size, file) != size || fclose(file)) {
+        fprintf(stderr, "failed to write %s\n", output);
+        return 1;
+    }
+    printf("%s: %u entries, %zu bytes\n", output, input_count, size);
+    return 0;
+}
@@ -0,0 +1,903 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "chunk.h"
+#include "culling.h"
+#include "jobs.h"
+#include "light.h"
+#include "mesher.h"
+#include "region.h"
+
+// cpu microbenchmarks for the engine modules that do not need a gpu
+// every benchmark prints one line per case, run with a module name to only run that module
+
+static uint64_t get_time_ns() {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)((double)counter.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (uint64_t)time.tv_sec * 1000000000ull + (uint64_t)time.tv_nsec;
+#endif
+}
+
+static uint32_t random_state = 0x12345678;
+
+static uint32_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+// keeps results alive so the compiler cannot drop the measured loops
+static volatile uint64_t sink;
+
+static void report(char const *const name, uint64_t const operations, uint64_t const elapsed_ns) {
+    printf("%-40s %8.2f ns/op %10.1f Mop/s\n", name, (double)elapsed_ns / (double)operations,
+           (double)operations * 1e3 / (double)elapsed_ns);
+}
+
+static void fail_check(char const *const check, uint64_t const expected, uint64_t const actual) {
+    fprintf(stderr, "%s: expected %llu, got %llu\n", check, (unsigned long long)expected, (unsigned long long)actual);
+    exit(1);
+}
+
+// a chunk holding block_type_count distinct blocks spread over every voxel
+static void fill_chunk_with_types(Chunk *const chunk, uint32_t const block_type_count) {
+    chunk_init(chunk, 0, 0, 0, 1);
+    for (uint32_t i = 0; i < CHUNK_VOLUME; ++i)
+        chunk_set_block(chunk, i & (CHUNK_SIZE - 1), i >> CHUNK_SIZE_LOG2 * 2, i >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1),
+                        (BlockId)(1 + next_random() % block_type_count));
+}
+
+static void check_chunk_matches(char const *const check, Chunk const *const chunk, BlockId const *const reference) {
+    for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) {
+        auto const block = chunk_get_block(chunk, i & (CHUNK_SIZE - 1), i >> CHUNK_SIZE_LOG2 * 2,
+                                           i >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1));
+        if (block != reference[i]) fail_check(check, reference[i], block);
+    }
+}
+
+// sets, fills and compaction against a plain array, the indices have to widen through every width on the way
+static void check_chunks() {
+    BlockId *const reference = calloc(CHUNK_VOLUME, sizeof(BlockId));
+    Chunk chunk;
+    chunk_init(&chunk, 0, 0, 0, BLOCK_AIR);
+    if (chunk.bits_per_index) fail_check("single block chunk bits per index", 0, chunk.bits_per_index);
+
+    // block n lands on its own voxel, so air and n blocks are all in use and no palette entry can be reused
+    for (uint32_t n = 1; n <= 1000; ++n) {
+        uint32_t const voxel = n * 37 & (CHUNK_VOLUME - 1);
+        chunk_set_block(&chunk, voxel & (CHUNK_SIZE - 1), voxel >> CHUNK_SIZE_LOG2 * 2,
+                        voxel >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1), (BlockId)n);
+        reference[voxel] = (BlockId)n;
+        uint32_t bits = 1;
+        while (1u << bits < n + 1) bits *= 2;
+        if (chunk.bits_per_index != bits) fail_check("bits per index while widening", bits, chunk.bits_per_index);
+    }
+    check_chunk_matches("chunk get after widening", &chunk, reference);
+
+    for (uint32_t i = 0; i < 1u << 16; ++i) {
+        uint32_t const voxel = next_random() & (CHUNK_VOLUME - 1);
+        auto const block = (BlockId)(next_random() % 24);
+        chunk_set_block(&chunk, voxel & (CHUNK_SIZE - 1), voxel >> CHUNK_SIZE_LOG2 * 2,
+                        voxel >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1), block);
+        reference[voxel] = block;
+    }
+    check_chunk_matches("chunk get after random sets", &chunk, reference);
+
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t min[3], max[3];
+        for (uint32_t axis = 0; axis < 3; ++axis) {
+            min[axis] = next_random() % CHUNK_SIZE;
+            max[axis] = min[axis] + 1 + next_random() % (CHUNK_SIZE - min[axis]);
+        }
+        auto const block = (BlockId)(next_random() % 24);
+        chunk_fill(&chunk, min, max, block);
+        for (uint32_t y = min[1]; y < max[1]; ++y)
+            for (uint32_t z = min[2]; z < max[2]; ++z)
+                for (uint32_t x = min[0]; x < max[0]; ++x) reference[chunk_voxel_index(x, y, z)] = block;
+    }
+    check_chunk_matches("chunk get after random fills", &chunk, reference);
+
+    // two blocks left out of the 1001 the palette held, compaction narrows the indices to one bit
+    chunk_fill(&chunk, (uint32_t[]){0, 0, 0}, (uint32_t[]){CHUNK_SIZE, CHUNK_SIZE / 2, CHUNK_SIZE}, 5);
+    chunk_fill(&chunk, (uint32_t[]){0, CHUNK_SIZE / 2, 0}, (uint32_t[]){CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE}, 7);
+    for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) reference[i] = i >> CHUNK_SIZE_LOG2 * 2 < CHUNK_SIZE / 2 ? 5 : 7;
+    chunk_compact(&chunk);
+    if (chunk.bits_per_index != 1) fail_check("bits per index after compaction", 1, chunk.bits_per_index);
+    if (chunk.palette_count != 2) fail_check("palette entries after compaction", 2, chunk.palette_count);
+    check_chunk_matches("chunk get after compaction", &chunk, reference);
+
+    chunk_free(&chunk);
+    free(reference);
+}
+
+static void benchmark_chunks() {
+    check_chunks();
+
+    constexpr uint32_t ROUNDS = 64;
+    constexpr uint32_t RANDOM_OPERATIONS = 1u << 22;
+    static uint32_t const block_type_counts[] = {1, 2, 16, 200, 1000};
+
+    uint32_t *const random_coordinates = malloc(RANDOM_OPERATIONS * sizeof(uint32_t));
+    for (uint32_t i = 0; i < RANDOM_OPERATIONS; ++i) random_coordinates[i] = next_random() & (CHUNK_VOLUME - 1);
+
+    for (uint32_t t = 0; t < sizeof(block_type_counts) / sizeof(block_type_counts[0]); ++t) {
+        uint32_t const block_type_count = block_type_counts[t];
+        Chunk chunk;
+        fill_chunk_with_types(&chunk, block_type_count);
+        char name[64];
+
+        uint64_t sum = 0;
+        auto start = get_time_ns();
+        for (uint32_t round = 0; round < ROUNDS; ++round)
+            for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+                for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+                    for (uint32_t x = 0; x < CHUNK_SIZE; ++x) sum += chunk_get_block(&chunk, x, y, z);
+        snprintf(name, sizeof(name), "chunk get sequential, %u types", block_type_count);
+        report(name, (uint64_t)ROUNDS * CHUNK_VOLUME, get_time_ns() - start);
+
+        start = get_time_ns();
+        for (uint32_t i = 0; i < RANDOM_OPERATIONS; ++i) {
+            uint32_t const index = random_coordinates[i];
+            sum += chunk_get_block(&chunk, index & (CHUNK_SIZE - 1), index >> CHUNK_SIZE_LOG2 * 2,
+                                   index >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1));
+        }
+        snprintf(name, sizeof(name), "chunk get random, %u types", block_type_count);
+        report(name, RANDOM_OPERATIONS, get_time_ns() - start);
+
+        start = get_time_ns();
+        for (uint32_t round = 0; round < ROUNDS; ++round)
+            for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+                for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+                    for (uint32_t x = 0; x < CHUNK_SIZE; ++x)
+                        chunk_set_block(&chunk, x, y, z, (BlockId)(1 + (x + y + z + round) % block_type_count));
+        snprintf(name, sizeof(name), "chunk set sequential, %u types", block_type_count);
+        report(name, (uint64_t)ROUNDS * CHUNK_VOLUME, get_time_ns() - start);
+
+        start = get_time_ns();
+        for (uint32_t i = 0; i < RANDOM_OPERATIONS; ++i) {
+            uint32_t const index = random_coordinates[i];
+            chunk_set_block(&chunk, index & (CHUNK_SIZE - 1), index >> CHUNK_SIZE_LOG2 * 2,
+                            index >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1), (BlockId)(1 + i % block_type_count));
+        }
+        snprintf(name, sizeof(name), "chunk set random, %u types", block_type_count);
+        report(name, RANDOM_OPERATIONS, get_time_ns() - start);
+
+        sink = sum;
+        printf("%-40s %8zu bytes, %u bits per index\n", "chunk memory", chunk_memory_usage(&chunk),
+               chunk.bits_per_index);
+        chunk_free(&chunk);
+    }
+
+    // a half height fill is what terrain generation does most
+    Chunk chunk;
+    chunk_init(&chunk, 0, 0, 0, BLOCK_AIR);
+    auto start = get_time_ns();
+    for (uint32_t round = 0; round < ROUNDS * 16; ++round) {
+        chunk_fill(&chunk, (uint32_t[]){0, 0, 0}, (uint32_t[]){CHUNK_SIZE, CHUNK_SIZE / 2, CHUNK_SIZE},
+                   (BlockId)(1 + round % 4));
+        chunk_fill(&chunk, (uint32_t[]){3, 5, 7}, (uint32_t[]){29, 27, 19}, (BlockId)(5 + round % 4));
+    }
+    report("chunk fill half and box (per voxel)",
+           (uint64_t)ROUNDS * 16 * (CHUNK_VOLUME / 2 + 26 * 22 * 12), get_time_ns() - start);
+    chunk_free(&chunk);
+
+    // a view distance worth of terrain like chunks, then random lookups through the world index
+    World world;
+    world_init(&world);
+    constexpr int32_t RADIUS = 16;
+    start = get_time_ns();
+    for (int32_t z = -RADIUS; z < RADIUS; ++z)
+        for (int32_t x = -RADIUS; x < RADIUS; ++x)
+            for (int32_t y = -2; y < 2; ++y) {
+                auto const created = world_create_chunk(&world, x, y, z);
+                if (y < 0) chunk_fill(created, (uint32_t[]){0, 0, 0},
+                                      (uint32_t[]){CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE}, 1);
+                if (y == 0) {
+                    chunk_fill(created, (uint32_t[]){0, 0, 0}, (uint32_t[]){CHUNK_SIZE, 8, CHUNK_SIZE}, 1);
+                    for (uint32_t i = 0; i < 256; ++i)
+                        chunk_set_block(created, next_random() % CHUNK_SIZE, 8 + next_random() % 8,
+                                        next_random() % CHUNK_SIZE, (BlockId)(2 + next_random() % 6));
+                }
+            }
+    report("world create and generate (per chunk)", world.chunk_count, get_time_ns() - start);
+
+    int32_t const extent = RADIUS * (int32_t)CHUNK_SIZE;
+    uint64_t sum = 0;
+    start = get_time_ns();
+    for (uint32_t i = 0; i < RANDOM_OPERATIONS; ++i)
+        sum += world_get_block(&world, (int32_t)(next_random() % (uint32_t)(extent * 2)) - extent,
+                               (int32_t)(next_random() % (4 * CHUNK_SIZE)) - 2 * (int32_t)CHUNK_SIZE,
+                               (int32_t)(next_random() % (uint32_t)(extent * 2)) - extent);
+    report("world get random", RANDOM_OPERATIONS, get_time_ns() - start);
+    sink = sum;
+
+    auto const usage = world_memory_usage(&world);
+    printf("%-40s %zu chunks, %zu bytes (%zu headers, %zu palettes, %zu indices), %.1f bytes per chunk\n",
+           "world memory", usage.chunk_count, usage.total_bytes, usage.header_bytes, usage.palette_bytes,
+           usage.index_bytes, (double)usage.total_bytes / (double)usage.chunk_count);
+    world_free(&world);
+    free(random_coordinates);
+}
+
+// rolling terrain with stone under dirt under grass, the case the mesher sees most
+static void generate_terrain_chunk(Chunk *const chunk, int32_t const chunk_x, int32_t const chunk_z) {
+    chunk_init(chunk, chunk_x, 0, chunk_z, BLOCK_AIR);
+    for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+        for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+            int32_t const world_x = chunk_x * (int32_t)CHUNK_SIZE + (int32_t)x;
+            int32_t const world_z = chunk_z * (int32_t)CHUNK_SIZE + (int32_t)z;
+            uint32_t const height = 12 + (uint32_t)((world_x * 7 + world_z * 3) / 9 % 6 + (world_x ^ world_z) % 5);
+            chunk_fill(chunk, (uint32_t[]){x, 0, z}, (uint32_t[]){x + 1, height - 3, z + 1}, 1);
+            chunk_fill(chunk, (uint32_t[]){x, height - 3, z}, (uint32_t[]){x + 1, height - 1, z + 1}, 2);
+            chunk_set_block(chunk, x, height - 1, z, 3);
+        }
+}
+
+// faces of non air voxels that face air, a missing neighbor counts as air
+static uint64_t count_visible_faces(Chunk const *const chunk) {
+    static int32_t const directions[CHUNK_FACE_COUNT][3] = {{-1, 0, 0}, {1, 0, 0}, {0, -1, 0},
+                                                            {0, 1, 0},  {0, 0, -1}, {0, 0, 1}};
+    uint64_t face_count = 0;
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+        for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+            for (uint32_t x = 0; x < CHUNK_SIZE; ++x) {
+                if (chunk_get_block(chunk, x, y, z) == BLOCK_AIR) continue;
+                for (uint32_t face = 0; face < CHUNK_FACE_COUNT; ++face) {
+                    uint32_t const nx = x + (uint32_t)directions[face][0], ny = y + (uint32_t)directions[face][1],
+                                   nz = z + (uint32_t)directions[face][2];
+                    if (nx >= CHUNK_SIZE || ny >= CHUNK_SIZE || nz >= CHUNK_SIZE ||
+                        chunk_get_block(chunk, nx, ny, nz) == BLOCK_AIR)
+                        ++face_count;
+                }
+            }
+    return face_count;
+}
+
+// the voxel faces the quads of a mesh cover, from the extent of the 4 corners of every quad
+static uint64_t mesh_face_area(ChunkMesh const *const mesh) {
+    constexpr uint32_t POSITION_MASK = (1u << MESH_VERTEX_POSITION_BITS) - 1;
+    uint64_t area = 0;
+    for (uint32_t quad = 0; quad < mesh->vertex_count / 4; ++quad) {
+        uint32_t min[3] = {UINT32_MAX, UINT32_MAX, UINT32_MAX}, max[3] = {};
+        for (uint32_t corner = 0; corner < 4; ++corner)
+            for (uint32_t axis = 0; axis < 3; ++axis) {
+                uint32_t const position =
+                    (uint32_t)(mesh->vertices[quad * 4 + corner] >> MESH_VERTEX_POSITION_BITS * axis) & POSITION_MASK;
+                if (position < min[axis]) min[axis] = position;
+                if (position > max[axis]) max[axis] = position;
+            }
+        uint64_t quad_area = 1;
+        for (uint32_t axis = 0; axis < 3; ++axis)
+            if (max[axis] > min[axis]) quad_area *= max[axis] - min[axis];
+        area += quad_area;
+    }
+    return area;
+}
+
+// the greedy quads, the naive quads and the section quads all have to cover exactly the visible faces
+static void check_mesher(Chunk const *const chunks, uint32_t const chunk_count, MesherScratch *const scratch) {
+    ChunkMesh mesh = {};
+    ChunkMesh sections[CHUNK_SECTION_COUNT] = {};
+    for (uint32_t i = 0; i < chunk_count; ++i) {
+        auto const face_count = count_visible_faces(&chunks[i]);
+        mesh_chunk(scratch, &chunks[i], nullptr, &mesh);
+        if (mesh_face_area(&mesh) != face_count) fail_check("greedy mesh face area", face_count, mesh_face_area(&mesh));
+        mesh_chunk_naive(scratch, &chunks[i], nullptr, &mesh);
+        if (mesh.vertex_count / 4 != face_count) fail_check("naive mesh quads", face_count, mesh.vertex_count / 4);
+        mesh_chunk_sections(scratch, &chunks[i], nullptr, CHUNK_ALL_SECTIONS, sections);
+        uint64_t section_area = 0;
+        for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section)
+            section_area += mesh_face_area(&sections[section]);
+        if (section_area != face_count) fail_check("section mesh face area", face_count, section_area);
+    }
+    chunk_mesh_free(&mesh);
+    for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section) chunk_mesh_free(&sections[section]);
+}
+
+static void benchmark_mesher_case(char const *const name, Chunk const *const chunks, uint32_t const chunk_count,
+                                  MesherScratch *const scratch, ChunkMesh *const mesh,
+                                  void (*const mesh_function)(MesherScratch *, Chunk const *, Chunk const *const[],
+                                                              ChunkMesh *)) {
+    constexpr uint32_t ROUNDS = 8;
+    uint64_t triangle_count = 0;
+    uint64_t vertex_bytes = 0;
+    auto const start = get_time_ns();
+    for (uint32_t round = 0; round < ROUNDS; ++round)
+        for (uint32_t i = 0; i < chunk_count; ++i) {
+            mesh_function(scratch, &chunks[i], nullptr, mesh);
+            triangle_count += mesh->index_count / 3;
+            vertex_bytes += mesh->vertex_count * sizeof(MeshVertex);
+        }
+    auto const elapsed = get_time_ns() - start;
+    uint64_t const meshed_count = (uint64_t)ROUNDS * chunk_count;
+    printf("%-40s %8.2f us/chunk %8.0f chunks/s %8.0f triangles/chunk %8.0f vertex bytes/chunk\n", name,
+           (double)elapsed / 1e3 / (double)meshed_count, (double)meshed_count * 1e9 / (double)elapsed,
+           (double)triangle_count / (double)meshed_count, (double)vertex_bytes / (double)meshed_count);
+}
+
+// what an edit costs, only the sections in the mask are meshed again
+static void benchmark_section_case(char const *const name, Chunk const *const chunks, uint32_t const chunk_count,
+                                   MesherScratch *const scratch, uint32_t const sections) {
+    constexpr uint32_t ROUNDS = 8;
+    ChunkMesh meshes[CHUNK_SECTION_COUNT] = {};
+    uint64_t triangle_count = 0;
+    uint64_t vertex_bytes = 0;
+    auto const start = get_time_ns();
+    for (uint32_t round = 0; round < ROUNDS; ++round)
+        for (uint32_t i = 0; i < chunk_count; ++i) {
+            mesh_chunk_sections(scratch, &chunks[i], nullptr, sections, meshes);
+            for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section) {
+                if (!(sections >> section & 1)) continue;
+                triangle_count += meshes[section].index_count / 3;
+                vertex_bytes += meshes[section].vertex_count * sizeof(MeshVertex);
+            }
+        }
+    auto const elapsed = get_time_ns() - start;
+    uint64_t const meshed_count = (uint64_t)ROUNDS * chunk_count;
+    printf("%-40s %8.2f us/chunk %8.0f chunks/s %8.0f triangles/chunk %8.0f vertex bytes/chunk\n", name,
+           (double)elapsed / 1e3 / (double)meshed_count, (double)meshed_count * 1e9 / (double)elapsed,
+           (double)triangle_count / (double)meshed_count, (double)vertex_bytes / (double)meshed_count);
+    for (uint32_t section = 0; section < CHUNK_SECTION_COUNT; ++section) chunk_mesh_free(&meshes[section]);
+}
+
+static void benchmark_mesher() {
+    constexpr uint32_t CHUNK_COUNT = 64;
+    Chunk *const terrain = malloc(CHUNK_COUNT * sizeof(Chunk));
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) generate_terrain_chunk(&terrain[i], (int32_t)(i % 8), (int32_t)(i / 8));
+
+    // half the voxels solid at random, close to the worst case for both meshers
+    Chunk *const noise = malloc(CHUNK_COUNT / 4 * sizeof(Chunk));
+    for (uint32_t i = 0; i < CHUNK_COUNT / 4; ++i) {
+        chunk_init(&noise[i], 0, 0, 0, BLOCK_AIR);
+        for (uint32_t voxel = 0; voxel < CHUNK_VOLUME; ++voxel)
+            if (next_random() & 1)
+                chunk_set_block(&noise[i], voxel & (CHUNK_SIZE - 1), voxel >> CHUNK_SIZE_LOG2 * 2,
+                                voxel >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1), (BlockId)(1 + next_random() % 4));
+    }
+
+    MesherScratch *const scratch = malloc(sizeof(MesherScratch));
+    check_mesher(terrain, CHUNK_COUNT, scratch);
+    check_mesher(noise, CHUNK_COUNT / 4, scratch);
+    // every other voxel solid, nothing can merge
+    Chunk checkerboard;
+    chunk_init(&checkerboard, 0, 0, 0, BLOCK_AIR);
+    for (uint32_t y = 0; y < CHUNK_SIZE; ++y)
+        for (uint32_t z = 0; z < CHUNK_SIZE; ++z)
+            for (uint32_t x = (y + z) & 1; x < CHUNK_SIZE; x += 2) chunk_set_block(&checkerboard, x, y, z, 1);
+    check_mesher(&checkerboard, 1, scratch);
+    chunk_free(&checkerboard);
+
+    ChunkMesh mesh = {};
+    benchmark_mesher_case("greedy mesher, terrain", terrain, CHUNK_COUNT, scratch, &mesh, mesh_chunk);
+    benchmark_mesher_case("naive mesher, terrain", terrain, CHUNK_COUNT, scratch, &mesh, mesh_chunk_naive);
+    benchmark_mesher_case("greedy mesher, random half solid", noise, CHUNK_COUNT / 4, scratch, &mesh, mesh_chunk);
+    benchmark_mesher_case("naive mesher, random half solid", noise, CHUNK_COUNT / 4, scratch, &mesh,
+                          mesh_chunk_naive);
+    benchmark_section_case("greedy mesher, terrain by section", terrain, CHUNK_COUNT, scratch, CHUNK_ALL_SECTIONS);
+    // the section the terrain surface runs through, where most edits land
+    benchmark_section_case("greedy mesher, terrain one section", terrain, CHUNK_COUNT, scratch, 1u << 1);
+
+    chunk_mesh_free(&mesh);
+    free(scratch);
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) chunk_free(&terrain[i]);
+    for (uint32_t i = 0; i < CHUNK_COUNT / 4; ++i) chunk_free(&noise[i]);
+    free(terrain);
+    free(noise);
+}
+
+// a camera looking along +z with a 90 degree field of view, planes are left right bottom top near far
+static void camera_planes(float const eye[3], float const far, float planes[6][4]) {
+    float const normals[6][3] = {{1, 0, 1}, {-1, 0, 1}, {0, 1, 1}, {0, -1, 1}, {0, 0, 1}, {0, 0, -1}};
+    for (uint32_t i = 0; i < 6; ++i) {
+        for (uint32_t axis = 0; axis < 3; ++axis) planes[i][axis] = normals[i][axis];
+        planes[i][3] = -(normals[i][0] * eye[0] + normals[i][1] * eye[1] + normals[i][2] * eye[2]);
+    }
+    planes[5][3] += far;
+}
+
+static void benchmark_culling_walk(char const *const name, VisibilityGrid *const grid, float const eye[3],
+                                   float const planes[6][4], uint32_t *const visible_cells) {
+    constexpr uint32_t ROUNDS = 64;
+    uint32_t visible_count = 0;
+    auto const start = get_time_ns();
+    for (uint32_t round = 0; round < ROUNDS; ++round)
+        visible_count = visibility_grid_cull(grid, eye, planes, visible_cells);
+    auto const elapsed = get_time_ns() - start;
+    auto const frustum_count = cull_frustum(&grid->boxes, planes, grid->visible_mask);
+    printf("%-40s %8.2f us/walk %8u in frustum %8u visible of %u cells\n", name, (double)elapsed / 1e3 / ROUNDS,
+           frustum_count, visible_count, grid->cell_count);
+}
+
+static void benchmark_culling() {
+    constexpr uint32_t ROUNDS = 64;
+    constexpr uint32_t CHUNK_COUNT = 64;
+    // 131072 cells, 1 km in every horizontal direction from the camera and 512 m up and down
+    uint32_t const size[3] = {64, 32, 64};
+    VisibilityGrid grid;
+    visibility_grid_init(&grid, (int32_t[]){-32, -16, -32}, size);
+    float planes[6][4];
+    float const eye[3] = {0.5f, 8.5f, 0.5f};
+    camera_planes(eye, 1024.0f, planes);
+
+    uint8_t *const visible_masks[CULL_SIMD_COUNT] = {
+        malloc(grid.boxes.capacity / CULL_BATCH_SIZE),
+        malloc(grid.boxes.capacity / CULL_BATCH_SIZE),
+        malloc(grid.boxes.capacity / CULL_BATCH_SIZE),
+    };
+    for (CullSimd simd = CULL_SIMD_SCALAR; simd <= cull_simd_supported(); ++simd) {
+        uint32_t visible_count = 0;
+        auto const start = get_time_ns();
+        for (uint32_t round = 0; round < ROUNDS; ++round)
+            visible_count = cull_frustum_with(simd, &grid.boxes, planes, visible_masks[simd]);
+        auto const elapsed = get_time_ns() - start;
+        sink = visible_count;
+        if (memcmp(visible_masks[simd], visible_masks[CULL_SIMD_SCALAR], grid.boxes.capacity / CULL_BATCH_SIZE)) {
+            fprintf(stderr, "%s frustum test disagrees with the scalar one\n", cull_simd_name(simd));
+            exit(1);
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "frustum, %u boxes, %s", grid.boxes.count, cull_simd_name(simd));
+        report(name, (uint64_t)ROUNDS * grid.boxes.count, elapsed);
+    }
+    for (uint32_t i = 0; i < CULL_SIMD_COUNT; ++i) free(visible_masks[i]);
+
+    // flood fills of the air, terrain has one large open region and noise has thousands of small ones
+    ConnectivityScratch *const scratch = malloc(sizeof(ConnectivityScratch));
+    Chunk *const chunks = malloc(CHUNK_COUNT * sizeof(Chunk));
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) generate_terrain_chunk(&chunks[i], (int32_t)(i % 8), (int32_t)(i / 8));
+    auto start = get_time_ns();
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) sink = chunk_connectivity(scratch, &chunks[i]);
+    printf("%-40s %8.2f us/chunk\n", "connectivity, terrain", (double)(get_time_ns() - start) / 1e3 / CHUNK_COUNT);
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) {
+        chunk_free(&chunks[i]);
+        chunk_init(&chunks[i], 0, 0, 0, BLOCK_AIR);
+        for (uint32_t voxel = 0; voxel < CHUNK_VOLUME; ++voxel)
+            if (next_random() & 1)
+                chunk_set_block(&chunks[i], voxel & (CHUNK_SIZE - 1), voxel >> CHUNK_SIZE_LOG2 * 2,
+                                voxel >> CHUNK_SIZE_LOG2 & (CHUNK_SIZE - 1), 1);
+    }
+    start = get_time_ns();
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) sink = chunk_connectivity(scratch, &chunks[i]);
+    printf("%-40s %8.2f us/chunk\n", "connectivity, random half solid",
+           (double)(get_time_ns() - start) / 1e3 / CHUNK_COUNT);
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) chunk_free(&chunks[i]);
+    free(chunks);
+    free(scratch);
+
+    // above ground nothing hides anything, the walk only costs
+    uint32_t *const visible_cells = malloc(grid.cell_count * sizeof(uint32_t));
+    benchmark_culling_walk("walk, open air", &grid, eye, planes, visible_cells);
+    // solid rock with a tenth of the cells holding a cave, the case occlusion culling is for
+    for (uint32_t i = 0; i < grid.cell_count; ++i)
+        grid.connectivity[i] = next_random() % 10 ? 0 : (ChunkConnectivity)(next_random() & CHUNK_FULLY_CONNECTED);
+    grid.connectivity[visibility_grid_cell(&grid, 0, 0, 0)] = CHUNK_FULLY_CONNECTED;
+    benchmark_culling_walk("walk, caves", &grid, eye, planes, visible_cells);
+    // rock below the surface layer and open air above it, looking along the ground
+    for (uint32_t i = 0; i < grid.cell_count; ++i)
+        grid.connectivity[i] = i / (size[0] * size[2]) < size[1] / 2 ? 0 : CHUNK_FULLY_CONNECTED;
+    benchmark_culling_walk("walk, surface", &grid, eye, planes, visible_cells);
+
+    free(visible_cells);
+    visibility_grid_free(&grid);
+}
+
+static void count_job(void *const data) { atomic_fetch_add_explicit((atomic_uint *)data, 1, memory_order_relaxed); }
+
+typedef struct {
+    JobSystem *jobs;
+    JobCounter *counter;
+    atomic_uint *total;
+    uint32_t depth;
+} SpawnTask;
+
+constexpr uint32_t SPAWN_FANOUT = 4;
+
+// every level submits its children from inside a job, so workers push to their own deques while others steal
+static void spawn_job(void *const data) {
+    SpawnTask *const task = data;
+    atomic_fetch_add_explicit(task->total, 1, memory_order_relaxed);
+    if (task->depth) {
+        Job children[SPAWN_FANOUT];
+        for (uint32_t i = 0; i < SPAWN_FANOUT; ++i) {
+            SpawnTask *const child = malloc(sizeof(SpawnTask));
+            *child = *task;
+            --child->depth;
+            children[i] = (Job){.function = spawn_job, .data = child};
+        }
+        // raised before this job finishes, so the counter cannot reach zero in between
+        job_system_submit(task->jobs, children, SPAWN_FANOUT, task->counter);
+    }
+    free(task);
+}
+
+typedef struct {
+    JobSystem *jobs;
+    uint32_t *progress;
+    uint32_t *main_callback_count;
+    uint32_t link;
+} ChainLink;
+
+constexpr uint32_t CHAIN_COUNT = 256;
+constexpr uint32_t CHAIN_LENGTH = 16;
+
+static void count_main_callback(void *const data) { ++*(uint32_t *)data; }
+
+// a link may only run after the one before it finished, each checks its chain has progressed exactly that far
+static void chain_job(void *const data) {
+    ChainLink const *const link = data;
+    if (*link->progress != link->link) fail_check("chain link order", link->link, *link->progress);
+    *link->progress = link->link + 1;
+    if (link->link == CHAIN_LENGTH - 1)
+        job_system_defer_to_main(link->jobs, count_main_callback, link->main_callback_count);
+}
+
+static void stress_test_jobs(uint32_t const thread_count) {
+    constexpr uint32_t ROUNDS = 8;
+    constexpr uint32_t TINY_JOB_COUNT = 1u << 16;
+    constexpr uint32_t BATCH_SIZE = 512;
+    constexpr uint32_t SPAWN_DEPTH = 6;
+
+    auto const jobs = job_system_create(thread_count);
+    Job *const batch = malloc(BATCH_SIZE * sizeof(Job));
+    ChainLink *const links = malloc(CHAIN_COUNT * CHAIN_LENGTH * sizeof(ChainLink));
+    JobCounter *const link_counters = malloc(CHAIN_COUNT * CHAIN_LENGTH * sizeof(JobCounter));
+    uint32_t *const progress = malloc(CHAIN_COUNT * sizeof(uint32_t));
+
+    uint64_t job_count = 0;
+    auto const start = get_time_ns();
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        // many tiny jobs in batches, more in total than a deque holds
+        atomic_uint total = 0;
+        JobCounter counter = {};
+        for (uint32_t i = 0; i < BATCH_SIZE; ++i) batch[i] = (Job){.function = count_job, .data = &total};
+        for (uint32_t i = 0; i < TINY_JOB_COUNT; i += BATCH_SIZE) job_system_submit(jobs, batch, BATCH_SIZE, &counter);
+        job_system_wait(jobs, &counter);
+        if (atomic_load(&total) != TINY_JOB_COUNT) fail_check("tiny jobs", TINY_JOB_COUNT, atomic_load(&total));
+        job_count += TINY_JOB_COUNT;
+
+        // a tree of jobs submitting jobs
+        atomic_store(&total, 0);
+        SpawnTask *const root = malloc(sizeof(SpawnTask));
+        *root = (SpawnTask){.jobs = jobs, .counter = &counter, .total = &total, .depth = SPAWN_DEPTH};
+        job_system_submit(jobs, &(Job){.function = spawn_job, .data = root}, 1, &counter);
+        job_system_wait(jobs, &counter);
+        uint32_t spawn_count = 0;
+        for (uint32_t level = 0, width = 1; level <= SPAWN_DEPTH; ++level, width *= SPAWN_FANOUT) spawn_count += width;
+        if (atomic_load(&total) != spawn_count) fail_check("spawned jobs", spawn_count, atomic_load(&total));
+        job_count += spawn_count;
+
+        // chains of dependent jobs, every link is submitted up front behind the counter of the link before it and the
+        // last one finishes on the main thread
+        uint32_t main_callback_count = 0;
+        for (uint32_t chain = 0; chain < CHAIN_COUNT; ++chain) {
+            progress[chain] = 0;
+            for (uint32_t link = 0; link < CHAIN_LENGTH; ++link) {
+                uint32_t const index = chain * CHAIN_LENGTH + link;
+                links[index] = (ChainLink){
+                    .jobs = jobs,
+                    .progress = &progress[chain],
+                    .main_callback_count = &main_callback_count,
+                    .link = link,
+                };
+                link_counters[index] = (JobCounter){};
+                Job const job = {.function = chain_job, .data = &links[index]};
+                if (link) job_system_submit_after(jobs, &link_counters[index - 1], &job, 1, &link_counters[index]);
+                else job_system_submit(jobs, &job, 1, &link_counters[index]);
+            }
+        }
+        for (uint32_t chain = 0; chain < CHAIN_COUNT; ++chain)
+            job_system_wait(jobs, &link_counters[chain * CHAIN_LENGTH + CHAIN_LENGTH - 1]);
+        for (uint32_t chain = 0; chain < CHAIN_COUNT; ++chain)
+            if (progress[chain] != CHAIN_LENGTH) fail_check("chain length", CHAIN_LENGTH, progress[chain]);
+        job_system_run_main_callbacks(jobs);
+        if (main_callback_count != CHAIN_COUNT) fail_check("main thread callbacks", CHAIN_COUNT, main_callback_count);
+        job_count += CHAIN_COUNT * CHAIN_LENGTH;
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "job stress test, %u threads", thread_count);
+    report(name, job_count, get_time_ns() - start);
+
+    free(progress);
+    free(link_counters);
+    free(links);
+    free(batch);
+    job_system_destroy(jobs);
+}
+
+typedef struct {
+    JobSystem *jobs;
+    MesherScratch *scratches;
+    Chunk chunk;
+    ChunkMesh mesh;
+    int32_t x;
+    int32_t z;
+} PipelineChunk;
+
+static void generate_chunk_job(void *const data) {
+    PipelineChunk *const chunk = data;
+    generate_terrain_chunk(&chunk->chunk, chunk->x, chunk->z);
+}
+
+static void mesh_chunk_job(void *const data) {
+    PipelineChunk *const chunk = data;
+    mesh_chunk(&chunk->scratches[job_system_worker_index(chunk->jobs)], &chunk->chunk, nullptr, &chunk->mesh);
+}
+
+// generating then meshing a batch of chunks, every mesh job depends on its own generate job
+static void benchmark_job_scaling(uint32_t const thread_count) {
+    constexpr uint32_t ROUNDS = 4;
+    constexpr uint32_t CHUNK_COUNT = 256;
+
+    auto const jobs = job_system_create(thread_count);
+    MesherScratch *const scratches = malloc(job_system_thread_count(jobs) * sizeof(MesherScratch));
+    PipelineChunk *const chunks = calloc(CHUNK_COUNT, sizeof(PipelineChunk));
+    JobCounter *const generated = malloc(CHUNK_COUNT * sizeof(JobCounter));
+
+    uint64_t triangle_count = 0;
+    auto const start = get_time_ns();
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        JobCounter meshed = {};
+        for (uint32_t i = 0; i < CHUNK_COUNT; ++i) {
+            chunks[i].jobs = jobs;
+            chunks[i].scratches = scratches;
+            chunks[i].x = (int32_t)(i % 16);
+            chunks[i].z = (int32_t)(i / 16 + round * 16);
+            generated[i] = (JobCounter){};
+            job_system_submit(jobs, &(Job){.function = generate_chunk_job, .data = &chunks[i]}, 1, &generated[i]);
+            job_system_submit_after(jobs, &generated[i], &(Job){.function = mesh_chunk_job, .data = &chunks[i]}, 1,
+                                    &meshed);
+        }
+        job_system_wait(jobs, &meshed);
+        for (uint32_t i = 0; i < CHUNK_COUNT; ++i) {
+            triangle_count += chunks[i].mesh.index_count / 3;
+            chunk_free(&chunks[i].chunk);
+        }
+    }
+    auto const elapsed = get_time_ns() - start;
+    sink = triangle_count;
+
+    char name[64];
+    snprintf(name, sizeof(name), "generate and mesh, %u threads", thread_count);
+    uint64_t const chunk_count = (uint64_t)ROUNDS * CHUNK_COUNT;
+    printf("%-40s %8.2f us/chunk %8.0f chunks/s\n", name, (double)elapsed / 1e3 / (double)chunk_count,
+           (double)chunk_count * 1e9 / (double)elapsed);
+
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) chunk_mesh_free(&chunks[i].mesh);
+    free(generated);
+    free(chunks);
+    free(scratches);
+    job_system_destroy(jobs);
+}
+
+static void benchmark_jobs() {
+    uint32_t const hardware_thread_count = job_system_hardware_thread_count();
+    // oversubscribed on small machines so the stealing and sleeping paths still get exercised
+    stress_test_jobs(hardware_thread_count < 4 ? 4 : hardware_thread_count);
+    for (uint32_t thread_count = 1; thread_count <= hardware_thread_count && thread_count <= MAX_JOB_WORKERS;
+         ++thread_count)
+        benchmark_job_scaling(thread_count);
+}
+
+static void report_chunk_rate(char const *const name, uint64_t const chunk_count, uint64_t const elapsed_ns) {
+    printf("%-40s %8.2f us/chunk %8.0f chunks/s\n", name, (double)elapsed_ns / 1e3 / (double)chunk_count,
+           (double)chunk_count * 1e9 / (double)elapsed_ns);
+}
+
+static void remove_region_file(RegionPathChar const *const path) {
+#ifdef _WIN32
+    _wremove(path);
+#else
+    remove(path);
+#endif
+}
+
+// the serialized terrain chunks through the lz codec, then saved into a region file that is reopened and read back
+static void benchmark_region() {
+    constexpr uint32_t CHUNK_COUNT = REGION_SIZE * REGION_SIZE;
+    constexpr uint32_t ROUNDS = 16;
+#ifdef _WIN32
+    RegionPathChar const *const path = L"codoxel_microbench.region";
+#else
+    RegionPathChar const *const path = "codoxel_microbench.region";
+#endif
+
+    Chunk *const chunks = malloc(CHUNK_COUNT * sizeof(Chunk));
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i)
+        generate_terrain_chunk(&chunks[i], (int32_t)(i % REGION_SIZE), (int32_t)(i / REGION_SIZE));
+    RegionScratch *const scratch = malloc(sizeof(RegionScratch));
+    uint8_t *const decoded = malloc(CHUNK_MAX_SERIALIZED_SIZE);
+
+    uint64_t serialized_bytes = 0, compressed_bytes = 0, compress_ns = 0, decompress_ns = 0;
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) {
+        auto const size = chunk_serialized_size(&chunks[i]);
+        chunk_serialize(&chunks[i], scratch->serialized);
+        size_t compressed_size = 0;
+        auto start = get_time_ns();
+        for (uint32_t round = 0; round < ROUNDS; ++round)
+            compressed_size = lz_compress(scratch->serialized, size, scratch->record, sizeof(scratch->record));
+        compress_ns += get_time_ns() - start;
+        bool decoded_ok = true;
+        start = get_time_ns();
+        for (uint32_t round = 0; round < ROUNDS; ++round)
+            decoded_ok &= lz_decompress(scratch->record, compressed_size, decoded, size);
+        decompress_ns += get_time_ns() - start;
+        if (!decoded_ok || memcmp(decoded, scratch->serialized, size)) fail_check("lz round trip", 1, 0);
+        serialized_bytes += size;
+        compressed_bytes += compressed_size;
+    }
+    printf("%-40s %8.0f MB/s %8.2f ratio\n", "lz compress, terrain",
+           (double)serialized_bytes * ROUNDS * 1e3 / (double)compress_ns,
+           (double)serialized_bytes / (double)compressed_bytes);
+    printf("%-40s %8.0f MB/s\n", "lz decompress, terrain",
+           (double)serialized_bytes * ROUNDS * 1e3 / (double)decompress_ns);
+
+    remove_region_file(path);
+    RegionFile *const region = malloc(sizeof(RegionFile));
+    if (!region_open(region, path, 0, 0, 0)) fail_check("region open", 1, 0);
+    // the second round relocates every record, which is the path a world that keeps changing takes
+    for (uint32_t round = 0; round < 2; ++round) {
+        auto const start = get_time_ns();
+        for (uint32_t i = 0; i < CHUNK_COUNT; ++i)
+            if (!region_write_chunk(region, scratch, &chunks[i])) fail_check("region write", 1, 0);
+        report_chunk_rate(round ? "region rewrite" : "region write", CHUNK_COUNT, get_time_ns() - start);
+    }
+    auto const sector_count = region->sector_count;
+    region_close(region);
+
+    if (!region_open(region, path, 0, 0, 0)) fail_check("region reopen", 1, 0);
+    if (region->sector_count != sector_count) fail_check("region sector count", sector_count, region->sector_count);
+    Chunk chunk;
+    uint64_t read_ns = 0;
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) {
+        auto const start = get_time_ns();
+        auto const is_read = region_read_chunk(region, scratch, chunks[i].x, chunks[i].y, chunks[i].z, &chunk);
+        read_ns += get_time_ns() - start;
+        if (!is_read) fail_check("region read", 1, 0);
+        auto const size = chunk_serialized_size(&chunks[i]);
+        chunk_serialize(&chunks[i], decoded);
+        chunk_serialize(&chunk, scratch->serialized);
+        if (chunk_serialized_size(&chunk) != size || memcmp(decoded, scratch->serialized, size))
+            fail_check("region contents", 1, 0);
+        chunk_free(&chunk);
+    }
+    report_chunk_rate("region read", CHUNK_COUNT, read_ns);
+    printf("%-40s %8u sectors %8.0f bytes/chunk\n", "region file size", sector_count,
+           (double)sector_count * REGION_SECTOR_SIZE / CHUNK_COUNT);
+    region_close(region);
+    remove_region_file(path);
+
+    free(region);
+    free(decoded);
+    free(scratch);
+    for (uint32_t i = 0; i < CHUNK_COUNT; ++i) chunk_free(&chunks[i]);
+    free(chunks);
+}
+
+// the terrain with a lamp on a post here and there, so both channels have work
+static void generate_lit_world(World *const world, uint32_t const size) {
+    world_init(world);
+    for (uint32_t i = 0; i < size * size; ++i) {
+        auto const chunk = world_create_chunk(world, (int32_t)(i % size), 0, (int32_t)(i / size));
+        chunk_free(chunk);
+        generate_terrain_chunk(chunk, (int32_t)(i % size), (int32_t)(i / size));
+        for (uint32_t lamp = 0; lamp < 4; ++lamp)
+            chunk_set_block(chunk, next_random() % CHUNK_SIZE, 24 + next_random() % 4, next_random() % CHUNK_SIZE,
+                            BLOCK_LAMP);
+    }
+}
+
+static void run_light_batch(LightBatch *const batch, JobSystem *const jobs) {
+    JobCounter lit = {};
+    light_batch_submit(batch, jobs, nullptr, &lit);
+    job_system_wait(jobs, &lit);
+    light_batch_destroy(batch);
+}
+
+// every chunk lit from scratch, then single block edits lit incrementally the way the renderer does after a click
+static void benchmark_light_threads(uint32_t const thread_count) {
+    constexpr uint32_t SIZE = 12;
+    constexpr uint32_t ROUNDS = 4;
+    constexpr uint32_t EDIT_COUNT = 256;
+
+    World world;
+    generate_lit_world(&world, SIZE);
+    auto const jobs = job_system_create(thread_count);
+    LightScratch *const scratches = calloc(job_system_thread_count(jobs), sizeof(LightScratch));
+
+    auto const start = get_time_ns();
+    for (uint32_t round = 0; round < ROUNDS; ++round) {
+        auto const batch = light_batch_create(&world, scratches);
+        for (uint32_t i = 0; i < SIZE * SIZE; ++i)
+            light_batch_add_chunk(batch, world_get_chunk(&world, (int32_t)(i % SIZE), 0, (int32_t)(i / SIZE)));
+        run_light_batch(batch, jobs);
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "light from scratch, %u threads", thread_count);
+    report_chunk_rate(name, (uint64_t)ROUNDS * SIZE * SIZE, get_time_ns() - start);
+
+    uint8_t *const expected = malloc((size_t)SIZE * SIZE * CHUNK_VOLUME);
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i)
+        memcpy(expected + (size_t)i * CHUNK_VOLUME,
+               world_get_chunk(&world, (int32_t)(i % SIZE), 0, (int32_t)(i / SIZE))->light, CHUNK_VOLUME);
+
+    // a lamp placed in the open and taken away again, and a hole dug into the ground and filled again, so the world
+    // ends up as it started and the light has to as well
+    uint64_t edit_ns = 0;
+    uint32_t edit_count = 0;
+    for (uint32_t i = 0; i < EDIT_COUNT; ++i) {
+        int32_t const x = (int32_t)(next_random() % (SIZE * CHUNK_SIZE));
+        int32_t const z = (int32_t)(next_random() % (SIZE * CHUNK_SIZE));
+        int32_t const y = i & 1 ? 20 : 10;
+        auto const old_block = world_get_block(&world, x, y, z);
+        if (old_block == BLOCK_LAMP) continue;
+        BlockId const new_block = i & 1 ? BLOCK_LAMP : BLOCK_AIR;
+        for (uint32_t step = 0; step < 2; ++step) {
+            auto const from = step ? new_block : old_block;
+            auto const to = step ? old_block : new_block;
+            auto const edit_start = get_time_ns();
+            auto const batch = light_batch_create(&world, scratches);
+            world_set_block(&world, x, y, z, to);
+            light_batch_set_block(batch, x, y, z, from);
+            run_light_batch(batch, jobs);
+            edit_ns += get_time_ns() - edit_start;
+            ++edit_count;
+        }
+    }
+    for (uint32_t i = 0; i < SIZE * SIZE; ++i)
+        if (memcmp(expected + (size_t)i * CHUNK_VOLUME,
+                   world_get_chunk(&world, (int32_t)(i % SIZE), 0, (int32_t)(i / SIZE))->light, CHUNK_VOLUME))
+            fail_check("light after undone edits", 0, i);
+    snprintf(name, sizeof(name), "light edit, %u threads", thread_count);
+    printf("%-40s %8.2f us/edit %8.0f edits/s\n", name, (double)edit_ns / 1e3 / edit_count,
+           (double)edit_count * 1e9 / (double)edit_ns);
+
+    free(expected);
+    free(scratches);
+    job_system_destroy(jobs);
+    world_free(&world);
+}
+
+static void benchmark_light() {
+    uint32_t const hardware_thread_count = job_system_hardware_thread_count();
+    benchmark_light_threads(1);
+    if (hardware_thread_count > 1)
+        benchmark_light_threads(hardware_thread_count < MAX_JOB_WORKERS ? hardware_thread_count : MAX_JOB_WORKERS);
+}
+
+typedef struct {
+    char const *name;
+    void (*run)();
+} Benchmark;
+
+static Benchmark const benchmarks[] = {
+    {"chunks", benchmark_chunks},
+    {"mesher", benchmark_mesher},
+    {"jobs", benchmark_jobs},
+    {"culling", benchmark_culling},
+    {"region", benchmark_region},
+    {"light", benchmark_light},
+};
+
+int main(int const argc, char **const argv) {
+    for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i) {
+        if (argc > 1 && strcmp(argv[1], benchmarks[i].name)) continue;
+        printf("%s\n", benchmarks[i].name);
+        benchmarks[i].run();
+    }
+    return 0;
+}
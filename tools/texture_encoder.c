@@ -0,0 +1,408 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ktx2.h"
+#include "png.h"
+
+// offline texture encoder, png in and ktx2 out
+// the mip chain is built with an srgb correct box filter, then every level is block compressed
+// bc7 uses mode 6 only (one subset, rgba endpoints, 4 bit indices), bc1 the opaque four color mode
+
+typedef struct {
+    float v[4];
+} Color;
+
+typedef struct {
+    uint32_t width, height;
+    // premultiplied BGRA8 as the png decoder produces it
+    uint8_t *pixels;
+} Level;
+
+static float srgb_to_linear_table[256];
+
+static float linear_to_srgb(float const value) {
+    float const srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+    return srgb * 255.0f;
+}
+
+static uint8_t to_byte(float const value) {
+    if (value <= 0.0f) return 0;
+    if (value >= 255.0f) return 255;
+    return (uint8_t)(value + 0.5f);
+}
+
+// averages 2x2 texels, the last row or column is repeated when the source size is odd
+static Level downsample(Level const *const source) {
+    Level level = {
+        .width = source->width > 1 ? source->width / 2 : 1,
+        .height = source->height > 1 ? source->height / 2 : 1,
+    };
+    level.pixels = malloc((size_t)level.width * level.height * 4);
+    for (uint32_t y = 0; y < level.height; ++y)
+        for (uint32_t x = 0; x < level.width; ++x) {
+            float sums[4] = {};
+            for (uint32_t i = 0; i < 4; ++i) {
+                uint32_t const source_x = x * 2 + (i & 1) < source->width ? x * 2 + (i & 1) : source->width - 1;
+                uint32_t const source_y = y * 2 + (i >> 1) < source->height ? y * 2 + (i >> 1) : source->height - 1;
+                auto const texel = source->pixels + ((size_t)source_y * source->width + source_x) * 4;
+                for (uint32_t c = 0; c < 3; ++c) sums[c] += srgb_to_linear_table[texel[c]];
+                sums[3] += texel[3];
+            }
+            auto const texel = level.pixels + ((size_t)y * level.width + x) * 4;
+            for (uint32_t c = 0; c < 3; ++c) texel[c] = to_byte(linear_to_srgb(sums[c] / 4.0f));
+            texel[3] = to_byte(sums[3] / 4.0f);
+        }
+    return level;
+}
+
+// the 4x4 block at (block_x, block_y) as RGBA floats, edge texels are repeated for partial blocks
+static void load_block(Level const *const level, uint32_t const block_x, uint32_t const block_y,
+                       Color pixels[16]) {
+    for (uint32_t i = 0; i < 16; ++i) {
+        uint32_t const x = block_x * 4 + i % 4 < level->width ? block_x * 4 + i % 4 : level->width - 1;
+        uint32_t const y = block_y * 4 + i / 4 < level->height ? block_y * 4 + i / 4 : level->height - 1;
+        auto const texel = level->pixels + ((size_t)y * level->width + x) * 4;
+        pixels[i] = (Color){{texel[2], texel[1], texel[0], texel[3]}};
+    }
+}
+
+static float distance_squared(Color const a, Color const b, uint32_t const channels) {
+    float sum = 0.0f;
+    for (uint32_t c = 0; c < channels; ++c) sum += (a.v[c] - b.v[c]) * (a.v[c] - b.v[c]);
+    return sum;
+}
+
+// endpoints along the principal axis of the block, found by power iteration on the covariance
+static void fit_endpoints(Color const pixels[16], uint32_t const channels, Color *const low, Color *const high) {
+    Color mean = {};
+    for (uint32_t i = 0; i < 16; ++i)
+        for (uint32_t c = 0; c < channels; ++c) mean.v[c] += pixels[i].v[c] / 16.0f;
+
+    float covariance[4][4] = {};
+    for (uint32_t i = 0; i < 16; ++i)
+        for (uint32_t a = 0; a < channels; ++a)
+            for (uint32_t b = 0; b < channels; ++b)
+                covariance[a][b] += (pixels[i].v[a] - mean.v[a]) * (pixels[i].v[b] - mean.v[b]);
+
+    Color axis = {{1.0f, 1.0f, 1.0f, 1.0f}};
+    for (uint32_t iteration = 0; iteration < 8; ++iteration) {
+        Color next = {};
+        float length = 0.0f;
+        for (uint32_t a = 0; a < channels; ++a) {
+            for (uint32_t b = 0; b < channels; ++b) next.v[a] += covariance[a][b] * axis.v[b];
+            length += next.v[a] * next.v[a];
+        }
+        if (length < 1e-12f) break;
+        length = sqrtf(length);
+        for (uint32_t c = 0; c < channels; ++c) axis.v[c] = next.v[c] / length;
+    }
+
+    float min_t = 0.0f, max_t = 0.0f;
+    for (uint32_t i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c) t += (pixels[i].v[c] - mean.v[c]) * axis.v[c];
+        if (t < min_t) min_t = t;
+        if (t > max_t) max_t = t;
+    }
+    for (uint32_t c = 0; c < 4; ++c) {
+        low->v[c] = c < channels ? mean.v[c] + min_t * axis.v[c] : 255.0f;
+        high->v[c] = c < channels ? mean.v[c] + max_t * axis.v[c] : 255.0f;
+    }
+}
+
+// least squares endpoints for fixed indices, weights[i] is how far pixel i sits from low towards high
+static bool refine_endpoints(Color const pixels[16], uint32_t const channels, float const weights[16],
+                             Color *const low, Color *const high) {
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    Color x0 = {}, x1 = {};
+    for (uint32_t i = 0; i < 16; ++i) {
+        float const w = weights[i];
+        a += (1.0f - w) * (1.0f - w);
+        b += (1.0f - w) * w;
+        c += w * w;
+        for (uint32_t k = 0; k < channels; ++k) {
+            x0.v[k] += (1.0f - w) * pixels[i].v[k];
+            x1.v[k] += w * pixels[i].v[k];
+        }
+    }
+    float const determinant = a * c - b * b;
+    if (fabsf(determinant) < 1e-6f) return false;
+    for (uint32_t k = 0; k < channels; ++k) {
+        low->v[k] = (c * x0.v[k] - b * x1.v[k]) / determinant;
+        high->v[k] = (a * x1.v[k] - b * x0.v[k]) / determinant;
+    }
+    return true;
+}
+
+// bc1
+
+static uint16_t quantize_565(Color const color) {
+    uint32_t const r = to_byte(color.v[0] * 31.0f / 255.0f);
+    uint32_t const g = to_byte(color.v[1] * 63.0f / 255.0f);
+    uint32_t const b = to_byte(color.v[2] * 31.0f / 255.0f);
+    return (uint16_t)((r > 31 ? 31 : r) << 11 | (g > 63 ? 63 : g) << 5 | (b > 31 ? 31 : b));
+}
+
+static Color expand_565(uint16_t const value) {
+    uint32_t const r = value >> 11, g = value >> 5 & 63, b = value & 31;
+    return (Color){{(float)(r << 3 | r >> 2), (float)(g << 2 | g >> 4), (float)(b << 3 | b >> 2), 255.0f}};
+}
+
+static float encode_bc1_endpoints(Color const pixels[16], Color const low, Color const high, uint8_t block[8],
+                                  float weights[16]) {
+    uint16_t color0 = quantize_565(high), color1 = quantize_565(low);
+    bool const is_swapped = color0 < color1;
+    if (is_swapped) {
+        uint16_t const swap = color0;
+        color0 = color1;
+        color1 = swap;
+    }
+
+    Color palette[4] = {expand_565(color0), expand_565(color1)};
+    for (uint32_t c = 0; c < 3; ++c) {
+        palette[2].v[c] = (2.0f * palette[0].v[c] + palette[1].v[c]) / 3.0f;
+        palette[3].v[c] = (palette[0].v[c] + 2.0f * palette[1].v[c]) / 3.0f;
+    }
+    // equal endpoints select the three color mode, index 0 still decodes to color0 there
+    uint32_t const palette_size = color0 == color1 ? 1 : 4;
+    static float const palette_weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+
+    uint32_t indices = 0;
+    float total_error = 0.0f;
+    for (uint32_t i = 0; i < 16; ++i) {
+        uint32_t best_index = 0;
+        float best_error = distance_squared(pixels[i], palette[0], 3);
+        for (uint32_t j = 1; j < palette_size; ++j) {
+            float const error = distance_squared(pixels[i], palette[j], 3);
+            if (error < best_error) {
+                best_error = error;
+                best_index = j;
+            }
+        }
+        indices |= best_index << i * 2;
+        weights[i] = is_swapped ? 1.0f - palette_weights[best_index] : palette_weights[best_index];
+        total_error += best_error;
+    }
+
+    block[0] = (uint8_t)color0;
+    block[1] = (uint8_t)(color0 >> 8);
+    block[2] = (uint8_t)color1;
+    block[3] = (uint8_t)(color1 >> 8);
+    for (uint32_t i = 0; i < 4; ++i) block[4 + i] = (uint8_t)(indices >> i * 8);
+    return total_error;
+}
+
+static void encode_bc1_block(Color const pixels[16], uint8_t block[8]) {
+    Color low, high;
+    fit_endpoints(pixels, 3, &low, &high);
+    float weights[16];
+    float const error = encode_bc1_endpoints(pixels, low, high, block, weights);
+
+    uint8_t refined[8];
+    if (refine_endpoints(pixels, 3, weights, &low, &high) &&
+        encode_bc1_endpoints(pixels, low, high, refined, weights) < error)
+        memcpy(block, refined, sizeof(refined));
+}
+
+// bc7 mode 6
+
+static uint8_t const bc7_weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+// 7 bit endpoint plus a shared p bit per endpoint, the p bit picked to minimize the endpoint error
+static void quantize_bc7_endpoint(Color const color, uint8_t quantized[4], uint8_t *const p_bit) {
+    float best_error = INFINITY;
+    for (uint8_t p = 0; p < 2; ++p) {
+        uint8_t candidate[4];
+        float error = 0.0f;
+        for (uint32_t c = 0; c < 4; ++c) {
+            float const value = (color.v[c] - p) / 2.0f;
+            candidate[c] = value <= 0.0f ? 0 : value >= 127.0f ? 127 : (uint8_t)(value + 0.5f);
+            float const expanded = (float)(candidate[c] << 1 | p);
+            error += (expanded - color.v[c]) * (expanded - color.v[c]);
+        }
+        if (error < best_error) {
+            best_error = error;
+            memcpy(quantized, candidate, 4);
+            *p_bit = p;
+        }
+    }
+}
+
+typedef struct {
+    uint8_t bytes[16];
+    uint32_t cursor;
+} BitWriter;
+
+static void put_bits(BitWriter *const writer, uint32_t const value, uint32_t const count) {
+    for (uint32_t i = 0; i < count; ++i, ++writer->cursor)
+        writer->bytes[writer->cursor / 8] |= (uint8_t)((value >> i & 1) << writer->cursor % 8);
+}
+
+static float encode_bc7_endpoints(Color const pixels[16], Color const low, Color const high, uint8_t block[16],
+                                  float weights[16]) {
+    uint8_t endpoints[2][4], p_bits[2];
+    quantize_bc7_endpoint(low, endpoints[0], &p_bits[0]);
+    quantize_bc7_endpoint(high, endpoints[1], &p_bits[1]);
+
+    Color palette[16];
+    for (uint32_t i = 0; i < 16; ++i)
+        for (uint32_t c = 0; c < 4; ++c) {
+            uint32_t const e0 = endpoints[0][c] << 1 | p_bits[0], e1 = endpoints[1][c] << 1 | p_bits[1];
+            palette[i].v[c] = (float)(((64 - bc7_weights[i]) * e0 + bc7_weights[i] * e1 + 32) >> 6);
+        }
+
+    uint8_t indices[16];
+    float total_error = 0.0f;
+    for (uint32_t i = 0; i < 16; ++i) {
+        uint8_t best_index = 0;
+        float best_error = INFINITY;
+        for (uint8_t j = 0; j < 16; ++j) {
+            float const error = distance_squared(pixels[i], palette[j], 4);
+            if (error < best_error) {
+                best_error = error;
+                best_index = j;
+            }
+        }
+        indices[i] = best_index;
+        weights[i] = bc7_weights[best_index] / 64.0f;
+        total_error += best_error;
+    }
+
+    // the anchor index has an implicit zero top bit, flipping the endpoints keeps it below 8
+    if (indices[0] >= 8) {
+        for (uint32_t c = 0; c < 4; ++c) {
+            uint8_t const swap = endpoints[0][c];
+            endpoints[0][c] = endpoints[1][c];
+            endpoints[1][c] = swap;
+        }
+        uint8_t const swap = p_bits[0];
+        p_bits[0] = p_bits[1];
+        p_bits[1] = swap;
+        for (uint32_t i = 0; i < 16; ++i) indices[i] = 15 - indices[i];
+    }
+
+    BitWriter writer = {};
+    put_bits(&writer, 1 << 6, 7);
+    for (uint32_t c = 0; c < 4; ++c) {
+        put_bits(&writer, endpoints[0][c], 7);
+        put_bits(&writer, endpoints[1][c], 7);
+    }
+    put_bits(&writer, p_bits[0], 1);
+    put_bits(&writer, p_bits[1], 1);
+    put_bits(&writer, indices[0], 3);
+    for (uint32_t i = 1; i < 16; ++i) put_bits(&writer, indices[i], 4);
+    memcpy(block, writer.bytes, sizeof(writer.bytes));
+    return total_error;
+}
+
+static void encode_bc7_block(Color const pixels[16], uint8_t block[16]) {
+    Color low, high;
+    fit_endpoints(pixels, 4, &low, &high);
+    float weights[16];
+    float const error = encode_bc7_endpoints(pixels, low, high, block, weights);
+
+    uint8_t refined[16];
+    if (refine_endpoints(pixels, 4, weights, &low, &high) &&
+        encode_bc7_endpoints(pixels, low, high, refined, weights) < error)
+        memcpy(block, refined, sizeof(refined));
+}
+
+static void *encode_level(Level const *const level, VkFormat const format) {
+    size_t const size = ktx2_level_size(format, level->width, level->height, 0);
+    uint8_t *const data = malloc(size);
+    if (!ktx2_is_block_compressed(format)) {
+        memcpy(data, level->pixels, size);
+        return data;
+    }
+
+    uint32_t const block_size = ktx2_format_block_size(format);
+    uint32_t const blocks_x = (level->width + 3) / 4, blocks_y = (level->height + 3) / 4;
+    for (uint32_t y = 0; y < blocks_y; ++y)
+        for (uint32_t x = 0; x < blocks_x; ++x) {
+            Color pixels[16];
+            load_block(level, x, y, pixels);
+            auto const block = data + ((size_t)y * blocks_x + x) * block_size;
+            if (format == VK_FORMAT_BC7_SRGB_BLOCK) encode_bc7_block(pixels, block);
+            else encode_bc1_block(pixels, block);
+        }
+    return data;
+}
+
+static void *read_file(char const *const filename, size_t *const size) {
+    FILE *const file = fopen(filename, "rb");
+    if (!file) return nullptr;
+    fseek(file, 0, SEEK_END);
+    *size = (size_t)ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void *const data = malloc(*size);
+    *size = fread(data, 1, *size, file);
+    fclose(file);
+    return data;
+}
+
+static int usage() {
+    fprintf(stderr, "usage: codoxel_texture_encoder [--bc7 | --bc1 | --uncompressed] [--no-mips] input.png "
+            "output.ktx2\n");
+    return 1;
+}
+
+int main(int const argc, char **const argv) {
+    VkFormat format = VK_FORMAT_BC7_SRGB_BLOCK;
+    bool generate_mips = true;
+    char const *input = nullptr, *output = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--bc7")) format = VK_FORMAT_BC7_SRGB_BLOCK;
+        else if (!strcmp(argv[i], "--bc1")) format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        else if (!strcmp(argv[i], "--uncompressed")) format = VK_FORMAT_B8G8R8A8_SRGB;
+        else if (!strcmp(argv[i], "--no-mips")) generate_mips = false;
+        else if (!input) input = argv[i];
+        else if (!output) output = argv[i];
+        else return usage();
+    }
+    if (!input || !output) return usage();
+
+    for (uint32_t i = 0; i < 256; ++i) {
+        float const value = (float)i / 255.0f;
+        srgb_to_linear_table[i] = value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    size_t png_size;
+    void *const png = read_file(input, &png_size);
+    PngInfo info;
+    if (!png || !png_read_info(png, png_size, &info) || info.interlace_method) {
+        fprintf(stderr, "%s is not a png the decoder can read\n", input);
+        return 1;
+    }
+
+    Level levels[KTX2_MAX_LEVELS] = {
+        {.width = info.width, .height = info.height, .pixels = malloc((size_t)info.width * info.height * 4)},
+    };
+    if (!png_decode_bgra(png, png_size, levels[0].pixels)) {
+        fprintf(stderr, "failed to decode %s\n", input);
+        return 1;
+    }
+    free(png);
+
+    uint32_t level_count = 1;
+    while (generate_mips && level_count < KTX2_MAX_LEVELS &&
+           (levels[level_count - 1].width > 1 || levels[level_count - 1].height > 1)) {
+        levels[level_count] = downsample(&levels[level_count - 1]);
+        ++level_count;
+    }
+
+    void const *encoded[KTX2_MAX_LEVELS];
+    for (uint32_t i = 0; i < level_count; ++i) encoded[i] = encode_level(&levels[i], format);
+
+    size_t size;
+    void *const ktx2 = ktx2_write(format, info.width, info.height, level_count, encoded, &size);
+    FILE *const file = fopen(output, "wb");
+    if (!ktx2 || !file || fwrite(ktx2, 1, size, file) != size) {
+        fprintf(stderr, "failed to write %s\n", output);
+        return 1;
+    }
+    fclose(file);
+    printf("%s: %ux%u, %u levels, %zu bytes\n", output, info.width, info.height, level_count, size);
+    return 0;
+}